@@ -0,0 +1,11 @@
+// `count` is both a member of Stats and a file-local variable
+typedef struct {
+    int count;
+} Stats;
+
+static int count;
+
+static void record_a(Stats *s) {
+    count++;
+    s->count++;
+}
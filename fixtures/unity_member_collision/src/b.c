@@ -0,0 +1,13 @@
+#include <stdio.h>
+
+// Collides with a.c's `count`, but must not be renamed: the rename would also
+// rewrite `s.count`. Two uninitialized statics are tentative definitions, so
+// the unity file still compiles as it is.
+static int count;
+
+static void record_b(void) {
+    Stats s = { .count = 0 };
+    record_a(&s);
+    count += s.count;
+    printf("%d\n", count);
+}
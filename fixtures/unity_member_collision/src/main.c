@@ -0,0 +1,4 @@
+int main(void) {
+    record_b();
+    return 0;
+}
@@ -0,0 +1,570 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+#include <jansson.h>
+
+#include "bench_cmd.h"
+#include "build_engine.h"
+#include "project_mgr.h"
+#include "core_utils.h"
+#include "stats_utils.h"
+
+#define DEFAULT_RUNS 10
+#define DEFAULT_WARMUP 2
+#define DEFAULT_REGRESSION_THRESHOLD_PERCENT 5.0
+// The benchmark command finds the target's executable in this environment variable
+#define BENCH_BINARY_ENV "CODA_BENCH_BINARY"
+#define BASELINE_FILE_NAME "baseline.json"
+
+/**
+ * @brief Everything measured per run. Hardware counters come from
+ * perf_event_open() and are skipped when the kernel does not allow them.
+ */
+typedef enum {
+    METRIC_WALL_MS,
+    METRIC_CPU_MS,
+    METRIC_MAX_RSS_KB,
+    METRIC_INSTRUCTIONS,
+    METRIC_CYCLES,
+    METRIC_CACHE_MISSES,
+    METRIC_BRANCH_MISSES,
+    METRIC_COUNT
+} BenchMetric;
+
+#define FIRST_COUNTER_METRIC METRIC_INSTRUCTIONS
+
+static const char *metric_names[METRIC_COUNT] = {
+    "wall_ms", "cpu_ms", "max_rss_kb", "instructions", "cycles", "cache_misses", "branch_misses"
+};
+// Metrics that fail the run when they regress; the rest are informational because they are noisy
+static const int metric_gates[METRIC_COUNT] = { 1, 1, 1, 1, 0, 0, 0 };
+static const unsigned long long counter_configs[METRIC_COUNT] = {
+    0, 0, 0, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+/**
+ * @struct BenchTarget
+ * @brief One declared benchmark: what to build, how to run it, and its samples.
+ */
+typedef struct {
+    char name[128];
+    char *command;               // run through /bin/sh; NULL runs the binary directly
+    char **source_files;         // NULL builds the project's own sources
+    char build_dir[2048];
+    char binary[4096];
+    int failed;
+    int counters_available;
+    int sample_count;
+    double *samples[METRIC_COUNT];
+} BenchTarget;
+
+/**
+ * @struct BenchSettings
+ * @brief The "bench" section of coda.json merged with the command-line options.
+ */
+typedef struct {
+    int runs;
+    int warmup;
+    int cpu;                     // CPU to pin to, or -1
+    double threshold_percent;    // regressions smaller than this are ignored even if significant
+    char **release_flags;
+    char *profile;
+    BenchTarget *targets;
+    int target_count;
+} BenchSettings;
+
+static void free_strings(char **strings) {
+    if (!strings) return;
+    for (int i = 0; strings[i] != NULL; i++) free(strings[i]);
+    free(strings);
+}
+
+// Copies a JSON array of strings into a NULL-terminated list; returns NULL if it is not one
+static char **copy_json_strings(const json_t *array) {
+    if (!json_is_array(array)) return NULL;
+    char **strings = (char **)calloc(json_array_size(array) + 1, sizeof(char *));
+    if (!strings) return NULL;
+    for (size_t i = 0; i < json_array_size(array); i++) {
+        const char *value = json_string_value(json_array_get(array, i));
+        if (!value) {
+            free_strings(strings);
+            return NULL;
+        }
+        strings[i] = strdup(value);
+    }
+    return strings;
+}
+
+static void free_settings(BenchSettings *settings) {
+    for (int i = 0; i < settings->target_count; i++) {
+        free(settings->targets[i].command);
+        free_strings(settings->targets[i].source_files);
+        for (int m = 0; m < METRIC_COUNT; m++) free(settings->targets[i].samples[m]);
+    }
+    free(settings->targets);
+    free_strings(settings->release_flags);
+    free(settings->profile);
+}
+
+// Picks the last CPU this process may run on; the first ones tend to take more interrupts
+static int default_benchmark_cpu() {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return -1;
+    for (int cpu = CPU_SETSIZE - 1; cpu >= 0; cpu--) {
+        if (CPU_ISSET(cpu, &set)) return cpu;
+    }
+    return -1;
+}
+
+/**
+ * @brief Reads the "bench" section of coda.json. Without "targets", the project's
+ * own executable is benchmarked as a single target named after the project.
+ * @return 0 on success, 1 on failure.
+ */
+static int load_bench_settings(const char *config_path, const ProjectConfig *config, const BenchOptions *options,
+                               BenchSettings *settings) {
+    memset(settings, 0, sizeof(*settings));
+    json_error_t error;
+    json_t *root = json_load_file(config_path, 0, &error);
+    if (!root) {
+        fprintf(stderr, "Error parsing JSON file '%s': on line %d: %s\n", config_path, error.line, error.text);
+        return 1;
+    }
+    json_t *bench = json_object_get(root, "bench");
+
+    settings->runs = json_is_integer(json_object_get(bench, "runs")) ? (int)json_integer_value(json_object_get(bench, "runs")) : DEFAULT_RUNS;
+    settings->warmup = json_is_integer(json_object_get(bench, "warmup")) ? (int)json_integer_value(json_object_get(bench, "warmup")) : DEFAULT_WARMUP;
+    settings->threshold_percent = json_is_number(json_object_get(bench, "regression_threshold_percent"))
+        ? json_number_value(json_object_get(bench, "regression_threshold_percent")) : DEFAULT_REGRESSION_THRESHOLD_PERCENT;
+    if (options->runs > 0) settings->runs = options->runs;
+    if (options->warmup >= 0) settings->warmup = options->warmup;
+    if (settings->warmup < 0) settings->warmup = 0;
+    if (settings->runs < 2) settings->runs = 2; // a confidence interval needs at least two samples
+
+    json_t *cpu_json = json_object_get(bench, "cpu");
+    settings->cpu = json_is_integer(cpu_json) ? (int)json_integer_value(cpu_json) : default_benchmark_cpu();
+    if (options->no_pin) settings->cpu = -1;
+
+    // Release mode: optimized and without assertions unless the project says otherwise
+    json_t *release_json = json_object_get(bench, "release_flags");
+    settings->release_flags = release_json ? copy_json_strings(release_json) : NULL;
+    if (!settings->release_flags) {
+        const char *defaults[] = { "-O2", "-DNDEBUG", NULL };
+        json_t *default_json = json_array();
+        for (int i = 0; defaults[i]; i++) json_array_append_new(default_json, json_string(defaults[i]));
+        settings->release_flags = copy_json_strings(default_json);
+        json_decref(default_json);
+    }
+    json_t *profile_json = json_object_get(bench, "profile");
+    settings->profile = json_is_string(profile_json) ? strdup(json_string_value(profile_json)) : NULL;
+
+    json_t *targets_json = json_object_get(bench, "targets");
+    int count = json_is_array(targets_json) ? (int)json_array_size(targets_json) : 1;
+    settings->targets = (BenchTarget *)calloc((size_t)count, sizeof(BenchTarget));
+    if (!settings->targets || !settings->release_flags) {
+        json_decref(root);
+        return 1;
+    }
+    settings->target_count = count;
+
+    const char *slash = strrchr(config->output_path, '/');
+    const char *output_name = slash ? slash + 1 : config->output_path;
+    int failed = 0;
+    for (int i = 0; i < count && !failed; i++) {
+        BenchTarget *target = &settings->targets[i];
+        json_t *entry = json_is_array(targets_json) ? json_array_get(targets_json, (size_t)i) : NULL;
+        const char *name = entry ? json_string_value(json_object_get(entry, "name")) : config->project_name;
+        if (!name) {
+            fprintf(stderr, "Error: Entry %d of 'bench.targets' needs a \"name\".\n", i);
+            failed = 1;
+            break;
+        }
+        snprintf(target->name, sizeof(target->name), "%s", name);
+        json_t *command_json = json_object_get(entry, "command");
+        target->command = json_is_string(command_json) ? strdup(json_string_value(command_json)) : NULL;
+        json_t *sources_json = json_object_get(entry, "source_files");
+        if (sources_json && !(target->source_files = copy_json_strings(sources_json))) {
+            fprintf(stderr, "Error: 'source_files' of benchmark '%s' must be an array of strings.\n", name);
+            failed = 1;
+        }
+
+        // Targets without their own sources share one release build of the project
+        if (target->source_files) {
+            snprintf(target->build_dir, sizeof(target->build_dir), "%s/bench/build/%s", config->build_dir, name);
+            snprintf(target->binary, sizeof(target->binary), "%s/bench/bin/%s", config->build_dir, name);
+        } else {
+            snprintf(target->build_dir, sizeof(target->build_dir), "%s/bench/build/project", config->build_dir);
+            snprintf(target->binary, sizeof(target->binary), "%s/bench/bin/%s", config->build_dir, output_name);
+        }
+        for (int m = 0; m < METRIC_COUNT && !failed; m++) {
+            target->samples[m] = (double *)calloc((size_t)settings->runs, sizeof(double));
+            if (!target->samples[m]) failed = 1;
+        }
+    }
+    json_decref(root);
+    return failed;
+}
+
+// Builds in a child process, like `coda tune`: the build isolation (lower priority,
+// the build cgroup) then ends with the child instead of carrying over to the benchmarks.
+static int build_in_child(const char *config_path, const BuildOptions *options) {
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("Failed to fork build process");
+        return 1;
+    }
+    if (pid == 0) {
+        int rc = build_project_with_options(config_path, options);
+        fflush(NULL);
+        _exit(rc == 0 ? 0 : 1);
+    }
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return 1;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : 1;
+}
+
+// Builds every target in release mode; targets sharing the project build are built once
+static int build_targets(const char *config_path, BenchSettings *settings) {
+    int built_any = 0;
+    for (int i = 0; i < settings->target_count; i++) {
+        BenchTarget *target = &settings->targets[i];
+        int already_built = 0;
+        for (int j = 0; j < i; j++) {
+            if (strcmp(settings->targets[j].binary, target->binary) == 0) {
+                already_built = 1;
+                target->failed = settings->targets[j].failed;
+            }
+        }
+        if (already_built) continue;
+
+        printf("[LOG] Building benchmark target '%s' in release mode...\n", target->name);
+        BuildOptions build_options = { 0 };
+        build_options.output_path = target->binary;
+        build_options.build_dir = target->build_dir;
+        build_options.extra_compiler_flags = (const char **)settings->release_flags;
+        build_options.profile = settings->profile;
+        build_options.source_files = (const char **)target->source_files;
+        if (build_in_child(config_path, &build_options) != 0) {
+            fprintf(stderr, "[ERROR] Benchmark target '%s' failed to build.\n", target->name);
+            target->failed = 1;
+        } else {
+            built_any = 1;
+        }
+    }
+    return built_any ? 0 : 1;
+}
+
+/**
+ * @brief Opens one hardware counter for a child that has not exec'd yet. The
+ * counter starts on exec and follows the processes the benchmark spawns.
+ * @return The counter fd, or -1 when perf events are unavailable.
+ */
+static int open_counter(pid_t pid, unsigned long long config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1; // allowed at the default perf_event_paranoid level
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0);
+}
+
+static double timespec_ms(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) * 1000.0 + (double)(end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/**
+ * @brief Runs a target once. The child waits on a pipe until the parent has
+ * attached the counters, then pins itself and execs the benchmark; wait4()
+ * supplies CPU time and max RSS.
+ * @param values Receives one value per BenchMetric.
+ * @param counters_available Receives 1 if every hardware counter could be read.
+ * @return 0 if the benchmark exited with status 0, 1 otherwise.
+ */
+static int measure_once(const BenchTarget *target, int cpu, double *values, int *counters_available) {
+    int sync_pipe[2];
+    if (pipe(sync_pipe) != 0) {
+        perror("Failed to create pipe");
+        return 1;
+    }
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("Failed to fork benchmark process");
+        close(sync_pipe[0]);
+        close(sync_pipe[1]);
+        return 1;
+    }
+    if (pid == 0) {
+        close(sync_pipe[1]);
+        char go;
+        if (read(sync_pipe[0], &go, 1) != 1) _exit(127);
+        close(sync_pipe[0]);
+        if (cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            sched_setaffinity(0, sizeof(set), &set);
+        }
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDOUT_FILENO);
+            close(null_fd);
+        }
+        setenv(BENCH_BINARY_ENV, target->binary, 1);
+        if (target->command) execl("/bin/sh", "sh", "-c", target->command, (char *)NULL);
+        else execl(target->binary, target->binary, (char *)NULL);
+        perror("Failed to run benchmark");
+        _exit(127);
+    }
+    close(sync_pipe[0]);
+
+    int counter_fds[METRIC_COUNT];
+    *counters_available = 1;
+    for (int m = 0; m < METRIC_COUNT; m++) {
+        counter_fds[m] = m >= FIRST_COUNTER_METRIC ? open_counter(pid, counter_configs[m]) : -1;
+        if (m >= FIRST_COUNTER_METRIC && counter_fds[m] < 0) *counters_available = 0;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (write(sync_pipe[1], "x", 1) != 1) perror("Failed to start benchmark");
+    close(sync_pipe[1]);
+
+    int status = 0;
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    pid_t waited = wait4(pid, &status, 0, &usage);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    values[METRIC_WALL_MS] = timespec_ms(&start, &end);
+    values[METRIC_CPU_MS] = (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+                            (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+    values[METRIC_MAX_RSS_KB] = (double)usage.ru_maxrss;
+    for (int m = FIRST_COUNTER_METRIC; m < METRIC_COUNT; m++) {
+        unsigned long long count = 0;
+        values[m] = 0.0;
+        if (counter_fds[m] < 0) continue;
+        if (read(counter_fds[m], &count, sizeof(count)) == (ssize_t)sizeof(count)) values[m] = (double)count;
+        else *counters_available = 0;
+        close(counter_fds[m]);
+    }
+
+    if (waited == -1) {
+        perror("wait4 failed");
+        return 1;
+    }
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : 1;
+}
+
+// Runs every target round-robin so drift on the machine affects all of them alike
+static void run_benchmarks(BenchSettings *settings) {
+    for (int round = -settings->warmup; round < settings->runs; round++) {
+        printf("[LOG] %s round %d/%d...\n", round < 0 ? "Warmup" : "Benchmark",
+               round < 0 ? round + settings->warmup + 1 : round + 1, round < 0 ? settings->warmup : settings->runs);
+        for (int i = 0; i < settings->target_count; i++) {
+            BenchTarget *target = &settings->targets[i];
+            if (target->failed) continue;
+            double values[METRIC_COUNT];
+            int counters_available = 0;
+            if (measure_once(target, settings->cpu, values, &counters_available) != 0) {
+                fprintf(stderr, "[WARN] Benchmark '%s' failed; dropping it.\n", target->name);
+                target->failed = 1;
+                continue;
+            }
+            if (round < 0) continue;
+            // Counters are kept only if they worked for every measured run
+            target->counters_available = (target->sample_count == 0 || target->counters_available) && counters_available;
+            for (int m = 0; m < METRIC_COUNT; m++) target->samples[m][target->sample_count] = values[m];
+            target->sample_count++;
+        }
+    }
+}
+
+static int metric_recorded(const BenchTarget *target, int metric) {
+    return metric < FIRST_COUNTER_METRIC || target->counters_available;
+}
+
+/**
+ * @brief Writes the raw samples of this run to <bench_dir>/<commit>.json.
+ * @return 0 on success, 1 on failure.
+ */
+static int save_results(const BenchSettings *settings, const char *commit, const char *results_path) {
+    json_t *root = json_object();
+    json_t *targets = json_object();
+    json_object_set_new(root, "commit", json_string(commit));
+    json_object_set_new(root, "timestamp", json_integer((json_int_t)time(NULL)));
+    json_object_set_new(root, "cpu", json_integer(settings->cpu));
+    json_object_set_new(root, "runs", json_integer(settings->runs));
+    json_object_set_new(root, "warmup", json_integer(settings->warmup));
+    for (int i = 0; i < settings->target_count; i++) {
+        const BenchTarget *target = &settings->targets[i];
+        if (target->failed || target->sample_count == 0) continue;
+        json_t *entry = json_object();
+        json_t *metrics = json_object();
+        json_object_set_new(entry, "command", target->command ? json_string(target->command) : json_null());
+        for (int m = 0; m < METRIC_COUNT; m++) {
+            if (!metric_recorded(target, m)) continue;
+            json_t *samples = json_array();
+            for (int r = 0; r < target->sample_count; r++) json_array_append_new(samples, json_real(target->samples[m][r]));
+            json_object_set_new(metrics, metric_names[m], samples);
+        }
+        json_object_set_new(entry, "metrics", metrics);
+        json_object_set_new(targets, target->name, entry);
+    }
+    json_object_set_new(root, "targets", targets);
+
+    int rc = json_dump_file(root, results_path, JSON_INDENT(2));
+    json_decref(root);
+    if (rc != 0) {
+        fprintf(stderr, "[ERROR] Failed to write %s.\n", results_path);
+        return 1;
+    }
+    return 0;
+}
+
+// Summarizes the baseline samples of one metric. Returns 0 if the baseline has them.
+static int baseline_summary(const json_t *baseline, const char *target, const char *metric, SampleSummary *summary) {
+    json_t *samples = json_object_get(json_object_get(json_object_get(json_object_get(baseline, "targets"), target),
+                                                      "metrics"), metric);
+    size_t count = json_array_size(samples);
+    if (count < 2) return 1;
+    double *values = (double *)malloc(sizeof(double) * count);
+    if (!values) return 1;
+    for (size_t i = 0; i < count; i++) values[i] = json_number_value(json_array_get(samples, i));
+    int rc = summarize_samples(values, (int)count, summary);
+    free(values);
+    return rc;
+}
+
+/**
+ * @brief Prints every target's metrics and, when a baseline is available,
+ * compares them with Welch's t-test.
+ * @return The number of significant regressions above the threshold in gated metrics.
+ */
+static int report_results(const BenchSettings *settings, const json_t *baseline) {
+    int regressions = 0;
+    for (int i = 0; i < settings->target_count; i++) {
+        const BenchTarget *target = &settings->targets[i];
+        if (target->failed || target->sample_count == 0) continue;
+        printf("\n%s (%d runs%s):\n", target->name, target->sample_count,
+               target->counters_available ? "" : ", hardware counters unavailable");
+        printf("  %-14s %16s %14s %16s %10s\n", "Metric", "Mean", "95% CI", "Baseline", "Change");
+        for (int m = 0; m < METRIC_COUNT; m++) {
+            if (!metric_recorded(target, m)) continue;
+            SampleSummary current;
+            summarize_samples(target->samples[m], target->sample_count, &current);
+            char interval[32];
+            snprintf(interval, sizeof(interval), "+/-%.3f", current.ci95_half_width);
+
+            SampleSummary previous;
+            if (!baseline || baseline_summary(baseline, target->name, metric_names[m], &previous) != 0) {
+                printf("  %-14s %16.3f %14s %16s %10s\n", metric_names[m], current.mean, interval, "-", "-");
+                continue;
+            }
+            WelchResult test;
+            welch_t_test(&current, &previous, &test);
+            double change = previous.mean != 0.0 ? (current.mean / previous.mean - 1.0) * 100.0 : 0.0;
+            const char *verdict = "";
+            if (test.significant && change > settings->threshold_percent) {
+                verdict = metric_gates[m] ? "  REGRESSION" : "  (slower)";
+                if (metric_gates[m]) regressions++;
+            } else if (test.significant && change < -settings->threshold_percent) {
+                verdict = "  (improved)";
+            }
+            printf("  %-14s %16.3f %14s %16.3f %+9.1f%%%s\n", metric_names[m], current.mean, interval,
+                   previous.mean, change, verdict);
+        }
+    }
+    return regressions;
+}
+
+// Resolves --baseline: a results file path, or a commit stored in the bench directory
+static void resolve_baseline_path(const char *bench_dir, const char *baseline, char *path, size_t size) {
+    if (!baseline) {
+        snprintf(path, size, "%s/%s", bench_dir, BASELINE_FILE_NAME);
+    } else if (strchr(baseline, '/') || strstr(baseline, ".json")) {
+        snprintf(path, size, "%s", baseline);
+    } else {
+        snprintf(path, size, "%s/%s.json", bench_dir, baseline);
+    }
+}
+
+int bench_project(const char *config_path, const BenchOptions *options) {
+    ProjectConfig config;
+    if (parse_config_from_file(config_path, &config) != 0) {
+        fprintf(stderr, "[ERROR] Failed to parse configuration from %s.\n", config_path);
+        return 1;
+    }
+    BenchSettings settings;
+    if (load_bench_settings(config_path, &config, options, &settings) != 0) {
+        free_settings(&settings);
+        free_config(&config);
+        return 1;
+    }
+
+    char bench_dir[2048], results_path[4096], baseline_path[4096], commit[128];
+    snprintf(bench_dir, sizeof(bench_dir), "%s/bench", config.build_dir);
+    if (read_git_head(".", commit, sizeof(commit)) != 0) snprintf(commit, sizeof(commit), "nogit");
+    snprintf(results_path, sizeof(results_path), "%s/%s.json", bench_dir, commit);
+    resolve_baseline_path(bench_dir, options->baseline, baseline_path, sizeof(baseline_path));
+
+    int rc = 1;
+    if (ensure_directory(bench_dir) != 0 || build_targets(config_path, &settings) != 0) {
+        fprintf(stderr, "[ERROR] No benchmark target could be built.\n");
+    } else {
+        if (settings.cpu >= 0) printf("[LOG] Pinning benchmarks to CPU %d.\n", settings.cpu);
+        run_benchmarks(&settings);
+
+        json_error_t error;
+        json_t *baseline = access(baseline_path, F_OK) == 0 ? json_load_file(baseline_path, 0, &error) : NULL;
+        if (options->baseline && !baseline) {
+            fprintf(stderr, "[WARN] Baseline %s could not be read; reporting without comparison.\n", baseline_path);
+        }
+        int regressions = report_results(&settings, baseline);
+        json_decref(baseline);
+
+        rc = save_results(&settings, commit, results_path);
+        if (rc == 0) printf("\nResults saved to %s.\n", results_path);
+        if (rc == 0 && options->save_baseline) {
+            char default_baseline[4096];
+            resolve_baseline_path(bench_dir, NULL, default_baseline, sizeof(default_baseline));
+            rc = copy_file_atomic(results_path, default_baseline, 0644);
+            if (rc == 0) printf("Saved as the new baseline (%s).\n", default_baseline);
+        }
+        for (int i = 0; i < settings.target_count; i++) {
+            if (settings.targets[i].failed) rc = 1;
+        }
+        if (regressions > 0) {
+            fprintf(stderr, "[ERROR] %d significant regression(s) above %.1f%% compared with %s.\n",
+                    regressions, settings.threshold_percent, baseline_path);
+            rc = 1;
+        }
+    }
+
+    free_settings(&settings);
+    free_config(&config);
+    return rc;
+}
@@ -0,0 +1,29 @@
+#ifndef BENCH_CMD_H
+#define BENCH_CMD_H
+
+/**
+ * @struct BenchOptions
+ * @brief Command-line switches for `coda bench`. Zero values (-1 for warmup,
+ * where 0 is meaningful) fall back to the "bench" section of coda.json, then
+ * to the built-in defaults.
+ */
+typedef struct {
+    int runs;                 // measured runs per target
+    int warmup;               // unmeasured runs per target before measuring; -1 when not given
+    int no_pin;               // do not pin benchmarks to a CPU
+    const char *baseline;     // commit or results file to compare against; default <build_dir>/bench/baseline.json
+    int save_baseline;        // store this run as the new baseline
+} BenchOptions;
+
+/**
+ * @brief Builds the benchmark targets declared in the "bench" section of coda.json
+ * with release flags, runs each one pinned to a CPU with warmup and repetition,
+ * and records wall time, CPU time, max RSS and (when the kernel allows it)
+ * hardware counters in <build_dir>/bench/<commit>.json.
+ * @param config_path The path to the coda.json file.
+ * @param options The benchmark options.
+ * @return 0 on success, 1 on failure or when a significant regression against the baseline was found.
+ */
+int bench_project(const char *config_path, const BenchOptions *options);
+
+#endif // BENCH_CMD_H
@@ -0,0 +1,300 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include "build_cache.h"
+#include "remote_cache.h"
+#include "core_utils.h"
+#include "toolchain.h"
+
+// Bump this whenever the key layout changes so stale entries are never reused.
+#define ACTION_KEY_VERSION "coda-action-v3"
+#define DEFAULT_CACHE_DIR "build/cache"
+// Scratch files, written to the project's build directory
+#define PREPROCESSED_FILE_NAME "temp_coda.i"
+
+/**
+ * @brief Returns the local cache directory (CODA_CACHE_DIR or build/cache).
+ */
+static const char *get_cache_dir() {
+    const char *dir = getenv("CODA_CACHE_DIR");
+    return (dir && dir[0] != '\0') ? dir : DEFAULT_CACHE_DIR;
+}
+
+/**
+ * @brief Builds "<cache_dir>/<first two key chars>/<key>", sharding entries
+ * so no single directory grows too large.
+ */
+static void get_cache_entry_path(const char *key, char *path, size_t path_size) {
+    snprintf(path, path_size, "%s/%.2s/%s", get_cache_dir(), key, key);
+}
+
+/**
+ * @brief Preprocesses one translation unit with the project's compiler flags and
+ * include paths, so the key reflects every header the unit actually sees.
+ * Linker flags are left out because they do not affect preprocessing.
+ * @return 0 on success, 1 on failure.
+ */
+static int preprocess_translation_unit(const ProjectConfig *config, const char *source_path, const char *output_path) {
+    int flag_count = 0, include_count = 0;
+    while (config->compiler_flags && config->compiler_flags[flag_count]) flag_count++;
+    while (config->include_paths && config->include_paths[include_count]) include_count++;
+
+    // compiler, -E, -P, flags..., -I..., source, NULL
+    char **argv = (char **)calloc((size_t)(4 + flag_count + include_count + 1), sizeof(char *));
+    if (!argv) return 1;
+
+    int index = 0;
+    argv[index++] = (char *)config->compiler;
+    argv[index++] = "-E";
+    argv[index++] = "-P";
+    for (int i = 0; i < flag_count; i++) {
+        argv[index++] = (char *)config->compiler_flags[i];
+    }
+    int allocated = 0;
+    for (int i = 0; i < include_count; i++) {
+        size_t len = strlen(config->include_paths[i]) + 3;
+        char *include_arg = (char *)malloc(len);
+        if (!include_arg) break;
+        snprintf(include_arg, len, "-I%s", config->include_paths[i]);
+        argv[index++] = include_arg;
+        allocated++;
+    }
+    argv[index++] = (char *)source_path;
+    argv[index] = NULL;
+
+    int rc = (allocated == include_count) ? run_command_to_file(argv, output_path, NULL) : 1;
+
+    for (int i = 0; i < allocated; i++) {
+        free(argv[3 + flag_count + i]);
+    }
+    free(argv);
+    return rc;
+}
+
+/**
+ * @brief Hashes one argument with every occurrence of the project root replaced
+ * by ".", so reproducible builds (whose prefix maps name the root) from different
+ * checkouts share keys.
+ */
+static void hash_path_independent_argument(HashContext *ctx, const char *arg, const char *root) {
+    size_t root_len = strlen(root);
+    const char *match = root_len > 0 ? strstr(arg, root) : NULL;
+    if (!match) {
+        hash_update_string(ctx, arg);
+        return;
+    }
+    size_t size = strlen(arg) + 1;
+    char *normalized = (char *)malloc(size);
+    if (!normalized) {
+        hash_update_string(ctx, arg);
+        return;
+    }
+    size_t len = 0;
+    for (const char *cursor = arg; *cursor;) {
+        if (strncmp(cursor, root, root_len) == 0) {
+            normalized[len++] = '.';
+            cursor += root_len;
+        } else {
+            normalized[len++] = *cursor++;
+        }
+    }
+    normalized[len] = '\0';
+    hash_update_string(ctx, normalized);
+    free(normalized);
+}
+
+#define MAX_LIBRARY_DIRS 64
+
+static int is_regular_file(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+static int has_suffix(const char *value, const char *suffix) {
+    size_t len = strlen(value), suffix_len = strlen(suffix);
+    return len >= suffix_len && strcmp(value + len - suffix_len, suffix) == 0;
+}
+
+/**
+ * @brief Finds the file the linker would use for "-l<name>": lib<name>.so or
+ * lib<name>.a (only .a with -static), or exactly <name> for "-l:<name>", in the
+ * -L directories first and then the usual system directories.
+ * @return 0 if found, 1 otherwise.
+ */
+static int resolve_library(const char *name, int link_static, const char **dirs, int dir_count,
+                           const char *target, char *out, size_t out_size) {
+    char system_dirs[6][PATH_MAX];
+    int system_count = 0;
+    snprintf(system_dirs[system_count++], PATH_MAX, "/usr/local/lib");
+    if (target[0] != '\0') {
+        snprintf(system_dirs[system_count++], PATH_MAX, "/usr/lib/%s", target);
+        snprintf(system_dirs[system_count++], PATH_MAX, "/lib/%s", target);
+    }
+    snprintf(system_dirs[system_count++], PATH_MAX, "/usr/lib64");
+    snprintf(system_dirs[system_count++], PATH_MAX, "/usr/lib");
+    snprintf(system_dirs[system_count++], PATH_MAX, "/lib");
+
+    for (int i = 0; i < dir_count + system_count; i++) {
+        const char *dir = i < dir_count ? dirs[i] : system_dirs[i - dir_count];
+        if (name[0] == ':') {
+            snprintf(out, out_size, "%s/%s", dir, name + 1);
+            if (is_regular_file(out)) return 0;
+            continue;
+        }
+        if (!link_static) {
+            snprintf(out, out_size, "%s/lib%s.so", dir, name);
+            if (is_regular_file(out)) return 0;
+        }
+        snprintf(out, out_size, "%s/lib%s.a", dir, name);
+        if (is_regular_file(out)) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Hashes the contents of everything the link reads besides the compiled
+ * code: archives, shared libraries and objects named directly, and the
+ * libraries -l resolves to. Without this a cached binary would be restored
+ * after a library it links changed.
+ * @return 0 on success, 1 if an input could not be read.
+ */
+static int hash_link_inputs(HashContext *ctx, char *const *argv, const char *target) {
+    const char *dirs[MAX_LIBRARY_DIRS];
+    int dir_count = 0, link_static = 0;
+
+    // 1. Collect the -L directories; they apply to every -l wherever it appears
+    for (int i = 0; argv[i] != NULL; i++) {
+        if (strcmp(argv[i], "-static") == 0) link_static = 1;
+        if (strncmp(argv[i], "-L", 2) != 0 || dir_count == MAX_LIBRARY_DIRS) continue;
+        const char *dir = argv[i][2] != '\0' ? argv[i] + 2 : argv[i + 1];
+        if (dir) dirs[dir_count++] = dir;
+        if (argv[i][2] == '\0' && argv[i + 1]) i++;
+    }
+
+    // 2. Hash each input. "-o" names the output, not an input.
+    for (int i = 0; argv[i] != NULL; i++) {
+        char path[PATH_MAX];
+        const char *input = NULL;
+        if (strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "-MF") == 0) {
+            if (argv[i + 1]) i++;
+        } else if (strncmp(argv[i], "-l", 2) == 0) {
+            const char *name = argv[i][2] != '\0' ? argv[i] + 2 : argv[i + 1];
+            if (argv[i][2] == '\0' && argv[i + 1]) i++;
+            if (name && resolve_library(name, link_static, dirs, dir_count, target, path, sizeof(path)) == 0) {
+                input = path;
+            }
+        } else if (argv[i][0] != '-' && (has_suffix(argv[i], ".a") || has_suffix(argv[i], ".so") ||
+                                         strstr(argv[i], ".so.") || has_suffix(argv[i], ".o"))) {
+            input = argv[i];
+        }
+        if (!input) continue;
+        hash_update_string(ctx, input);
+        if (hash_update_file(ctx, input) != 0) {
+            fprintf(stderr, "[WARN] Could not read link input %s; skipping artifact cache.\n", input);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int build_cache_compute_key(const ProjectConfig *config, char *const *compile_argv,
+                            const char *const *translation_units, char *out_key) {
+    HashContext ctx;
+    hash_init(&ctx);
+    hash_update_string(&ctx, ACTION_KEY_VERSION);
+
+    char preprocessed_path[4096];
+    snprintf(preprocessed_path, sizeof(preprocessed_path), "%s/%s", config->build_dir, PREPROCESSED_FILE_NAME);
+
+    // 1. Compiler identity: the same name can point at different versions on different machines
+    const Toolchain *toolchain = toolchain_probe(config->compiler);
+    if (!toolchain) {
+        fprintf(stderr, "[WARN] Could not determine compiler version; skipping artifact cache.\n");
+        return 1;
+    }
+    hash_update_string(&ctx, toolchain->version);
+    hash_update_string(&ctx, toolchain->target);
+    hash_update_string(&ctx, toolchain->sysroot);
+
+    // 2. The argv itself, except the values following "-o" and "-MF": where the
+    //    artifact and its dependency file land does not change the artifact, and
+    //    leaving them out lets checkouts with different build directories share entries.
+    char root[4096] = "";
+    if (config->reproducible && !getcwd(root, sizeof(root))) root[0] = '\0';
+    for (int i = 0; compile_argv[i] != NULL; i++) {
+        if ((strcmp(compile_argv[i], "-o") == 0 || strcmp(compile_argv[i], "-MF") == 0) && compile_argv[i + 1] != NULL) {
+            i++;
+            continue;
+        }
+        hash_path_independent_argument(&ctx, compile_argv[i], root);
+    }
+
+    // 3. Libraries and objects the link reads
+    if (hash_link_inputs(&ctx, compile_argv, toolchain->target) != 0) return 1;
+
+    // 4. Preprocessed inputs
+    for (int i = 0; translation_units[i] != NULL; i++) {
+        if (preprocess_translation_unit(config, translation_units[i], preprocessed_path) != 0 ||
+            hash_update_file(&ctx, preprocessed_path) != 0) {
+            fprintf(stderr, "[WARN] Could not preprocess %s; skipping artifact cache.\n", translation_units[i]);
+            return 1;
+        }
+    }
+
+    hash_final_hex(&ctx, out_key);
+    return 0;
+}
+
+int build_cache_restore(const ProjectConfig *config, const char *key, const char *output_path) {
+    char entry_path[4096];
+    get_cache_entry_path(key, entry_path, sizeof(entry_path));
+
+    if (access(entry_path, R_OK) == 0) {
+        if (copy_file_atomic(entry_path, output_path, 0755) == 0) {
+            printf("[LOG] Local cache hit (%.12s).\n", key);
+            return 0;
+        }
+        return 1;
+    }
+
+    if (!config->remote_cache) {
+        return 1;
+    }
+
+    char shard_dir[4096];
+    snprintf(shard_dir, sizeof(shard_dir), "%s/%.2s", get_cache_dir(), key);
+    if (ensure_directory(shard_dir) != 0) {
+        return 1;
+    }
+    if (remote_cache_fetch(config->remote_cache, key, entry_path) != 0) {
+        printf("[LOG] Remote cache miss (%.12s).\n", key);
+        return 1;
+    }
+    if (copy_file_atomic(entry_path, output_path, 0755) != 0) {
+        return 1;
+    }
+    printf("[LOG] Remote cache hit (%.12s). Downloaded artifact from %s.\n", key, config->remote_cache);
+    return 0;
+}
+
+int build_cache_store(const ProjectConfig *config, const char *key, const char *output_path) {
+    char shard_dir[4096];
+    char entry_path[4096];
+    snprintf(shard_dir, sizeof(shard_dir), "%s/%.2s", get_cache_dir(), key);
+    get_cache_entry_path(key, entry_path, sizeof(entry_path));
+
+    if (ensure_directory(shard_dir) != 0 || copy_file_atomic(output_path, entry_path, 0755) != 0) {
+        fprintf(stderr, "[WARN] Failed to store artifact in the local cache.\n");
+        return 1;
+    }
+
+    if (config->remote_cache) {
+        // The local entry is immutable, so the background upload can read it safely.
+        remote_cache_upload_async(config->remote_cache, key, entry_path);
+    }
+    return 0;
+}
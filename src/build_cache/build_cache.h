@@ -0,0 +1,41 @@
+#ifndef BUILD_CACHE_H
+#define BUILD_CACHE_H
+
+#include "project_mgr.h"
+#include "hash_utils.h"
+
+/**
+ * @brief Computes the content-addressed action key for a compiler invocation.
+ * The key covers the compiler identity (its `--version` output), the full argv
+ * minus the output path, and the preprocessed form of every translation unit,
+ * so headers pulled in from include paths are part of the key as well.
+ * @param config The project configuration (compiler, flags, include paths).
+ * @param compile_argv The NULL-terminated argv that would be executed.
+ * @param translation_units NULL-terminated list of the files being compiled.
+ * @param out_key Buffer of at least HASH_HEX_LEN bytes.
+ * @return 0 on success, 1 if the key could not be computed.
+ */
+int build_cache_compute_key(const ProjectConfig *config, char *const *compile_argv,
+                            const char *const *translation_units, char *out_key);
+
+/**
+ * @brief Restores an artifact from the local cache, falling back to the remote cache.
+ * A remote hit is stored locally as well so later builds stay offline.
+ * @param config The project configuration (remote cache URL).
+ * @param key The action key.
+ * @param output_path Where the artifact should be placed.
+ * @return 0 on a cache hit, 1 on a miss.
+ */
+int build_cache_restore(const ProjectConfig *config, const char *key, const char *output_path);
+
+/**
+ * @brief Stores a freshly built artifact in the local cache and starts an
+ * asynchronous upload to the remote cache, if one is configured.
+ * @param config The project configuration (remote cache URL).
+ * @param key The action key.
+ * @param output_path The artifact produced by the compiler.
+ * @return 0 on success, 1 on failure. Failures never fail the build.
+ */
+int build_cache_store(const ProjectConfig *config, const char *key, const char *output_path);
+
+#endif // BUILD_CACHE_H
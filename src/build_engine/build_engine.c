@@ -3,14 +3,29 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <time.h>
 
 #include "build_engine.h"
 #include "project_mgr.h"
 #include "core_utils.h" // Assuming core_utils.h has read_file_to_string
+#include "build_cache.h"
+#include "unity_analyzer.h"
+#include "compile_profiler.h"
+#include "build_state.h"
+#include "process_runner.h"
+#include "toolchain.h"
+#include "build_isolation.h"
+#include "compile_db.h"
 
-#define TEMP_FILE_PATH "build/temp_coda.c"
+// Unity files are written to the project's build directory
+#define TEMP_FILE_NAME "temp_coda.c"
+// Reproducible builds record every build directory under this name
+#define CANONICAL_BUILD_DIR "build"
+#define SOURCE_DATE_EPOCH_FILE_NAME "source_date_epoch.txt"
+// Matrix configurations build in <build_dir>/matrix/<name>/ and log to <build_dir>/matrix/<name>.log
+#define MATRIX_DIR_NAME "matrix"
 
 // Helper function to count elements in a NULL-terminated array
 static int count_array_elements(const char **arr) {
@@ -22,33 +37,140 @@ static int count_array_elements(const char **arr) {
     return count;
 }
 
-// Helper function to copy elements from a source array to a target array
+// Helper function to copy elements from a source array to a target array.
+// Every copied string is owned by the target array so that free_string_list() can release them uniformly.
 static char **copy_array_elements(char **target, const char **source, int *current_index, const char *prefix) {
     if (!source) return target;
     for (int i = 0; source[i] != NULL; ++i) {
         // If prefix is provided (like '-I' for include paths)
-        if (prefix) {
-            size_t len = strlen(prefix) + strlen(source[i]) + 1;
-            char *prefixed_arg = (char *)malloc(len);
-            if (!prefixed_arg) {
-                perror("malloc");
-                return NULL;
-            }
-            snprintf(prefixed_arg, len, "%s%s", prefix, source[i]);
-            target[*current_index] = prefixed_arg;
-        } else {
-            // Just copy the string (already const char* which execvp expects as char*)
-            target[*current_index] = (char *)source[i];
+        const char *actual_prefix = prefix ? prefix : "";
+        size_t len = strlen(actual_prefix) + strlen(source[i]) + 1;
+        char *arg = (char *)malloc(len);
+        if (!arg) {
+            perror("malloc");
+            return NULL;
         }
+        snprintf(arg, len, "%s%s", actual_prefix, source[i]);
+        target[*current_index] = arg;
         (*current_index)++;
+        target[*current_index] = NULL;
     }
     return target;
 }
 
+// Frees a NULL-terminated list of owned strings (e.g. an argv built by build_compiler_argv())
+static void free_string_list(char **argv) {
+    if (!argv) return;
+    for (int i = 0; argv[i] != NULL; i++) {
+        free(argv[i]);
+    }
+    free(argv);
+}
+
+/**
+ * @brief Assembles the argument vector for one compiler invocation.
+ * @param config The project configuration.
+ * @param inputs NULL-terminated list of input files (unity sources or their objects).
+ * @param output The file passed to -o.
+ * @param compile_only When set, emits `-c` and leaves out linker flags (used when compiling and linking separately).
+ * @param link_only When set, leaves out warnings and include paths (inputs are objects).
+ * @param extra_args NULL-terminated list of additional flags appended after the config's flags, or NULL.
+ * @return A NULL-terminated argv owned by the caller, or NULL on failure.
+ */
+static char **build_compiler_argv(const ProjectConfig *config, const char **inputs, const char *output,
+                                  int compile_only, int link_only, const char **extra_args) {
+    // 1. Calculate the total number of arguments needed
+    // 4 mandatory args: compiler, -c, -o, output_path, plus the NULL terminator
+    // 2 args for mandatory flags: -Wall, -Wextra
+    int total_args = 5 + 2;
 
-static int perform_unity_build(const char **src_files) {
-    printf("[LOG] Starting Unity Build process...\n");
-    FILE *temp_file = fopen(TEMP_FILE_PATH, "w");
+    // Add inputs and optional arrays
+    total_args += count_array_elements(inputs);
+    total_args += count_array_elements(config->compiler_flags);
+    total_args += count_array_elements(config->linker_flags);
+    total_args += count_array_elements(config->include_paths); // These will be prefixed with -I
+    total_args += count_array_elements(extra_args);
+
+    // 2. Allocate memory for the argument vector (argv)
+    char **argv = (char **)calloc((size_t)total_args, sizeof(char *));
+    if (!argv) {
+        perror("[ERROR] Failed to allocate memory for compiler arguments");
+        return NULL;
+    }
+
+    int current_index = 0;
+    const char *output_args[] = { "-o", output, NULL };
+    const char *compile_only_args[] = { "-c", NULL };
+    const char *warning_args[] = { "-Wall", "-Wextra", NULL };
+    const char *compiler_args[] = { config->compiler, NULL }; // argv[0] is the compiler name
+
+    // 3. Populate argv with mandatory arguments, then custom flags from config.
+    // Linker flags must come last, but since we are using unity build, it doesn't matter much.
+    if (!copy_array_elements(argv, compiler_args, &current_index, NULL) ||
+        (compile_only && !copy_array_elements(argv, compile_only_args, &current_index, NULL)) ||
+        !copy_array_elements(argv, output_args, &current_index, NULL) ||
+        !copy_array_elements(argv, inputs, &current_index, NULL) ||
+        (!link_only && !copy_array_elements(argv, warning_args, &current_index, NULL)) ||
+        !copy_array_elements(argv, config->compiler_flags, &current_index, NULL) ||
+        (!compile_only && !copy_array_elements(argv, config->linker_flags, &current_index, NULL)) ||
+        (!link_only && !copy_array_elements(argv, config->include_paths, &current_index, "-I")) ||
+        !copy_array_elements(argv, extra_args, &current_index, NULL)) {
+        free_string_list(argv);
+        return NULL;
+    }
+    return argv;
+}
+
+// Runs one compiler invocation to completion with inherited output. Returns 0 on success, 1 otherwise.
+static int run_compiler_process(char **argv) {
+    ProcessSpec spec = { 0 };
+    spec.argv = argv;
+    return process_run(&spec, NULL);
+}
+
+// Returns the list holding the project's unity file, "<build_dir>/temp_coda.c"; free with free_string_list()
+static char **unity_file_list(const char *build_dir) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", build_dir, TEMP_FILE_NAME);
+    char **paths = (char **)calloc(2, sizeof(char *));
+    if (paths) paths[0] = strdup(path);
+    if (paths && !paths[0]) {
+        free(paths);
+        paths = NULL;
+    }
+    return paths;
+}
+
+/**
+ * @brief Writes the names a file must not share with the files before it (see
+ * UnityRename): `opening` saves and renames them before the file, the closing
+ * part restores them after it, so later files see the earlier definitions again.
+ */
+static void write_unity_renames(FILE *out, const UnityPlan *plan, int file_index, int opening) {
+    for (int i = 0; i < plan->rename_count; i++) {
+        const UnityRename *rename = &plan->renames[i];
+        if (rename->file_index != file_index) continue;
+        if (opening) {
+            fprintf(out, "#pragma push_macro(\"%s\")\n#undef %s\n", rename->name, rename->name);
+            if (!rename->is_macro) {
+                fprintf(out, "#define %s %s" UNITY_RENAME_MARKER "%d\n", rename->name, rename->name, file_index);
+            }
+        } else {
+            fprintf(out, "#undef %s\n#pragma pop_macro(\"%s\")\n", rename->name, rename->name);
+        }
+    }
+}
+
+/**
+ * @brief Writes the given source files, in order, into one unity translation unit.
+ * With line_directives, each file starts with a #line directive, so __FILE__ and
+ * diagnostics name the original source instead of the unity file's location.
+ * Files with colliding names are wrapped in the renames of the plan; their
+ * headers are included first so the renames never reach a header's declarations.
+ */
+static int write_unity_file(const char *unity_path, const char **src_files, const UnityPlan *plan,
+                            int line_directives) {
+    FILE *temp_file = fopen(unity_path, "w");
     if (!temp_file) {
         perror("[ERROR] Failed to create temporary file");
         return 1;
@@ -64,105 +186,514 @@ static int perform_unity_build(const char **src_files) {
             return 1;
         }
 
+        int renamed = 0;
+        for (int r = 0; r < plan->rename_count && !renamed; r++) renamed = plan->renames[r].file_index == i;
+        char *includes = renamed ? list_unconditional_includes(file_content) : NULL;
+
         fprintf(temp_file, "// File: %s\n", src_files[i]);
+        if (includes) fputs(includes, temp_file);
+        if (renamed) write_unity_renames(temp_file, plan, i, 1);
+        if (line_directives) fprintf(temp_file, "#line 1 \"%s\"\n", src_files[i]);
         fprintf(temp_file, "%s\n\n", file_content);
+        if (renamed) write_unity_renames(temp_file, plan, i, 0);
+        free(includes);
         free(file_content);
-        printf("[LOG] Successfully appended %s to temp file.\n", src_files[i]);
+        printf("[LOG] Successfully appended %s to %s.\n", src_files[i], unity_path);
     }
-    
+
     fclose(temp_file);
-    printf("[LOG] Unity Build process completed. All source files are in %s.\n", TEMP_FILE_PATH);
     return 0;
 }
 
-static int run_compiler(const ProjectConfig *config) {
-    printf("[LOG] Starting compilation...\n");
-    
-    // 1. Calculate the total number of arguments needed
-    // 5 mandatory args: compiler, -o, output_path, temp_file_path, NULL terminator
-    // 2 args for mandatory flags: -Wall, -Wextra
-    int total_args = 5 + 2; 
+/**
+ * @brief Generates the unity translation unit for the project.
+ * Names that two files define differently (see unity_analyzer) are renamed in
+ * the later file, so the project keeps building as one TU instead of failing.
+ * @param src_files The project's source files.
+ * @param build_dir The directory the unity file is written to.
+ * @param line_directives Emit #line directives (reproducible builds).
+ * @param unity_files Receives the NULL-terminated list of generated files; free with free_string_list().
+ * @param plan When not NULL, receives the collision analysis (free with free_unity_plan()).
+ * @return 0 on success, 1 on failure.
+ */
+static int perform_unity_build(const char **src_files, const char *build_dir, int line_directives, char ***unity_files,
+                               UnityPlan *plan) {
+    printf("[LOG] Starting Unity Build process...\n");
+    *unity_files = NULL;
 
-    // Add optional arrays
-    total_args += count_array_elements(config->compiler_flags);
-    total_args += count_array_elements(config->linker_flags);
-    total_args += count_array_elements(config->include_paths); // These will be prefixed with -I
+    UnityPlan local_plan;
+    if (!plan) plan = &local_plan;
+    if (analyze_unity_safety(src_files, plan) != 0) {
+        return 1;
+    }
+    if (plan->collision_count > plan->unresolved_count) {
+        printf("[LOG] %d unity collision(s) resolved by renaming %d name(s).\n",
+               plan->collision_count - plan->unresolved_count, plan->rename_count);
+    }
+    if (plan->unresolved_count > 0) {
+        fprintf(stderr, "[WARN] %d unity collision(s) left unresolved; the compiler reports those that are errors.\n",
+                plan->unresolved_count);
+    }
 
-    // 2. Allocate memory for the argument vector (argv)
-    char **argv = (char **)malloc(sizeof(char *) * total_args);
-    if (!argv) {
-        perror("[ERROR] Failed to allocate memory for compiler arguments");
+    char **paths = unity_file_list(build_dir);
+    if (!paths || write_unity_file(paths[0], src_files, plan, line_directives) != 0) {
+        if (!paths) perror("[ERROR] Failed to allocate memory for the unity file");
+        free_string_list(paths);
+        free_unity_plan(plan);
         return 1;
     }
+    if (plan == &local_plan) free_unity_plan(plan);
+    *unity_files = paths;
+    printf("[LOG] Unity Build process completed. All source files are in %s.\n", paths[0]);
+    return 0;
+}
 
-    int current_index = 0;
+// Lists the depfile written for every unity file; free with free_string_list()
+static char **depfile_paths_for(const char *build_dir, const char **unity_files) {
+    int count = count_array_elements(unity_files);
+    char **depfiles = (char **)calloc((size_t)count + 1, sizeof(char *));
+    if (!depfiles) return NULL;
+    for (int i = 0; i < count; i++) {
+        depfiles[i] = derived_path_for(build_dir, unity_files[i], ".d");
+        if (!depfiles[i]) {
+            free_string_list(depfiles);
+            return NULL;
+        }
+    }
+    return depfiles;
+}
 
-    // 3. Populate argv with mandatory arguments
-    argv[current_index++] = (char *)config->compiler; // argv[0] is the compiler name
-    argv[current_index++] = "-o";
-    argv[current_index++] = (char *)config->output_path;
-    argv[current_index++] = TEMP_FILE_PATH;
-    
-    // Add mandatory flags
-    argv[current_index++] = "-Wall";
-    argv[current_index++] = "-Wextra";
+/**
+ * @brief Assembles the argv that describes the whole compile action. It is
+ * executed as-is for a single unity file, and it is what the cache key and the
+ * build state record. A single unity file also writes its depfile
+ * (-MMD -MF <build_dir>/temp_coda.d) so `coda explain` knows which headers it used.
+ */
+static char **build_action_argv(const ProjectConfig *config, const char **unity_files) {
+    if (count_array_elements(unity_files) != 1) {
+        return build_compiler_argv(config, unity_files, config->output_path, 0, 0, NULL);
+    }
+    char *depfile = derived_path_for(config->build_dir, unity_files[0], ".d");
+    if (!depfile) return NULL;
+    const char *depfile_args[] = { "-MMD", "-MF", depfile, NULL };
+    char **argv = build_compiler_argv(config, unity_files, config->output_path, 0, 0, depfile_args);
+    free(depfile);
+    return argv;
+}
 
+/**
+ * @brief Updates compile_commands.json with one entry per source file, so editors
+ * index the files Coda actually compiles instead of guessing. Each entry uses
+ * the argv of the real compile (see build_compiler_argv()) with the source in
+ * place of the unity file, and force-includes the files that precede it in the
+ * unity file, because that is what the source sees when it is compiled. Names
+ * the unity file renames cannot be renamed here (-D would reach the included
+ * files too), so the editor may flag those as redefinitions.
+ */
+static void update_compile_database(const ProjectConfig *config) {
+    char directory[4096];
+    if (!getcwd(directory, sizeof(directory))) {
+        perror("[WARN] Failed to update " COMPILE_DB_FILE_NAME);
+        return;
+    }
+    int count = count_array_elements(config->source_files);
+    CompileDbEntry *entries = (CompileDbEntry *)calloc((size_t)count + 1, sizeof(CompileDbEntry));
+    const char **extra_args = (const char **)calloc(2 * (size_t)count + 1, sizeof(char *));
+    int failed = !entries || !extra_args;
+    for (int i = 0; !failed && i < count; i++) {
+        int extra_count = 0;
+        for (int j = 0; j < i; j++) {
+            extra_args[extra_count++] = "-include";
+            extra_args[extra_count++] = config->source_files[j];
+        }
+        extra_args[extra_count] = NULL;
 
-    // 4. Populate argv with custom flags from config (Compiler Flags & Linker Flags)
-    // Linker flags must come last, but since we are using unity build, it doesn't matter much.
-    // However, it's good practice to append all needed flags before the final NULL.
+        const char *inputs[] = { config->source_files[i], NULL };
+        char *object = derived_path_for(config->build_dir, config->source_files[i], ".o");
+        char **argv = object ? build_compiler_argv(config, inputs, object, 1, 0, extra_args) : NULL;
+        entries[i].file = config->source_files[i];
+        entries[i].arguments = argv;
+        entries[i].output = object;
+        failed = !argv;
+    }
+    if (!failed) {
+        compile_db_update(COMPILE_DB_FILE_NAME, directory, entries, count);
+    } else {
+        fprintf(stderr, "[WARN] Failed to update %s.\n", COMPILE_DB_FILE_NAME);
+    }
+    for (int i = 0; entries && i < count; i++) {
+        free_string_list((char **)entries[i].arguments);
+        free((void *)entries[i].output);
+    }
+    free(entries);
+    free(extra_args);
+}
 
-    // Copy compiler_flags
-    if (!copy_array_elements(argv, config->compiler_flags, &current_index, NULL)) return 1;
+static double seconds_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
 
-    // Copy linker_flags
-    if (!copy_array_elements(argv, config->linker_flags, &current_index, NULL)) return 1;
+/**
+ * @brief Compiles each unity file to an object file in parallel, then links them.
+ * Profiled builds use this, because the profile belongs to the compile step alone.
+ * @param profiler When not PROFILER_UNSUPPORTED, the profiling flag is added to every
+ * compile step and gcc's report is captured per unity file.
+ * @param timings Receives the time spent compiling and linking.
+ * @return 0 on success, 1 on failure.
+ */
+static int compile_and_link_separately(const ProjectConfig *config, const char **unity_files, ProfilerKind profiler,
+                                       BuildTimings *timings) {
+    int unity_count = count_array_elements(unity_files);
+    char **objects = (char **)calloc((size_t)unity_count + 1, sizeof(char *));
+    if (!objects) {
+        perror("[ERROR] Failed to allocate memory for unity objects");
+        return 1;
+    }
 
-    // Copy include_paths (must be prefixed with -I)
-    if (!copy_array_elements(argv, config->include_paths, &current_index, "-I")) return 1;
+    // 1. Start one compiler per unity file, each writing its own depfile. Diagnostics
+    // are buffered per compiler and printed whole, so parallel compiles never interleave.
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    ProcessRunner runner;
+    process_runner_init(&runner);
+    int failed = 0;
+    for (int i = 0; i < unity_count; i++) {
+        objects[i] = derived_path_for(config->build_dir, unity_files[i], ".o");
+        char *depfile = derived_path_for(config->build_dir, unity_files[i], ".d");
 
-    // 5. Add NULL terminator at the very end
-    argv[current_index] = NULL;
-    
-    printf("[LOG] Compiler arguments prepared. Executing: %s ...\n", config->compiler);
+        const char *inputs[] = { unity_files[i], NULL };
+        const char *extra_args[] = { "-MMD", "-MF", depfile, get_profiler_flag(profiler), NULL };
+        char **argv = (objects[i] && depfile) ? build_compiler_argv(config, inputs, objects[i], 1, 0, extra_args) : NULL;
+        free(depfile);
+        char stderr_path[4096];
+        int capture_stderr = objects[i] && profiler == PROFILER_GCC_TIME_REPORT;
+        if (capture_stderr) get_profile_output_path(profiler, objects[i], stderr_path, sizeof(stderr_path));
+        ProcessSpec spec = { 0 };
+        spec.argv = argv;
+        spec.stderr_path = capture_stderr ? stderr_path : NULL;
+        spec.capture_output = 1;
+        if (!argv || process_runner_spawn(&runner, &spec) < 0) failed = 1;
+        free_string_list(argv);
+    }
 
-    // 6. Execute the compiler (fork/execvp)
-    pid_t pid = fork();
-    if (pid == -1) {
-        perror("[ERROR] Failed to fork process");
-        free(argv); // Clean up the argv array
-        return 1;
+    // 2. Wait for all of them, even after a failure, so no child is left behind
+    if (process_runner_wait_all(&runner) != 0) failed = 1;
+    process_runner_free(&runner);
+    timings->compile_seconds = seconds_since(&started);
+    for (int i = 0; i < unity_count; i++) {
+        if (objects[i] && profiler == PROFILER_GCC_TIME_REPORT) {
+            char report_path[4096];
+            get_profile_output_path(profiler, objects[i], report_path, sizeof(report_path));
+            forward_profile_diagnostics(profiler, report_path);
+        }
     }
-    if (pid == 0) {
-        // Child process: execute the compiler
-        execvp(config->compiler, argv);
-        perror("[ERROR] Failed to run compiler");
-        _exit(1);
-    } else {
-        // Parent process: wait for the compiler to finish
-        int status;
-        waitpid(pid, &status, 0);
-        
-        // Clean up memory allocated for the arguments
-        // IMPORTANT: We only free strings that were allocated inside copy_array_elements (those with prefixes, i.e., include_paths)
-        for (int i = 0; config->include_paths && config->include_paths[i] != NULL; i++) {
-            // Include paths are the only prefixed ones that need freeing here
-            if (i + 4 + 2 + count_array_elements(config->compiler_flags) + count_array_elements(config->linker_flags) < current_index) {
-                free(argv[i + 4 + 2 + count_array_elements(config->compiler_flags) + count_array_elements(config->linker_flags)]);
-            }
+
+    // 3. Link the objects into the final executable
+    if (!failed) {
+        printf("[LOG] %d unity file(s) compiled. Linking...\n", unity_count);
+        clock_gettime(CLOCK_MONOTONIC, &started);
+        char **argv = build_compiler_argv(config, (const char **)objects, config->output_path, 0, 1, NULL);
+        failed = (!argv || run_compiler_process(argv) != 0);
+        free_string_list(argv);
+        timings->link_seconds = seconds_since(&started);
+    }
+
+    free_string_list(objects);
+    return failed;
+}
+
+// Saves the build state for `coda explain`; failures are only warnings.
+static void record_build_state(const ProjectConfig *config, char **argv, const char **depfiles,
+                               const char **unity_files, const json_t *previous_state,
+                               const char *action_key, const char *cache_result, const char *outcome,
+                               const BuildTimings *timings) {
+    json_t *state = build_state_capture(config, argv, depfiles, unity_files, previous_state);
+    if (!state) {
+        fprintf(stderr, "[WARN] Failed to capture the build state.\n");
+        return;
+    }
+    build_state_save(state, config->build_dir, action_key, cache_result, outcome, timings);
+    json_decref(state);
+}
+
+static int run_compiler(const ProjectConfig *config, const char **unity_files, const BuildOptions *options) {
+    printf("[LOG] Starting compilation...\n");
+    // Every compiler started from here on inherits the isolation (cgroup or priority)
+    build_isolation_apply(&config->isolation);
+
+    // Profiling needs one object per unity file (clang writes its trace next to it),
+    // and the result must not come from the cache.
+    ProfilerKind profiler = PROFILER_UNSUPPORTED;
+    if (options->profile_compile) {
+        profiler = detect_profiler_kind(config->compiler);
+        if (profiler == PROFILER_UNSUPPORTED) {
+            fprintf(stderr, "[WARN] '%s' supports neither -ftime-trace nor -ftime-report; building without profiling.\n",
+                    config->compiler);
+        } else {
+            printf("[LOG] Profiling compilation with %s.\n", get_profiler_flag(profiler));
         }
-        free(argv); 
+    }
+
+    // 1. Assemble the argv describing the whole action (see build_action_argv())
+    char **argv = build_action_argv(config, unity_files);
+    if (!argv) {
+        return 1;
+    }
+    // The last build's state supplies the header list when nothing gets compiled
+    json_t *previous_state = build_state_load(config->build_dir, 0);
+    char **depfiles = depfile_paths_for(config->build_dir, unity_files);
+    for (int i = 0; depfiles && depfiles[i] != NULL; i++) {
+        unlink(depfiles[i]); // a stale depfile must not be mistaken for this build's
+    }
+
+    printf("[LOG] Compiler arguments prepared. Executing: %s ...\n", config->compiler);
 
-        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
-            printf("[LOG] Compiler finished with status code 0. Compilation succeeded.\n");
+    // 2. Consult the artifact cache (local first, then remote) before compiling
+    char action_key[HASH_HEX_LEN];
+    int have_action_key = 0;
+    if (config->cache_enabled && !options->disable_cache && profiler == PROFILER_UNSUPPORTED) {
+        have_action_key = build_cache_compute_key(config, argv, unity_files, action_key) == 0;
+        if (have_action_key && build_cache_restore(config, action_key, config->output_path) == 0) {
+            record_build_state(config, argv, NULL, unity_files, previous_state, action_key, "hit", "restored", NULL);
+            free_string_list(depfiles);
+            free_string_list(argv);
+            json_decref(previous_state);
+            printf("[LOG] Compilation skipped; artifact restored from cache.\n");
             return 0;
         }
     }
+
+    // 3. Execute the compiler: in one step, or compile and link separately when profiling
+    int failed;
+    BuildTimings timings = { -1, -1, -1, -1, -1 };
+    IsolationUsage usage_before, usage_after;
+    int isolated = build_isolation_read_usage(&usage_before) == 0;
+    if (count_array_elements(unity_files) == 1 && profiler == PROFILER_UNSUPPORTED) {
+        struct timespec started;
+        clock_gettime(CLOCK_MONOTONIC, &started);
+        failed = run_compiler_process(argv);
+        timings.compile_seconds = seconds_since(&started);
+    } else {
+        failed = compile_and_link_separately(config, unity_files, profiler, &timings);
+    }
+    if (isolated && build_isolation_read_usage(&usage_after) == 0) {
+        build_isolation_report(&usage_before, &usage_after);
+        timings.cpu_stall_seconds = usage_after.cpu_stall_seconds - usage_before.cpu_stall_seconds;
+        timings.memory_stall_seconds = usage_after.memory_stall_seconds - usage_before.memory_stall_seconds;
+        timings.io_stall_seconds = usage_after.io_stall_seconds - usage_before.io_stall_seconds;
+    }
+
+    record_build_state(config, argv, (const char **)depfiles, unity_files, previous_state,
+                       have_action_key ? action_key : NULL, have_action_key ? "miss" : "disabled",
+                       failed ? "failed" : "compiled", &timings);
+
+    // Clean up memory allocated for the arguments
+    free_string_list(depfiles);
+    free_string_list(argv);
+    json_decref(previous_state);
+
+    if (!failed) {
+        printf("[LOG] Compiler finished with status code 0. Compilation succeeded.\n");
+        if (have_action_key) {
+            build_cache_store(config, action_key, config->output_path);
+        }
+        if (profiler != PROFILER_UNSUPPORTED) {
+            report_compile_profile(profiler, config->build_dir, unity_files, config->source_files);
+        }
+        return 0;
+    }
     printf("[ERROR] Compiler failed. Check the errors above.\n");
     return 1;
 }
 
+// Appends a NULL-terminated list of flags (copied) to a NULL-terminated flag array of the config.
+static int append_flags(const char ***flags_list, const char *const *extra_flags) {
+    int extra_count = count_array_elements((const char **)extra_flags);
+    if (extra_count == 0) return 0;
+    int flag_count = count_array_elements(*flags_list);
+    const char **flags = (const char **)realloc((void *)*flags_list,
+                                                sizeof(char *) * (size_t)(flag_count + extra_count + 1));
+    if (!flags) return 1;
+    for (int i = 0; i < extra_count; i++) {
+        flags[flag_count + i] = strdup(extra_flags[i]);
+    }
+    flags[flag_count + extra_count] = NULL;
+    *flags_list = flags;
+    return 0;
+}
+
+static int has_flag_with_prefix(const char **flags, const char *prefix) {
+    for (int i = 0; flags && flags[i] != NULL; i++) {
+        if (strncmp(flags[i], prefix, strlen(prefix)) == 0) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Adds the fastest options the compiler supports (see toolchain_probe()):
+ * -pipe, and the fastest linker that works unless the project already chooses one.
+ * Both only change how fast the build runs, not what it produces.
+ * @return 0 on success, 1 on failure.
+ */
+static int apply_toolchain_settings(ProjectConfig *config) {
+    const Toolchain *toolchain = toolchain_probe(config->compiler);
+    if (!toolchain) return 0; // running the compiler reports the actual error
+    const char *compile_flags[] = { NULL, NULL };
+    const char *link_flags[] = { NULL, NULL };
+    if (toolchain->supports_pipe && !has_flag_with_prefix(config->compiler_flags, "-pipe")) {
+        compile_flags[0] = "-pipe";
+    }
+    if (toolchain->fast_linker && !has_flag_with_prefix(config->linker_flags, "-fuse-ld=") &&
+        !has_flag_with_prefix(config->compiler_flags, "-fuse-ld=")) {
+        link_flags[0] = toolchain->fast_linker;
+    }
+    return append_flags(&config->compiler_flags, compile_flags) != 0 ||
+           append_flags(&config->linker_flags, link_flags) != 0;
+}
+
+// Rewrites paths inside the project root as relative paths, so they read the same in every checkout
+static int relativize_paths(const char **paths, const char *root) {
+    size_t root_len = strlen(root);
+    for (int i = 0; paths && paths[i] != NULL; i++) {
+        if (strncmp(paths[i], root, root_len) != 0 || paths[i][root_len] != '/') continue;
+        char *relative = strdup(paths[i] + root_len + 1);
+        if (!relative) return 1;
+        free((void *)paths[i]);
+        paths[i] = relative;
+    }
+    return 0;
+}
+
+static int compare_strings(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/**
+ * @brief Pins SOURCE_DATE_EPOCH, which gcc and clang use for __DATE__ and __TIME__,
+ * to the time of the last commit (or 0 outside git) unless the caller already set it.
+ */
+static void pin_source_date_epoch(const ProjectConfig *config) {
+    if (getenv("SOURCE_DATE_EPOCH")) return;
+    char epoch[32] = "0";
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", config->build_dir, SOURCE_DATE_EPOCH_FILE_NAME);
+    char *argv[] = { "git", "log", "-1", "--format=%ct", NULL };
+    if (ensure_directory(config->build_dir) == 0 && run_command_to_file(argv, path, "/dev/null") == 0) {
+        char *output = read_file_to_string(path);
+        size_t digits = output ? strspn(output, "0123456789") : 0;
+        if (digits > 0 && digits < sizeof(epoch)) snprintf(epoch, sizeof(epoch), "%.*s", (int)digits, output);
+        free(output);
+    }
+    setenv("SOURCE_DATE_EPOCH", epoch, 1);
+}
+
+/**
+ * @brief Makes a build independent of where and when it runs: paths inside the
+ * project become relative, the project root and build directory are mapped to
+ * fixed names in debug info and __FILE__, dependencies are sorted and
+ * SOURCE_DATE_EPOCH is pinned. Unity files additionally get #line directives.
+ * @return 0 on success, 1 on failure.
+ */
+static int apply_reproducible_settings(ProjectConfig *config) {
+    char root[4096];
+    if (!getcwd(root, sizeof(root))) {
+        perror("[ERROR] Failed to determine the project root");
+        return 1;
+    }
+    if (relativize_paths(config->source_files, root) != 0 || relativize_paths(config->include_paths, root) != 0) {
+        return 1;
+    }
+    qsort((void *)config->dependencies, (size_t)count_array_elements(config->dependencies), sizeof(char *),
+          compare_strings);
+    pin_source_date_epoch(config);
+
+    // -fdebug-prefix-map is implied by -ffile-prefix-map; it is repeated for compilers that only know the former.
+    // The build directory mapping comes last so it wins over the root mapping for absolute build directories.
+    char root_map[4096 + 32], debug_map[4096 + 32], build_map[4096 + 32];
+    snprintf(root_map, sizeof(root_map), "-ffile-prefix-map=%s=.", root);
+    snprintf(debug_map, sizeof(debug_map), "-fdebug-prefix-map=%s=.", root);
+    snprintf(build_map, sizeof(build_map), "-ffile-prefix-map=%s/=%s/", config->build_dir, CANONICAL_BUILD_DIR);
+    const char *flags[] = { root_map, debug_map, strcmp(config->build_dir, CANONICAL_BUILD_DIR) != 0 ? build_map : NULL, NULL };
+    return append_flags(&config->compiler_flags, flags);
+}
+
+// Sets the config's output path and creates its directory, which the compiler does not do for us
+static int replace_output_path(ProjectConfig *config, const char *path) {
+    char *output_path = strdup(path);
+    if (!output_path) return 1;
+    free((void *)config->output_path);
+    config->output_path = output_path;
+
+    char *slash = strrchr(output_path, '/');
+    if (slash && slash != output_path) {
+        *slash = '\0';
+        int rc = ensure_directory(output_path);
+        *slash = '/';
+        if (rc != 0) {
+            fprintf(stderr, "[ERROR] Failed to create the output directory for %s.\n", output_path);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Applies the output path, build directory and source file overrides, the selected
+ * profile, the extra compiler flags and reproducible mode from the build options to a
+ * parsed configuration.
+ * @return 0 on success, 1 on failure.
+ */
+static int apply_build_options(ProjectConfig *config, const char *config_path, const BuildOptions *options) {
+    if (options->build_dir) {
+        char *build_dir = strdup(options->build_dir);
+        if (!build_dir) return 1;
+        free((void *)config->build_dir);
+        config->build_dir = build_dir;
+    }
+
+    if (options->output_path && replace_output_path(config, options->output_path) != 0) {
+        return 1;
+    }
+
+    if (options->source_files) {
+        int count = count_array_elements(options->source_files);
+        char **source_files = (char **)calloc((size_t)count + 1, sizeof(char *));
+        int index = 0;
+        if (!source_files || !copy_array_elements(source_files, options->source_files, &index, NULL)) {
+            free_string_list(source_files);
+            return 1;
+        }
+        free_string_list((char **)config->source_files);
+        config->source_files = (const char **)source_files;
+    }
+
+    if (options->profile) {
+        const char **profile_flags = NULL;
+        if (load_config_profile(config_path, options->profile, &profile_flags) != 0) {
+            return 1;
+        }
+        printf("[LOG] Using profile '%s'.\n", options->profile);
+        int rc = append_flags(&config->compiler_flags, profile_flags);
+        for (int i = 0; profile_flags[i] != NULL; i++) free((void *)profile_flags[i]);
+        free((void *)profile_flags);
+        if (rc != 0) return 1;
+    }
+
+    if (append_flags(&config->compiler_flags, options->extra_compiler_flags) != 0) return 1;
+    if (options->reproducible) config->reproducible = 1;
+    return config->reproducible ? apply_reproducible_settings(config) : 0;
+}
+
 int build_project(const char *config_path) {
+    return build_project_with_options(config_path, NULL);
+}
+
+int build_project_with_options(const char *config_path, const BuildOptions *options) {
+    BuildOptions default_options = { 0 };
+    if (!options) options = &default_options;
+
     printf("[LOG] Starting build_project function...\n");
     ProjectConfig config;
     if (parse_config_from_file(config_path, &config) != 0) {
@@ -170,22 +701,327 @@ int build_project(const char *config_path) {
         return 1;
     }
     printf("[LOG] Configuration parsed successfully.\n");
-    
-    if (perform_unity_build(config.source_files) != 0) {
+    if (apply_build_options(&config, config_path, options) != 0 ||
+        (config.auto_flags && apply_toolchain_settings(&config) != 0)) {
+        fprintf(stderr, "[ERROR] Failed to apply build options.\n");
+        free_config(&config);
+        return 1;
+    }
+
+    char **unity_files = NULL;
+    if (ensure_directory(config.build_dir) != 0 ||
+        perform_unity_build(config.source_files, config.build_dir, config.reproducible, &unity_files, NULL) != 0) {
         fprintf(stderr, "[ERROR] Unity build failed.\n");
         free_config(&config);
         return 1;
     }
-    
+
+    // Builds with overridden flags, outputs or sources (hot reload, tune, bench) would only churn the editor's index
+    if (config.compile_commands && !options->output_path && !options->extra_compiler_flags && !options->build_dir &&
+        !options->source_files) {
+        update_compile_database(&config);
+    }
+
     // Pass the entire config structure to the compiler runner
-    if (run_compiler(&config) != 0) { 
+    int compile_rc = run_compiler(&config, (const char **)unity_files, options);
+    build_isolation_release();
+    if (compile_rc != 0) {
         fprintf(stderr, "[ERROR] Compilation failed.\n");
+        free_string_list(unity_files);
         free_config(&config);
         return 1;
     }
 
     printf("[LOG] Build process completed successfully.\n");
     printf("Build succeeded! Executable: %s\n", config.output_path);
+    free_string_list(unity_files);
     free_config(&config);
     return 0;
-}
\ No newline at end of file
+}
+
+// Compares two files byte for byte, reporting the first difference. Returns 0 if they are identical.
+static int compare_outputs(const char *first, const char *second) {
+    FILE *a = fopen(first, "rb");
+    FILE *b = fopen(second, "rb");
+    if (!a || !b) {
+        perror("[ERROR] Failed to open a build output");
+        if (a) fclose(a);
+        if (b) fclose(b);
+        return 1;
+    }
+    char buffer_a[65536], buffer_b[65536];
+    long long offset = 0;
+    int differs = 0;
+    while (!differs) {
+        size_t read_a = fread(buffer_a, 1, sizeof(buffer_a), a);
+        size_t read_b = fread(buffer_b, 1, sizeof(buffer_b), b);
+        size_t common = read_a < read_b ? read_a : read_b;
+        size_t i = 0;
+        while (i < common && buffer_a[i] == buffer_b[i]) i++;
+        offset += (long long)i;
+        differs = i < common || read_a != read_b;
+        if (read_a == 0) break;
+    }
+    fclose(a);
+    fclose(b);
+    if (differs) fprintf(stderr, "[ERROR] %s and %s differ from byte %lld on.\n", first, second, offset);
+    return differs;
+}
+
+int verify_reproducible_build(const char *config_path, const BuildOptions *options) {
+    BuildOptions default_options = { 0 };
+    if (!options) options = &default_options;
+    ProjectConfig config;
+    if (parse_config_from_file(config_path, &config) != 0) {
+        fprintf(stderr, "[ERROR] Failed to parse configuration from %s.\n", config_path);
+        return 1;
+    }
+    const char *output_path = options->output_path ? options->output_path : config.output_path;
+    const char *output_name = strrchr(output_path, '/') ? strrchr(output_path, '/') + 1 : output_path;
+
+    // Different build directories catch path leaks; skipping the cache makes both builds compile
+    char build_dirs[2][4096], outputs[2][4096 + 256];
+    int failed = 0;
+    for (int i = 0; i < 2 && !failed; i++) {
+        snprintf(build_dirs[i], sizeof(build_dirs[i]), "%s/repro/%d", options->build_dir ? options->build_dir : config.build_dir, i + 1);
+        if (snprintf(outputs[i], sizeof(outputs[i]), "%s/%s", build_dirs[i], output_name) >= (int)sizeof(outputs[i])) {
+            fprintf(stderr, "[ERROR] The output path in %s is too long.\n", build_dirs[i]);
+            failed = 1;
+            break;
+        }
+        BuildOptions run_options = *options;
+        run_options.build_dir = build_dirs[i];
+        run_options.output_path = outputs[i];
+        run_options.reproducible = 1;
+        run_options.disable_cache = 1;
+        printf("[LOG] Reproducibility check: build %d of 2 in %s...\n", i + 1, build_dirs[i]);
+        failed = build_project_with_options(config_path, &run_options) != 0;
+    }
+    free_config(&config);
+    if (failed) {
+        fprintf(stderr, "[ERROR] Reproducibility check could not complete because a build failed.\n");
+        return 1;
+    }
+    if (compare_outputs(outputs[0], outputs[1]) != 0) {
+        fprintf(stderr, "[ERROR] The build is not reproducible. Look for __DATE__/__TIME__ without SOURCE_DATE_EPOCH, "
+                        "absolute paths outside the project, or randomness in the toolchain.\n");
+        return 1;
+    }
+    printf("Build is reproducible: %s and %s are identical.\n", outputs[0], outputs[1]);
+    return 0;
+}
+
+/**
+ * @brief Derives the configuration of one matrix entry from the project's: its
+ * compiler and extra flags, its own output path, and a build directory below
+ * <build_dir>/matrix/ for its objects, depfiles and build state.
+ * @return 0 on success, 1 on failure.
+ */
+static int prepare_matrix_config(const ProjectConfig *base, const MatrixConfiguration *entry, ProjectConfig *config) {
+    if (copy_config(base, config) != 0) return 1;
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s/%s", base->build_dir, MATRIX_DIR_NAME, entry->name);
+    char *build_dir = strdup(path);
+    char *compiler = entry->compiler ? strdup(entry->compiler) : NULL;
+    if (!build_dir || (entry->compiler && !compiler)) {
+        free(build_dir);
+        free(compiler);
+        free_config(config);
+        return 1;
+    }
+    free((void *)config->build_dir);
+    config->build_dir = build_dir;
+    if (compiler) {
+        free((void *)config->compiler);
+        config->compiler = compiler;
+    }
+    snprintf(path, sizeof(path), "%s-%s", base->output_path, entry->name);
+
+    if (ensure_directory(config->build_dir) != 0 ||
+        replace_output_path(config, entry->output_path ? entry->output_path : path) != 0 ||
+        append_flags(&config->compiler_flags, entry->compiler_flags) != 0 ||
+        append_flags(&config->linker_flags, entry->linker_flags) != 0 ||
+        (config->auto_flags && apply_toolchain_settings(config) != 0)) {
+        free_config(config);
+        return 1;
+    }
+    return 0;
+}
+
+// Compiles one matrix configuration in a child process, logging to <build_dir>/matrix/<name>.log
+static pid_t start_matrix_build(const ProjectConfig *config, const char **unity_files, const BuildOptions *options,
+                                const char *log_path) {
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("Failed to fork matrix build");
+        return -1;
+    }
+    if (pid == 0) {
+        int fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+            setvbuf(stdout, NULL, _IOLBF, 0); // keep stdout and stderr interleaved in the log
+        }
+        int rc = run_compiler(config, unity_files, options);
+        build_isolation_release();
+        fflush(NULL);
+        _exit(rc == 0 ? 0 : 1);
+    }
+    return pid;
+}
+
+/**
+ * @struct MatrixRun
+ * @brief The scheduler state of one `coda build --matrix` invocation.
+ */
+typedef struct {
+    const MatrixConfiguration *entries;
+    const ProjectConfig *configs;
+    char (*log_paths)[4096];
+    struct timespec *started;
+    int *entry_of_job;
+    int built;
+    int failed;
+} MatrixRun;
+
+// Waits for one running configuration and reports it. Returns 0 if one finished, 1 if none was running.
+static int finish_matrix_build(ProcessRunner *runner, MatrixRun *run) {
+    int job = process_runner_wait_any(runner);
+    if (job < 0) return 1;
+    int i = run->entry_of_job[job];
+    if (process_job_succeeded(&runner->jobs[job])) {
+        run->built++;
+        printf("[LOG] [%s] Built %s in %.2fs.\n", run->entries[i].name, run->configs[i].output_path,
+               seconds_since(&run->started[i]));
+    } else {
+        run->failed++;
+        fprintf(stderr, "[ERROR] [%s] Build failed (log: %s):\n", run->entries[i].name, run->log_paths[i]);
+        char *log = read_file_to_string(run->log_paths[i]);
+        if (log) {
+            fprintf(stderr, "%s", log);
+            free(log);
+        }
+    }
+    return 0;
+}
+
+int build_matrix(const char *config_path, const BuildOptions *options, int jobs) {
+    BuildOptions default_options = { 0 };
+    if (!options) options = &default_options;
+    struct timespec matrix_start;
+    clock_gettime(CLOCK_MONOTONIC, &matrix_start);
+
+    ProjectConfig base;
+    if (parse_config_from_file(config_path, &base) != 0) {
+        fprintf(stderr, "[ERROR] Failed to parse configuration from %s.\n", config_path);
+        return 1;
+    }
+    MatrixConfiguration *entries = NULL;
+    int count = 0;
+    if (apply_build_options(&base, config_path, options) != 0 ||
+        load_config_matrix(config_path, &entries, &count) != 0) {
+        free_config(&base);
+        return 1;
+    }
+    if (jobs <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = cpus > 0 ? (int)cpus : 1;
+    }
+
+    // 1. Configuration-independent work happens once: the unity analysis and the unity files
+    char **unity_files = NULL;
+    if (ensure_directory(base.build_dir) != 0 ||
+        perform_unity_build(base.source_files, base.build_dir, base.reproducible, &unity_files, NULL) != 0) {
+        fprintf(stderr, "[ERROR] Unity build failed.\n");
+        free_config_matrix(entries, count);
+        free_config(&base);
+        return 1;
+    }
+
+    // 2. Derive every configuration before forking, so each distinct compiler is probed only once
+    ProjectConfig *configs = (ProjectConfig *)calloc((size_t)count, sizeof(ProjectConfig));
+    char (*log_paths)[4096] = calloc((size_t)count, sizeof(*log_paths));
+    struct timespec *started = (struct timespec *)calloc((size_t)count, sizeof(struct timespec));
+    int *entry_of_job = (int *)calloc((size_t)count, sizeof(int));
+    int prepared = 0;
+    int rc = (configs && log_paths && started && entry_of_job) ? 0 : 1;
+    for (; rc == 0 && prepared < count; prepared++) {
+        if (prepare_matrix_config(&base, &entries[prepared], &configs[prepared]) != 0) {
+            fprintf(stderr, "[ERROR] Failed to prepare matrix configuration '%s'.\n", entries[prepared].name);
+            rc = 1;
+            break;
+        }
+        snprintf(log_paths[prepared], sizeof(log_paths[prepared]), "%s/%s/%s.log", base.build_dir, MATRIX_DIR_NAME,
+                 entries[prepared].name);
+    }
+
+    // 3. Compile all configurations concurrently, at most `jobs` at a time
+    MatrixRun run = { entries, configs, log_paths, started, entry_of_job, 0, 0 };
+    if (rc == 0) {
+        printf("[LOG] Building %d matrix configuration(s), up to %d at a time...\n", count, jobs);
+        ProcessRunner runner;
+        process_runner_init(&runner);
+        int running = 0;
+        for (int i = 0; i < count; i++) {
+            while (running >= jobs && finish_matrix_build(&runner, &run) == 0) running--;
+            printf("[LOG] [%s] Building...\n", entries[i].name);
+            clock_gettime(CLOCK_MONOTONIC, &started[i]);
+            pid_t pid = start_matrix_build(&configs[i], (const char **)unity_files, options, log_paths[i]);
+            int job = pid > 0 ? process_runner_adopt(&runner, pid, 0) : -1;
+            if (job < 0) {
+                run.failed++;
+                continue;
+            }
+            entry_of_job[job] = i;
+            running++;
+        }
+        while (finish_matrix_build(&runner, &run) == 0) {
+        }
+        process_runner_free(&runner);
+        printf("Matrix build finished in %.2fs: %d built, %d failed.\n", seconds_since(&matrix_start), run.built,
+               run.failed);
+        rc = run.failed > 0 ? 1 : 0;
+    }
+
+    for (int i = 0; configs && i < prepared; i++) free_config(&configs[i]);
+    free(configs);
+    free(log_paths);
+    free(started);
+    free(entry_of_job);
+    free_string_list(unity_files);
+    free_config_matrix(entries, count);
+    free_config(&base);
+    return rc;
+}
+
+json_t *capture_next_build_state(const char *config_path) {
+    ProjectConfig config;
+    if (parse_config_from_file(config_path, &config) != 0) {
+        fprintf(stderr, "[ERROR] Failed to parse configuration from %s.\n", config_path);
+        return NULL;
+    }
+    if ((config.reproducible && apply_reproducible_settings(&config) != 0) ||
+        (config.auto_flags && apply_toolchain_settings(&config) != 0)) {
+        free_config(&config);
+        return NULL;
+    }
+
+    // The same unity file the next build would generate, without writing it
+    json_t *state = NULL;
+    char **unity_files = unity_file_list(config.build_dir);
+    char **argv = unity_files ? build_action_argv(&config, (const char **)unity_files) : NULL;
+    if (argv) {
+        json_t *previous_state = build_state_load(config.build_dir, 0);
+        state = build_state_capture(&config, argv, NULL, (const char **)unity_files, previous_state);
+        json_decref(previous_state);
+    }
+
+    free_string_list(argv);
+    free_string_list(unity_files);
+    free_config(&config);
+    return state;
+}
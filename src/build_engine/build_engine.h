@@ -1,6 +1,23 @@
 #ifndef BUILD_ENGINE_H
 #define BUILD_ENGINE_H
 
+#include <jansson.h>
+
+/**
+ * @struct BuildOptions
+ * @brief Command-line switches that change how a single build runs.
+ */
+typedef struct {
+    int profile_compile;               // --profile-compile: collect -ftime-trace/-ftime-report output and print hotspots
+    const char *output_path;           // overrides "output_path" from coda.json when set
+    const char **extra_compiler_flags; // NULL-terminated flags appended to "compiler_flags", or NULL
+    const char *build_dir;             // overrides "build_dir" (intermediate files) when set
+    const char *profile;               // appends the flags of this entry in "profiles" (e.g. written by `coda tune`)
+    const char **source_files;         // NULL-terminated list that replaces "source_files" when set
+    int reproducible;                  // --reproducible: as if coda.json set "reproducible": true
+    int disable_cache;                 // neither restore from nor store to the artifact cache
+} BuildOptions;
+
 /**
  * @brief Builds the project based on the configuration file.
  * @param config_path The path to the coda.json file.
@@ -8,4 +25,41 @@
  */
 int build_project(const char *config_path);
 
-#endif // BUILD_ENGINE_H
\ No newline at end of file
+/**
+ * @brief Builds the project with explicit build options.
+ * @param config_path The path to the coda.json file.
+ * @param options The build options; NULL means the defaults.
+ * @return 0 on success, 1 on failure.
+ */
+int build_project_with_options(const char *config_path, const BuildOptions *options);
+
+/**
+ * @brief Builds the project twice in reproducible mode, in two different build
+ * directories and without the artifact cache, and compares the outputs byte for byte.
+ * @param config_path The path to the coda.json file.
+ * @param options Build options applied to both builds; NULL means the defaults.
+ * @return 0 if both outputs are identical, 1 otherwise.
+ */
+int verify_reproducible_build(const char *config_path, const BuildOptions *options);
+
+/**
+ * @brief Builds every configuration in the "matrix" section of coda.json in one
+ * invocation. The configuration is parsed and the unity files are generated once;
+ * the configurations are then compiled concurrently, each with its own compiler
+ * flags, output path and build directory (<build_dir>/matrix/<name>/).
+ * @param config_path The path to the coda.json file.
+ * @param options Build options applied to every configuration; NULL means the defaults.
+ * @param jobs Maximum number of configurations compiled at once; 0 for the number of CPUs.
+ * @return 0 if every configuration built, 1 otherwise.
+ */
+int build_matrix(const char *config_path, const BuildOptions *options, int jobs);
+
+/**
+ * @brief Snapshots the inputs the next build would use (see build_state_capture())
+ * without generating unity files or running the compiler.
+ * @param config_path The path to the coda.json file.
+ * @return The snapshot (release with json_decref()), or NULL on failure.
+ */
+json_t *capture_next_build_state(const char *config_path);
+
+#endif // BUILD_ENGINE_H
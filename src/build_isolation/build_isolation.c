@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "build_isolation.h"
+
+#define CGROUP_MOUNT "/sys/fs/cgroup"
+// ioprio_set() has no C library wrapper; these mirror <linux/ioprio.h>
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_BE 2
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_LOWEST_LEVEL 7
+
+static int applied;                    // the settings are in effect for this process
+static char build_cgroup[PATH_MAX];    // the joined build cgroup; "" when not isolated in a cgroup
+static char original_cgroup[PATH_MAX]; // where this process ran before joining it
+
+// Reads the calling process's cgroup v2 directory from /proc/self/cgroup ("0::/path"). Returns 0 on success.
+static int current_cgroup(char *dir, size_t size) {
+    FILE *file = fopen("/proc/self/cgroup", "r");
+    if (!file) return 1;
+    char line[PATH_MAX];
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), file)) {
+        if (strncmp(line, "0::", 3) != 0) continue;
+        line[strcspn(line, "\n")] = '\0';
+        found = snprintf(dir, size, "%s%s", CGROUP_MOUNT, strcmp(line + 3, "/") == 0 ? "" : line + 3) < (int)size;
+    }
+    fclose(file);
+    return found ? 0 : 1;
+}
+
+// Returns 1 if a controller (e.g. "cpu") is listed in a cgroup interface file
+// such as cgroup.controllers or cgroup.subtree_control.
+static int lists_controller(const char *dir, const char *file_name, const char *controller) {
+    char path[PATH_MAX + 64], line[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, file_name);
+    FILE *file = fopen(path, "r");
+    if (!file) return 0;
+    int found = 0;
+    if (fgets(line, sizeof(line), file)) {
+        char *save = NULL;
+        for (char *name = strtok_r(line, " \n", &save); name && !found; name = strtok_r(NULL, " \n", &save)) {
+            found = strcmp(name, controller) == 0;
+        }
+    }
+    fclose(file);
+    return found;
+}
+
+static int has_controller(const char *dir, const char *controller) {
+    return lists_controller(dir, "cgroup.controllers", controller);
+}
+
+// Returns 1 if a cgroup holds a process other than this one (or cannot be read)
+static int has_other_processes(const char *dir) {
+    char path[PATH_MAX + 64];
+    snprintf(path, sizeof(path), "%s/cgroup.procs", dir);
+    FILE *file = fopen(path, "r");
+    if (!file) return 1;
+    long pid;
+    int other = 0;
+    while (!other && fscanf(file, "%ld", &pid) == 1) other = pid != (long)getpid();
+    fclose(file);
+    return other;
+}
+
+// Writes one value to a cgroup interface file. Returns 0 on success; errno describes a failure.
+static int write_cgroup_file(const char *dir, const char *name, const char *value) {
+    char path[PATH_MAX + 64];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *file = fopen(path, "w");
+    if (!file) return 1;
+    int failed = fputs(value, file) < 0;
+    // Writes reach the kernel on close, which is where invalid values are rejected
+    if (fclose(file) != 0) failed = 1;
+    return failed;
+}
+
+static int join_cgroup(const char *dir) {
+    char pid[32];
+    snprintf(pid, sizeof(pid), "%d", (int)getpid());
+    return write_cgroup_file(dir, "cgroup.procs", pid);
+}
+
+/**
+ * @brief Chooses the cgroup that the build cgroup is created under: the configured
+ * one, or the one Coda runs in. A process that already runs in a Coda cgroup
+ * (a build forked by `coda watch`) uses that cgroup's parent.
+ * @return 0 on success, 1 if cgroup v2 is not available.
+ */
+static int resolve_parent_cgroup(const IsolationSettings *settings, char *dir, size_t size) {
+    if (access(CGROUP_MOUNT "/cgroup.controllers", F_OK) != 0) return 1;
+    if (settings->cgroup) {
+        const char *path = settings->cgroup;
+        if (strncmp(path, CGROUP_MOUNT "/", strlen(CGROUP_MOUNT) + 1) == 0) {
+            snprintf(dir, size, "%s", path);
+        } else {
+            while (*path == '/') path++;
+            snprintf(dir, size, "%s/%s", CGROUP_MOUNT, path);
+        }
+        return 0;
+    }
+    if (current_cgroup(dir, size) != 0) return 1;
+    char *slash = strrchr(dir, '/');
+    if (slash && (strcmp(slash + 1, ISOLATION_BUILD_CGROUP) == 0 || strcmp(slash + 1, ISOLATION_SUPERVISOR_CGROUP) == 0)) {
+        *slash = '\0';
+    }
+    return 0;
+}
+
+// Moves this process back to where it ran before, and removes the build cgroup
+// unless a concurrent build (e.g. a matrix sibling) still runs in it.
+static void leave_cgroup(const char *dir, int remove) {
+    if (original_cgroup[0] != '\0') join_cgroup(original_cgroup);
+    if (remove) rmdir(dir);
+}
+
+/**
+ * @brief Joins the build cgroup and sets its limits. Nothing is left behind on
+ * failure: the process returns to its cgroup and a newly created build cgroup
+ * is removed.
+ * @param reason Receives why cgroups cannot be used.
+ * @return 0 on success, 1 on failure.
+ */
+static int apply_cgroup(const IsolationSettings *settings, char *reason, size_t reason_size) {
+    char parent[PATH_MAX], dir[PATH_MAX];
+    if (resolve_parent_cgroup(settings, parent, sizeof(parent)) != 0 ||
+        current_cgroup(original_cgroup, sizeof(original_cgroup)) != 0) {
+        snprintf(reason, reason_size, "cgroup v2 is not mounted at %s", CGROUP_MOUNT);
+        return 1;
+    }
+    if (snprintf(dir, sizeof(dir), "%s/%s", parent, ISOLATION_BUILD_CGROUP) >= (int)sizeof(dir)) {
+        snprintf(reason, reason_size, "the cgroup path is too long");
+        return 1;
+    }
+    if (!has_controller(parent, "cpu")) {
+        snprintf(reason, reason_size, "the cpu controller is not available in %s", parent);
+        return 1;
+    }
+
+    // 1. Check that the cpu controller can be handed to the build cgroup before
+    // moving anywhere: cgroup v2 only enables controllers for a cgroup's children
+    // while no process runs in it (the root cgroup excepted), so the parent may
+    // hold no process but this one, which is about to leave it.
+    int enable_cpu = !lists_controller(parent, "cgroup.subtree_control", "cpu");
+    if (enable_cpu && strcmp(parent, CGROUP_MOUNT) != 0 && has_other_processes(parent)) {
+        snprintf(reason, reason_size, "other processes run in %s, so it cannot enable the cpu controller; "
+                 "set \"isolation.cgroup\" to a delegated cgroup", parent);
+        return 1;
+    }
+
+    // 2. Create the build cgroup and move this process into it
+    int created = mkdir(dir, 0755) == 0;
+    if ((!created && errno != EEXIST) || join_cgroup(dir) != 0) {
+        snprintf(reason, reason_size, "cannot use %s: %s", dir, strerror(errno));
+        leave_cgroup(dir, created);
+        return 1;
+    }
+
+    // 3. Enable the controllers for the parent's children. Only the CPU controller is required.
+    if (enable_cpu && write_cgroup_file(parent, "cgroup.subtree_control", "+cpu") != 0) {
+        snprintf(reason, reason_size, "cannot enable the cpu controller in %s: %s", parent, strerror(errno));
+        leave_cgroup(dir, created);
+        return 1;
+    }
+    int have_io = has_controller(parent, "io") && write_cgroup_file(parent, "cgroup.subtree_control", "+io") == 0;
+    int have_memory = !settings->memory_high ||
+                      (has_controller(parent, "memory") && write_cgroup_file(parent, "cgroup.subtree_control", "+memory") == 0);
+
+    // 4. Set the limits
+    char value[64];
+    snprintf(value, sizeof(value), "%d", settings->cpu_weight);
+    if (write_cgroup_file(dir, "cpu.weight", value) != 0) {
+        snprintf(reason, reason_size, "cannot set cpu.weight in %s: %s", dir, strerror(errno));
+        leave_cgroup(dir, created);
+        return 1;
+    }
+    snprintf(value, sizeof(value), "default %d", settings->io_weight);
+    if (!have_io || write_cgroup_file(dir, "io.weight", value) != 0) {
+        fprintf(stderr, "[WARN] io.weight is not supported here; build I/O is not deprioritized.\n");
+    }
+    if (settings->memory_high && (!have_memory || write_cgroup_file(dir, "memory.high", settings->memory_high) != 0)) {
+        fprintf(stderr, "[WARN] Cannot set memory.high to '%s' in %s.\n", settings->memory_high, dir);
+    }
+
+    snprintf(build_cgroup, sizeof(build_cgroup), "%s", dir);
+    printf("[LOG] Build isolation: joined cgroup %s (cpu.weight %d, io.weight %d, memory.high %s).\n", dir,
+           settings->cpu_weight, settings->io_weight, settings->memory_high ? settings->memory_high : "max");
+    return 0;
+}
+
+// Lowers the CPU and I/O priority of this process; children inherit both. Returns 0 on success.
+static int apply_nice(const IsolationSettings *settings) {
+    int failed = 0;
+    errno = 0;
+    int current = getpriority(PRIO_PROCESS, 0);
+    if (errno == 0 && current < settings->nice_level && setpriority(PRIO_PROCESS, 0, settings->nice_level) != 0) {
+        failed = 1;
+    }
+#ifdef SYS_ioprio_set
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | IOPRIO_LOWEST_LEVEL) != 0) {
+        failed = 1;
+    }
+#endif
+    if (failed) {
+        perror("[WARN] Failed to lower the build priority");
+        return 1;
+    }
+    printf("[LOG] Build isolation: running at nice %d with the lowest best-effort I/O priority.\n", settings->nice_level);
+    return 0;
+}
+
+int build_isolation_apply(const IsolationSettings *settings) {
+    if (applied || !settings->mode || strcmp(settings->mode, "off") == 0) return 0;
+    applied = 1;
+
+    if (strcmp(settings->mode, "cgroup") == 0) {
+        char reason[PATH_MAX + 256];
+        if (apply_cgroup(settings, reason, sizeof(reason)) == 0) return 0;
+        fprintf(stderr, "[WARN] cgroup isolation unavailable (%s); falling back to nice/ionice.\n", reason);
+    }
+    return apply_nice(settings);
+}
+
+void build_isolation_release(void) {
+    if (build_cgroup[0] == '\0') return;
+    leave_cgroup(build_cgroup, 1);
+    build_cgroup[0] = '\0';
+    applied = 0; // a later build in this process joins a fresh build cgroup
+}
+
+void build_isolation_prepare_supervisor(const IsolationSettings *settings) {
+    if (!settings->mode || strcmp(settings->mode, "cgroup") != 0) return;
+    char parent[PATH_MAX], current[PATH_MAX], dir[PATH_MAX];
+    if (resolve_parent_cgroup(settings, parent, sizeof(parent)) != 0 || current_cgroup(current, sizeof(current)) != 0 ||
+        strcmp(parent, current) != 0) {
+        return; // cgroups are unavailable (builds report it), or the supervisor already runs elsewhere
+    }
+    // Failures are left to the builds, which fall back and say why
+    if (snprintf(dir, sizeof(dir), "%s/%s", parent, ISOLATION_SUPERVISOR_CGROUP) < (int)sizeof(dir) &&
+        (mkdir(dir, 0755) == 0 || errno == EEXIST)) {
+        join_cgroup(dir);
+    }
+}
+
+// Reads the "total=" of the "some" line of a pressure file, in seconds. Returns 0 on success.
+static int read_pressure_total(const char *name, double *seconds) {
+    char path[PATH_MAX + 64];
+    snprintf(path, sizeof(path), "%s/%s", build_cgroup, name);
+    FILE *file = fopen(path, "r");
+    if (!file) return 1;
+    char line[256];
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), file)) {
+        unsigned long long total_us;
+        const char *total = strstr(line, "total=");
+        if (strncmp(line, "some ", 5) == 0 && total && sscanf(total, "total=%llu", &total_us) == 1) {
+            *seconds = (double)total_us / 1e6;
+            found = 1;
+        }
+    }
+    fclose(file);
+    return found ? 0 : 1;
+}
+
+static long long read_memory_high_events() {
+    char path[PATH_MAX + 64];
+    snprintf(path, sizeof(path), "%s/memory.events", build_cgroup);
+    FILE *file = fopen(path, "r");
+    if (!file) return 0;
+    char line[256];
+    long long events = 0;
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "high %lld", &events) == 1) break;
+    }
+    fclose(file);
+    return events;
+}
+
+int build_isolation_read_usage(IsolationUsage *usage) {
+    memset(usage, 0, sizeof(*usage));
+    if (build_cgroup[0] == '\0') return 1;
+    // Pressure stall information needs CONFIG_PSI; without it there is nothing to report
+    if (read_pressure_total("cpu.pressure", &usage->cpu_stall_seconds) != 0) return 1;
+    read_pressure_total("memory.pressure", &usage->memory_stall_seconds);
+    read_pressure_total("io.pressure", &usage->io_stall_seconds);
+    usage->memory_high_events = read_memory_high_events();
+    return 0;
+}
+
+void build_isolation_report(const IsolationUsage *before, const IsolationUsage *after) {
+    printf("[LOG] Build isolation: throttled for %.2fs (CPU), %.2fs (memory), %.2fs (I/O)",
+           after->cpu_stall_seconds - before->cpu_stall_seconds,
+           after->memory_stall_seconds - before->memory_stall_seconds,
+           after->io_stall_seconds - before->io_stall_seconds);
+    long long high_events = after->memory_high_events - before->memory_high_events;
+    if (high_events > 0) printf("; memory.high was exceeded %lld time(s)", high_events);
+    printf(".\n");
+}
@@ -0,0 +1,69 @@
+#ifndef BUILD_ISOLATION_H
+#define BUILD_ISOLATION_H
+
+#include "project_mgr.h"
+
+// The cgroup v2 directory that builds join, created below the parent cgroup
+#define ISOLATION_BUILD_CGROUP "coda-build"
+// Where a long-running `coda watch` moves itself, so the parent has no processes of its own
+#define ISOLATION_SUPERVISOR_CGROUP "coda-watch"
+
+/**
+ * @struct IsolationUsage
+ * @brief Cumulative counters of the build cgroup. Builds are "throttled" when the
+ * kernel makes them wait so that other cgroups can run.
+ */
+typedef struct {
+    double cpu_stall_seconds;     // cpu.pressure "some" total: time a build task waited for a CPU
+    double memory_stall_seconds;  // memory.pressure "some" total (includes memory.high throttling)
+    double io_stall_seconds;      // io.pressure "some" total
+    long long memory_high_events; // memory.events "high": times memory.high was exceeded
+} IsolationUsage;
+
+/**
+ * @brief Makes the calling process, and every compiler or git process it starts
+ * afterwards, yield to other work on the host. In "cgroup" mode the process
+ * joins ISOLATION_BUILD_CGROUP, whose cpu.weight, io.weight and memory.high are
+ * set from the settings; if cgroup v2 is not mounted or not delegated to the
+ * user, it falls back to the "nice" mode: a nice value and the lowest
+ * best-effort I/O priority. Applying the same settings again does nothing.
+ * An unprivileged process cannot raise its priority again, so only processes
+ * that exist to build may call this: `coda build` and `coda install`, and the
+ * forked build children of watch, tune, bench, workspaces and matrix builds.
+ * @param settings The "isolation" section of coda.json.
+ * @return 0 on success (including mode "off"), 1 if nothing could be applied.
+ * Failures never fail the build.
+ */
+int build_isolation_apply(const IsolationSettings *settings);
+
+/**
+ * @brief Ends cgroup isolation once the build is done: the process moves back
+ * to the cgroup it came from and the build cgroup is removed, unless another
+ * build still runs in it. A lowered priority ("nice" mode) cannot be undone.
+ */
+void build_isolation_release(void);
+
+/**
+ * @brief Prepares a supervisor that starts builds from forked children (`coda watch`):
+ * in "cgroup" mode it moves itself into ISOLATION_SUPERVISOR_CGROUP, because
+ * cgroup v2 only lets a cgroup without processes of its own hand out CPU,
+ * memory and I/O limits to the build cgroup. The supervisor itself stays unlimited.
+ * @param settings The "isolation" section of coda.json.
+ */
+void build_isolation_prepare_supervisor(const IsolationSettings *settings);
+
+/**
+ * @brief Reads the counters of the build cgroup.
+ * @param usage Receives the counters.
+ * @return 0 on success, 1 if the process is not isolated in a cgroup.
+ */
+int build_isolation_read_usage(IsolationUsage *usage);
+
+/**
+ * @brief Prints how long a build was throttled between two readings.
+ * @param before Counters read before the build.
+ * @param after Counters read after the build.
+ */
+void build_isolation_report(const IsolationUsage *before, const IsolationUsage *after);
+
+#endif // BUILD_ISOLATION_H
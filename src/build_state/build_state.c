@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "build_state.h"
+#include "core_utils.h"
+#include "hash_utils.h"
+#include "toolchain.h"
+
+#define STATE_VERSION 1
+
+// Hashes a file, recording "missing" when it cannot be read (e.g. a deleted header).
+static json_t *hash_entry(const char *path) {
+    char hex[HASH_HEX_LEN];
+    return json_string(hash_file_hex(path, hex) == 0 ? hex : "missing");
+}
+
+// Returns the first line of `<compiler> --version`, or the compiler name if it cannot be run.
+static json_t *capture_compiler_version(const char *compiler) {
+    const Toolchain *toolchain = toolchain_probe(compiler);
+    if (!toolchain) {
+        return json_string(compiler);
+    }
+    char version[1024];
+    toolchain_version_line(toolchain, version, sizeof(version));
+    return json_string(version);
+}
+
+static int is_unity_file(const char *path, const char *const *unity_files) {
+    for (int i = 0; unity_files && unity_files[i] != NULL; i++) {
+        if (strcmp(path, unity_files[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Adds the prerequisites of a make-style depfile ("target: a.h b.h \")
+ * to the header object, hashing each one.
+ * @return 0 if the depfile was read, 1 otherwise.
+ */
+static int add_depfile_headers(json_t *headers, const char *depfile, const char *const *unity_files) {
+    char *content = read_file_to_string(depfile);
+    if (!content) return 1;
+
+    char *cursor = strchr(content, ':');
+    cursor = cursor ? cursor + 1 : content;
+    char path[4096];
+    size_t len = 0;
+    for (;; cursor++) {
+        char c = *cursor;
+        if (c == '\\' && (cursor[1] == '\n' || (cursor[1] == '\r' && cursor[2] == '\n'))) {
+            continue; // line continuation
+        }
+        if (c == '\\' && cursor[1] == ' ') {
+            c = ' '; // escaped space inside a path
+            cursor++;
+        } else if (c == '\0' || c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            if (len > 0) {
+                path[len] = '\0';
+                if (!is_unity_file(path, unity_files) && !json_object_get(headers, path)) {
+                    json_object_set_new(headers, path, hash_entry(path));
+                }
+                len = 0;
+            }
+            // A second rule (e.g. from -MP) starts after a newline; only the first one matters
+            if (c == '\0' || c == '\n') break;
+            continue;
+        }
+        if (len + 1 < sizeof(path)) path[len++] = c;
+    }
+    free(content);
+    return 0;
+}
+
+json_t *build_state_capture(const ProjectConfig *config, char *const *compile_argv, const char *const *depfiles,
+                            const char *const *unity_files, const json_t *previous) {
+    json_t *state = json_object();
+    json_t *argv = json_array();
+    json_t *sources = json_object();
+    json_t *headers = json_object();
+    json_t *dependencies = json_object();
+    if (!state || !argv || !sources || !headers || !dependencies) {
+        json_decref(state);
+        json_decref(argv);
+        json_decref(sources);
+        json_decref(headers);
+        json_decref(dependencies);
+        return NULL;
+    }
+
+    json_object_set_new(state, "version", json_integer(STATE_VERSION));
+    json_object_set_new(state, "target", json_string(config->output_path));
+    json_object_set_new(state, "project_name", json_string(config->project_name));
+    json_object_set_new(state, "compiler_version", capture_compiler_version(config->compiler));
+
+    for (int i = 0; compile_argv[i] != NULL; i++) {
+        json_array_append_new(argv, json_string(compile_argv[i]));
+    }
+    json_object_set_new(state, "argv", argv);
+
+    for (int i = 0; config->source_files && config->source_files[i] != NULL; i++) {
+        json_object_set_new(sources, config->source_files[i], hash_entry(config->source_files[i]));
+    }
+    json_object_set_new(state, "sources", sources);
+
+    // Headers come from the depfiles of this compile. When nothing was compiled
+    // (a cache hit, or `coda explain --next`), re-hash the last known header list.
+    int read_any = 0;
+    for (int i = 0; depfiles && depfiles[i] != NULL; i++) {
+        if (add_depfile_headers(headers, depfiles[i], unity_files) == 0) read_any = 1;
+    }
+    json_t *previous_headers = previous ? json_object_get(previous, "headers") : NULL;
+    if (!read_any && json_is_object(previous_headers)) {
+        const char *path;
+        json_t *value;
+        json_object_foreach(previous_headers, path, value) {
+            json_object_set_new(headers, path, hash_entry(path));
+        }
+    }
+    json_object_set_new(state, "headers", headers);
+
+    for (int i = 0; config->dependencies && config->dependencies[i] != NULL; i++) {
+        char repo_dir[4096], commit[128];
+        snprintf(repo_dir, sizeof(repo_dir), "modules/%s", config->dependencies[i]);
+        json_object_set_new(dependencies, config->dependencies[i],
+                            json_string(read_git_head(repo_dir, commit, sizeof(commit)) == 0 ? commit : "missing"));
+    }
+    json_object_set_new(state, "dependencies", dependencies);
+    return state;
+}
+
+// Returns "<build_dir>/coda-state.json" or, for the previous state, "<build_dir>/coda-state.prev.json"
+static void state_path(const char *build_dir, int previous, char *path, size_t size) {
+    snprintf(path, size, "%s/%s", build_dir, previous ? BUILD_STATE_PREVIOUS_FILE_NAME : BUILD_STATE_FILE_NAME);
+}
+
+int build_state_save(json_t *state, const char *build_dir, const char *action_key, const char *cache_result,
+                     const char *outcome, const BuildTimings *timings) {
+    json_object_set_new(state, "action_key", action_key ? json_string(action_key) : json_null());
+    json_object_set_new(state, "cache", json_string(cache_result));
+    json_object_set_new(state, "outcome", json_string(outcome));
+    if (timings) {
+        json_t *phases = json_object();
+        json_object_set_new(phases, "compile_seconds",
+                            timings->compile_seconds >= 0 ? json_real(timings->compile_seconds) : json_null());
+        json_object_set_new(phases, "link_seconds",
+                            timings->link_seconds >= 0 ? json_real(timings->link_seconds) : json_null());
+        if (timings->cpu_stall_seconds >= 0) {
+            json_object_set_new(phases, "cpu_stall_seconds", json_real(timings->cpu_stall_seconds));
+            json_object_set_new(phases, "memory_stall_seconds", json_real(timings->memory_stall_seconds));
+            json_object_set_new(phases, "io_stall_seconds", json_real(timings->io_stall_seconds));
+        }
+        json_object_set_new(state, "timings", phases);
+    }
+    json_object_set_new(state, "finished_at", json_integer((json_int_t)time(NULL)));
+    const char *build_id = getenv(BUILD_ID_ENV);
+    if (build_id) json_object_set_new(state, "build_id", json_string(build_id));
+
+    char path[4096], previous_path[4096];
+    state_path(build_dir, 0, path, sizeof(path));
+    state_path(build_dir, 1, previous_path, sizeof(previous_path));
+    if (access(path, F_OK) == 0 && rename(path, previous_path) != 0) {
+        perror("[WARN] Failed to rotate the previous build state");
+    }
+    if (json_dump_file(state, path, JSON_INDENT(2)) != 0) {
+        fprintf(stderr, "[WARN] Failed to write %s.\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+json_t *build_state_load(const char *build_dir, int previous) {
+    char path[4096];
+    state_path(build_dir, previous, path, sizeof(path));
+    if (access(path, F_OK) != 0) return NULL;
+    json_error_t error;
+    json_t *state = json_load_file(path, 0, &error);
+    if (!state || !json_is_object(state)) {
+        fprintf(stderr, "[WARN] Ignoring unreadable build state %s.\n", path);
+        json_decref(state);
+        return NULL;
+    }
+    return state;
+}
@@ -0,0 +1,68 @@
+#ifndef BUILD_STATE_H
+#define BUILD_STATE_H
+
+#include <jansson.h>
+
+#include "project_mgr.h"
+
+// The state of the most recent build, and of the one before it, inside the build directory
+#define BUILD_STATE_FILE_NAME "coda-state.json"
+#define BUILD_STATE_PREVIOUS_FILE_NAME "coda-state.prev.json"
+// Set by whoever starts a build (coda watch) to find the state that build saved; stored as "build_id"
+#define BUILD_ID_ENV "CODA_BUILD_ID"
+
+/**
+ * @struct BuildTimings
+ * @brief Wall-clock seconds spent in each phase of a compile; -1 for a phase that
+ * did not run on its own (a single unity file is compiled and linked in one step).
+ * The stall times say how long build isolation held the compile back; -1 when
+ * the build did not run in an isolation cgroup.
+ */
+typedef struct {
+    double compile_seconds;
+    double link_seconds;
+    double cpu_stall_seconds;
+    double memory_stall_seconds;
+    double io_stall_seconds;
+} BuildTimings;
+
+/**
+ * @brief Snapshots everything that decides whether a build has work to do:
+ * the compiler identity, the compiler argv, the content hash of every source
+ * file and every header listed in the depfiles, and the checked-out commit of
+ * every dependency under modules/.
+ * @param config The project configuration.
+ * @param compile_argv The NULL-terminated argv describing the compile action.
+ * @param depfiles NULL-terminated list of depfiles written by the compiler. Missing
+ * files are skipped; if none can be read, the header list of @p previous is re-hashed.
+ * @param unity_files NULL-terminated list of generated unity files, excluded from the headers.
+ * @param previous The last saved state, or NULL.
+ * @return A new JSON object owned by the caller, or NULL on failure.
+ */
+json_t *build_state_capture(const ProjectConfig *config, char *const *compile_argv, const char *const *depfiles,
+                            const char *const *unity_files, const json_t *previous);
+
+/**
+ * @brief Records how the build went and saves the state as BUILD_STATE_FILE_NAME,
+ * keeping the state it replaces as BUILD_STATE_PREVIOUS_FILE_NAME. The BUILD_ID_ENV
+ * variable, when set, is saved with it.
+ * @param state A snapshot from build_state_capture().
+ * @param build_dir The project's build directory.
+ * @param action_key The artifact cache key, or NULL when none was computed.
+ * @param cache_result "hit", "miss" or "disabled".
+ * @param outcome "compiled", "restored" or "failed".
+ * @param timings How long the compiler ran, or NULL when it did not run.
+ * @return 0 on success, 1 on failure. Failures never fail the build.
+ */
+int build_state_save(json_t *state, const char *build_dir, const char *action_key, const char *cache_result, const char *outcome,
+                     const BuildTimings *timings);
+
+/**
+ * @brief Loads a saved state.
+ * @param build_dir The project's build directory.
+ * @param previous 0 loads the most recent state, 1 the one before it.
+ * @return The state (release with json_decref()), or NULL if there is none.
+ */
+json_t *build_state_load(const char *build_dir, int previous);
+
+#endif // BUILD_STATE_H
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <netinet/in.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "cache_server_cmd.h"
+#include "hash_utils.h"
+#include "core_utils.h"
+
+#define HTTP_HEADER_MAX 8192
+#define CLIENT_TIMEOUT_SECONDS 30
+// Reject uploads larger than this to keep a misbehaving client from filling the disk.
+#define MAX_BLOB_SIZE (4LL * 1024 * 1024 * 1024)
+
+static int send_all(int sock, const void *data, size_t len) {
+    const char *bytes = (const char *)data;
+    while (len > 0) {
+        ssize_t n = send(sock, bytes, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 1;
+        }
+        bytes += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void send_status(int sock, int code, const char *reason) {
+    char response[256];
+    int len = snprintf(response, sizeof(response),
+                       "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", code, reason);
+    send_all(sock, response, (size_t)len);
+}
+
+/**
+ * @brief Streams a stored blob back to the client.
+ */
+static void handle_get(int sock, const char *blob_path, int head_only) {
+    int fd = open(blob_path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        send_status(sock, 404, "Not Found");
+        return;
+    }
+
+    char header[256];
+    int len = snprintf(header, sizeof(header),
+                       "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n"
+                       "Content-Length: %lld\r\nConnection: close\r\n\r\n", (long long)st.st_size);
+    if (send_all(sock, header, (size_t)len) == 0 && !head_only) {
+        char chunk[65536];
+        ssize_t n;
+        while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+            if (send_all(sock, chunk, (size_t)n) != 0) break;
+        }
+    }
+    close(fd);
+}
+
+/**
+ * @brief Receives an uploaded blob into a temporary file and renames it into place,
+ * so concurrent readers see either nothing or the complete blob.
+ */
+static void handle_put(int sock, const char *root_dir, const char *blob_path, long long content_length,
+                       const char *body, size_t body_len) {
+    if (content_length < 0 || content_length > MAX_BLOB_SIZE || (long long)body_len > content_length) {
+        send_status(sock, 400, "Bad Request");
+        return;
+    }
+
+    char temp_path[4096];
+    snprintf(temp_path, sizeof(temp_path), "%s/.upload.%d", root_dir, (int)getpid());
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        send_status(sock, 500, "Internal Server Error");
+        return;
+    }
+
+    int failed = body_len > 0 && write(fd, body, body_len) != (ssize_t)body_len;
+    long long received = (long long)body_len;
+    char chunk[65536];
+    while (!failed && received < content_length) {
+        size_t want = sizeof(chunk);
+        if ((long long)want > content_length - received) want = (size_t)(content_length - received);
+        ssize_t n = recv(sock, chunk, want, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0 || write(fd, chunk, (size_t)n) != n) {
+            failed = 1;
+            break;
+        }
+        received += n;
+    }
+    if (close(fd) != 0) failed = 1;
+
+    if (failed || rename(temp_path, blob_path) != 0) {
+        unlink(temp_path);
+        send_status(sock, 400, "Bad Request");
+        return;
+    }
+    send_status(sock, 201, "Created");
+}
+
+/**
+ * @brief Parses a single request on a connection and dispatches it.
+ */
+static void handle_client(int sock, const char *root_dir) {
+    struct timeval tv = { .tv_sec = CLIENT_TIMEOUT_SECONDS, .tv_usec = 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    char buffer[HTTP_HEADER_MAX];
+    size_t used = 0;
+    char *header_end = NULL;
+    while (!header_end) {
+        if (used + 1 >= sizeof(buffer)) {
+            send_status(sock, 431, "Request Header Fields Too Large");
+            return;
+        }
+        ssize_t n = recv(sock, buffer + used, sizeof(buffer) - used - 1, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        used += (size_t)n;
+        buffer[used] = '\0';
+        header_end = strstr(buffer, "\r\n\r\n");
+    }
+
+    char method[16], target[512];
+    if (sscanf(buffer, "%15s %511s HTTP/", method, target) != 2) {
+        send_status(sock, 400, "Bad Request");
+        return;
+    }
+
+    // Only the last path component is used, and it must be a hex digest,
+    // which rules out any path traversal. Prefixes such as "/cas/" are ignored.
+    const char *key = strrchr(target, '/');
+    key = key ? key + 1 : target;
+    if (!hash_is_valid_hex(key)) {
+        send_status(sock, 400, "Bad Request");
+        return;
+    }
+
+    char blob_path[4096];
+    snprintf(blob_path, sizeof(blob_path), "%s/%s", root_dir, key);
+
+    if (strcmp(method, "GET") == 0 || strcmp(method, "HEAD") == 0) {
+        printf("[CACHE] %s %.12s\n", method, key);
+        handle_get(sock, blob_path, strcmp(method, "HEAD") == 0);
+    } else if (strcmp(method, "PUT") == 0) {
+        long long content_length = -1;
+        for (char *line = strstr(buffer, "\r\n"); line && line < header_end; line = strstr(line + 2, "\r\n")) {
+            if (strncasecmp(line + 2, "Content-Length:", 15) == 0) {
+                content_length = strtoll(line + 2 + 15, NULL, 10);
+            }
+        }
+        char *body = header_end + 4;
+        printf("[CACHE] PUT %.12s (%lld bytes)\n", key, content_length);
+        handle_put(sock, root_dir, blob_path, content_length, body, used - (size_t)(body - buffer));
+    } else {
+        send_status(sock, 405, "Method Not Allowed");
+    }
+}
+
+int run_cache_server(const char *root_dir, int port) {
+    if (ensure_directory(root_dir) != 0) {
+        fprintf(stderr, "[ERROR] Failed to create cache directory '%s'.\n", root_dir);
+        return 1;
+    }
+
+    int server = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server < 0) {
+        perror("[ERROR] Failed to create socket");
+        return 1;
+    }
+    int reuse = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((unsigned short)port);
+    if (bind(server, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(server, 64) != 0) {
+        perror("[ERROR] Failed to listen");
+        close(server);
+        return 1;
+    }
+
+    // Each connection is served by its own child; ignoring SIGCHLD lets the kernel reap them.
+    signal(SIGCHLD, SIG_IGN);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    printf("Serving cache directory '%s' on http://0.0.0.0:%d. Press Ctrl+C to stop.\n", root_dir, port);
+
+    while (1) {
+        int client = accept(server, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            perror("[ERROR] accept failed");
+            break;
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(server);
+            handle_client(client, root_dir);
+            close(client);
+            _exit(0);
+        }
+        if (pid == -1) {
+            perror("[WARN] Failed to fork request handler");
+        }
+        close(client);
+    }
+    close(server);
+    return 1;
+}
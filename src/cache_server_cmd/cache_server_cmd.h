@@ -0,0 +1,14 @@
+#ifndef CACHE_SERVER_CMD_H
+#define CACHE_SERVER_CMD_H
+
+/**
+ * @brief Serves a directory as a content-addressed artifact cache over HTTP.
+ * Supports `GET /<key>`, `HEAD /<key>` and `PUT /<key>`, which is all the
+ * build engine's remote cache client needs.
+ * @param root_dir The directory holding cached blobs (created if missing).
+ * @param port The TCP port to listen on.
+ * @return 0 on clean shutdown, 1 on failure.
+ */
+int run_cache_server(const char *root_dir, int port);
+
+#endif // CACHE_SERVER_CMD_H
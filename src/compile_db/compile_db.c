@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <jansson.h>
+
+#include "compile_db.h"
+
+static json_t *entry_to_json(const char *directory, const CompileDbEntry *entry) {
+    json_t *object = json_object();
+    json_t *arguments = json_array();
+    for (int i = 0; entry->arguments[i] != NULL; i++) {
+        json_array_append_new(arguments, json_string(entry->arguments[i]));
+    }
+    json_object_set_new(object, "directory", json_string(directory));
+    json_object_set_new(object, "file", json_string(entry->file));
+    json_object_set_new(object, "arguments", arguments);
+    json_object_set_new(object, "output", json_string(entry->output));
+    return object;
+}
+
+// Returns the index of the entry for `file`, or -1 if there is none
+static int find_entry(const CompileDbEntry *entries, int count, const char *file) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(entries[i].file, file) == 0) return i;
+    }
+    return -1;
+}
+
+int compile_db_update(const char *db_path, const char *directory, const CompileDbEntry *entries, int count) {
+    // 1. Load the current database; a missing or unreadable one is rebuilt from scratch
+    json_t *current = NULL;
+    if (access(db_path, F_OK) == 0) {
+        json_error_t error;
+        current = json_load_file(db_path, 0, &error);
+        if (current && !json_is_array(current)) {
+            json_decref(current);
+            current = NULL;
+        }
+        if (!current) fprintf(stderr, "[WARN] Rewriting unreadable %s.\n", db_path);
+    }
+
+    // 2. Walk the existing entries in order, keeping foreign and unchanged ones
+    json_t *updated = json_array();
+    unsigned char *seen = (unsigned char *)calloc((size_t)count + 1, 1);
+    if (!updated || !seen) {
+        json_decref(updated);
+        json_decref(current);
+        free(seen);
+        return 1;
+    }
+    int changed = 0, added = 0, removed = 0;
+    size_t index;
+    json_t *old_entry;
+    json_array_foreach(current, index, old_entry) {
+        const char *old_directory = json_string_value(json_object_get(old_entry, "directory"));
+        const char *old_file = json_string_value(json_object_get(old_entry, "file"));
+        if (!old_directory || !old_file || strcmp(old_directory, directory) != 0) {
+            json_array_append(updated, old_entry); // another project's entry
+            continue;
+        }
+        int match = find_entry(entries, count, old_file);
+        if (match < 0 || seen[match]) {
+            removed++; // the file left the project (or was listed twice)
+            continue;
+        }
+        seen[match] = 1;
+        json_t *new_entry = entry_to_json(directory, &entries[match]);
+        if (!json_equal(old_entry, new_entry)) changed++;
+        json_array_append_new(updated, new_entry);
+    }
+    for (int i = 0; i < count; i++) {
+        if (seen[i]) continue;
+        json_array_append_new(updated, entry_to_json(directory, &entries[i]));
+        added++;
+    }
+    free(seen);
+    int rewrite = !current || changed + added + removed > 0;
+    json_decref(current);
+
+    // 3. Replace the file atomically, and only when something changed
+    int rc = 0;
+    if (rewrite) {
+        char temp_path[4096];
+        snprintf(temp_path, sizeof(temp_path), "%s.%d.tmp", db_path, (int)getpid());
+        if (json_dump_file(updated, temp_path, JSON_INDENT(2)) != 0 || rename(temp_path, db_path) != 0) {
+            unlink(temp_path);
+            fprintf(stderr, "[WARN] Failed to write %s.\n", db_path);
+            rc = 1;
+        } else {
+            printf("[LOG] Updated %s (%d changed, %d added, %d removed).\n", db_path, changed, added, removed);
+        }
+    }
+    json_decref(updated);
+    return rc;
+}
@@ -0,0 +1,31 @@
+#ifndef COMPILE_DB_H
+#define COMPILE_DB_H
+
+// The compilation database read by clangd and other tools, written to the project root
+#define COMPILE_DB_FILE_NAME "compile_commands.json"
+
+/**
+ * @struct CompileDbEntry
+ * @brief How one source file is compiled.
+ */
+typedef struct {
+    const char *file;         // the source file, relative to the project directory
+    char *const *arguments;   // NULL-terminated compiler argv
+    const char *output;       // the object file named by -o
+} CompileDbEntry;
+
+/**
+ * @brief Brings the compilation database up to date with the given entries.
+ * Entries of other directories are kept, entries of this directory whose file
+ * is no longer listed are removed, and only changed or new entries are
+ * replaced. Nothing is written when nothing changed, so tools watching the
+ * file do not re-index for nothing.
+ * @param db_path The compile_commands.json file.
+ * @param directory The absolute project directory the entries are relative to.
+ * @param entries The entries, one per source file.
+ * @param count The number of entries.
+ * @return 0 on success, 1 on failure. Failures never fail the build.
+ */
+int compile_db_update(const char *db_path, const char *directory, const CompileDbEntry *entries, int count);
+
+#endif // COMPILE_DB_H
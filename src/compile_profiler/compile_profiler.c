@@ -0,0 +1,453 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <jansson.h>
+
+#include "compile_profiler.h"
+#include "core_utils.h"
+#include "unity_analyzer.h"
+#include "toolchain.h"
+
+#define PROFILE_REPORT_NAME "compile-profile.json"
+#define REPORT_TOP_N 10
+#define GCC_REPORT_HEADER "Time variable"
+
+/**
+ * @struct ProfileEntry
+ * @brief The accumulated cost of one phase, header or function across all TUs.
+ */
+typedef struct {
+    char category[16];    // "phase", "header", "function" or "pass"
+    char name[512];
+    char origin[256];     // original source file, or "" when unknown
+    long long total_us;
+    int count;
+} ProfileEntry;
+
+/**
+ * @struct ProfileTable
+ * @brief The entries plus an open-addressing index over them, so each of the
+ * many thousand events of a large trace is merged in constant time.
+ */
+typedef struct {
+    ProfileEntry *items;
+    size_t count;
+    size_t capacity;
+    size_t *slots;        // index into items + 1; 0 marks an empty slot
+    size_t slot_count;    // a power of two, kept at least twice count
+} ProfileTable;
+
+/**
+ * @struct IncludeOrigin
+ * @brief An #include found in the unity file and the source file it came from.
+ */
+typedef struct {
+    char header[256];
+    char source[256];
+} IncludeOrigin;
+
+ProfilerKind detect_profiler_kind(const char *compiler) {
+    const Toolchain *toolchain = toolchain_probe(compiler);
+    if (!toolchain) {
+        return PROFILER_UNSUPPORTED;
+    }
+    if (toolchain->supports_time_trace) {
+        return PROFILER_CLANG_TIME_TRACE;
+    }
+    return toolchain->family == TOOLCHAIN_GCC ? PROFILER_GCC_TIME_REPORT : PROFILER_UNSUPPORTED;
+}
+
+const char *get_profiler_flag(ProfilerKind kind) {
+    switch (kind) {
+        case PROFILER_CLANG_TIME_TRACE: return "-ftime-trace";
+        case PROFILER_GCC_TIME_REPORT: return "-ftime-report";
+        default: return NULL;
+    }
+}
+
+void get_profile_output_path(ProfilerKind kind, const char *object_path, char *out, size_t out_size) {
+    // Strip the ".o" extension; clang names its trace "<object without .o>.json"
+    size_t base_len = strlen(object_path);
+    if (base_len > 2 && strcmp(object_path + base_len - 2, ".o") == 0) base_len -= 2;
+    snprintf(out, out_size, "%.*s%s", (int)base_len, object_path,
+             kind == PROFILER_CLANG_TIME_TRACE ? ".json" : ".time-report.txt");
+}
+
+void forward_profile_diagnostics(ProfilerKind kind, const char *profile_path) {
+    if (kind != PROFILER_GCC_TIME_REPORT) return;
+    char *content = read_file_to_string(profile_path);
+    if (!content) return;
+    char *report = strstr(content, GCC_REPORT_HEADER);
+    if (report) {
+        // The report starts on its own line; keep everything before that line
+        while (report > content && report[-1] != '\n') report--;
+        *report = '\0';
+    }
+    fputs(content, stderr);
+    free(content);
+}
+
+// Functions are keyed by their defining file too: static helpers of different files may share a name
+static int keyed_by_origin(const char *category) {
+    return strcmp(category, "function") == 0;
+}
+
+// FNV-1a over the entry key (category, name and, for functions, origin)
+static size_t hash_entry_key(const char *category, const char *name, const char *origin) {
+    const char *parts[] = { category, name, keyed_by_origin(category) ? origin : "" };
+    unsigned long long hash = 1469598103934665603ULL;
+    for (int i = 0; i < 3; i++) {
+        for (const unsigned char *c = (const unsigned char *)parts[i]; *c; c++) {
+            hash = (hash ^ *c) * 1099511628211ULL;
+        }
+        hash = (hash ^ 0xff) * 1099511628211ULL; // separates "ab"+"c" from "a"+"bc"
+    }
+    return (size_t)hash;
+}
+
+static int entry_matches(const ProfileEntry *entry, const char *category, const char *name, const char *origin) {
+    return strcmp(entry->category, category) == 0 && strncmp(entry->name, name, sizeof(entry->name) - 1) == 0 &&
+           (!keyed_by_origin(category) || strncmp(entry->origin, origin, sizeof(entry->origin) - 1) == 0);
+}
+
+// Doubles the index. Returns 0 on success.
+static int grow_slots(ProfileTable *table) {
+    size_t slot_count = table->slot_count ? table->slot_count * 2 : 256;
+    size_t *slots = (size_t *)calloc(slot_count, sizeof(size_t));
+    if (!slots) return 1;
+    for (size_t i = 0; i < table->count; i++) {
+        const ProfileEntry *entry = &table->items[i];
+        size_t slot = hash_entry_key(entry->category, entry->name, entry->origin) & (slot_count - 1);
+        while (slots[slot] != 0) slot = (slot + 1) & (slot_count - 1);
+        slots[slot] = i + 1;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->slot_count = slot_count;
+    return 0;
+}
+
+static void add_cost(ProfileTable *table, const char *category, const char *name, const char *origin, long long us) {
+    // The stored strings may have been truncated, so look them up the same way
+    char key_name[sizeof(((ProfileEntry *)0)->name)], key_origin[sizeof(((ProfileEntry *)0)->origin)];
+    snprintf(key_name, sizeof(key_name), "%s", name);
+    snprintf(key_origin, sizeof(key_origin), "%s", origin ? origin : "");
+    if ((table->count + 1) * 2 > table->slot_count && grow_slots(table) != 0) return;
+
+    size_t slot = hash_entry_key(category, key_name, key_origin) & (table->slot_count - 1);
+    for (; table->slots[slot] != 0; slot = (slot + 1) & (table->slot_count - 1)) {
+        ProfileEntry *entry = &table->items[table->slots[slot] - 1];
+        if (entry_matches(entry, category, key_name, key_origin)) {
+            entry->total_us += us;
+            entry->count++;
+            if (entry->origin[0] == '\0' && origin) snprintf(entry->origin, sizeof(entry->origin), "%s", origin);
+            return;
+        }
+    }
+    if (table->count == table->capacity) {
+        size_t new_capacity = table->capacity ? table->capacity * 2 : 128;
+        ProfileEntry *grown = (ProfileEntry *)realloc(table->items, new_capacity * sizeof(ProfileEntry));
+        if (!grown) return;
+        table->items = grown;
+        table->capacity = new_capacity;
+    }
+    table->slots[slot] = table->count + 1;
+    ProfileEntry *entry = &table->items[table->count++];
+    snprintf(entry->category, sizeof(entry->category), "%s", category);
+    snprintf(entry->name, sizeof(entry->name), "%s", key_name);
+    snprintf(entry->origin, sizeof(entry->origin), "%s", key_origin);
+    entry->total_us = us;
+    entry->count = 1;
+}
+
+/**
+ * @brief Records which original source file each #include of a unity file belongs
+ * to, using the "// File: <path>" markers written by the build engine.
+ */
+static void collect_include_origins(const char *unity_path, IncludeOrigin **origins, size_t *count) {
+    char *content = read_file_to_string(unity_path);
+    if (!content) return;
+
+    char current_source[256] = "";
+    char *save = NULL;
+    for (char *line = strtok_r(content, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        if (strncmp(line, "// File: ", 9) == 0) {
+            snprintf(current_source, sizeof(current_source), "%s", line + 9);
+            continue;
+        }
+        char *p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p != '#') continue;
+        p++;
+        while (isspace((unsigned char)*p)) p++;
+        if (strncmp(p, "include", 7) != 0) continue;
+        p += 7;
+        while (isspace((unsigned char)*p)) p++;
+        char close = (*p == '<') ? '>' : (*p == '"') ? '"' : '\0';
+        if (!close) continue;
+        char *end = strchr(p + 1, close);
+        if (!end) continue;
+
+        IncludeOrigin *grown = (IncludeOrigin *)realloc(*origins, (*count + 1) * sizeof(IncludeOrigin));
+        if (!grown) break;
+        *origins = grown;
+        snprintf((*origins)[*count].header, sizeof((*origins)[*count].header), "%.*s", (int)(end - p - 1), p + 1);
+        snprintf((*origins)[*count].source, sizeof((*origins)[*count].source), "%s", current_source);
+        (*count)++;
+    }
+    free(content);
+}
+
+// Finds the source file whose #include resolves to the given header path.
+static const char *find_include_origin(const char *header_path, const IncludeOrigin *origins, size_t count) {
+    size_t path_len = strlen(header_path);
+    for (size_t i = 0; i < count; i++) {
+        size_t name_len = strlen(origins[i].header);
+        if (name_len > path_len) continue;
+        const char *tail = header_path + path_len - name_len;
+        if (strcmp(tail, origins[i].header) == 0 && (tail == header_path || tail[-1] == '/')) {
+            return origins[i].source;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @struct SourceEvent
+ * @brief A "Source" (header parse) event from a clang time trace.
+ */
+typedef struct {
+    long long ts;
+    long long dur;
+    const char *path;
+} SourceEvent;
+
+// Orders by start time, and the enclosing (longer) event first on ties
+static int compare_source_events(const void *a, const void *b) {
+    const SourceEvent *left = (const SourceEvent *)a;
+    const SourceEvent *right = (const SourceEvent *)b;
+    if (left->ts != right->ts) return left->ts < right->ts ? -1 : 1;
+    if (left->dur != right->dur) return left->dur > right->dur ? -1 : 1;
+    return 0;
+}
+
+// Finds the source file defining a function. A static helper renamed in the unity
+// file (see UnityRename) carries its file's index; any other name belongs to its
+// first definition, since later files rename the names they share with it.
+static const char *find_function_origin(const char *name, const FunctionDefinition *definitions, int count,
+                                        const char **src_files) {
+    const char *marker = strstr(name, UNITY_RENAME_MARKER);
+    if (marker) {
+        int file_index = atoi(marker + strlen(UNITY_RENAME_MARKER));
+        int file_count = 0;
+        while (src_files[file_count] != NULL) file_count++;
+        return file_index >= 0 && file_index < file_count ? src_files[file_index] : NULL;
+    }
+    for (int i = 0; i < count; i++) {
+        if (strcmp(definitions[i].name, name) == 0) return src_files[definitions[i].file_index];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Aggregates one clang -ftime-trace file.
+ * Header costs are inclusive. Nested headers are attributed to the source file
+ * whose top-level #include pulled them in, found by time containment.
+ */
+static int aggregate_clang_trace(const char *trace_path, const char *unity_path, ProfileTable *table,
+                                 const FunctionDefinition *definitions, int definition_count, const char **src_files) {
+    json_error_t error;
+    json_t *root = json_load_file(trace_path, 0, &error);
+    if (!root) {
+        fprintf(stderr, "[WARN] Could not read time trace %s: %s\n", trace_path, error.text);
+        return 1;
+    }
+
+    IncludeOrigin *origins = NULL;
+    size_t origin_count = 0;
+    collect_include_origins(unity_path, &origins, &origin_count);
+
+    json_t *events = json_object_get(root, "traceEvents");
+    size_t event_count = json_array_size(events);
+    SourceEvent *sources = (SourceEvent *)calloc(event_count + 1, sizeof(SourceEvent));
+    size_t source_count = 0;
+
+    size_t index;
+    json_t *event;
+    json_array_foreach(events, index, event) {
+        const char *phase = json_string_value(json_object_get(event, "ph"));
+        const char *name = json_string_value(json_object_get(event, "name"));
+        if (!phase || !name || strcmp(phase, "X") != 0) continue;
+
+        long long ts = (long long)json_number_value(json_object_get(event, "ts"));
+        long long dur = (long long)json_number_value(json_object_get(event, "dur"));
+        const char *detail = json_string_value(json_object_get(json_object_get(event, "args"), "detail"));
+
+        if (strncmp(name, "Total ", 6) == 0) {
+            add_cost(table, "phase", name + 6, NULL, dur);
+        } else if (strcmp(name, "Source") == 0 && detail && sources) {
+            sources[source_count].ts = ts;
+            sources[source_count].dur = dur;
+            sources[source_count].path = detail;
+            source_count++;
+        } else if (detail && (strcmp(name, "ParseFunctionDefinition") == 0 || strcmp(name, "CodeGen Function") == 0 ||
+                              strcmp(name, "OptFunction") == 0 || strcmp(name, "InstantiateFunction") == 0)) {
+            // Report renamed statics under the name they have in their source file
+            char function[512];
+            snprintf(function, sizeof(function), "%s", detail);
+            char *marker = strstr(function, UNITY_RENAME_MARKER);
+            if (marker) *marker = '\0';
+            add_cost(table, "function", function,
+                     find_function_origin(detail, definitions, definition_count, src_files), dur);
+        }
+    }
+
+    // clang writes events as they finish (children first), so order them by start
+    // time; a "Source" event that starts after the previous top-level one ended is
+    // itself top-level, i.e. included directly from the unity file.
+    if (sources) {
+        qsort(sources, source_count, sizeof(SourceEvent), compare_source_events);
+        long long top_end = -1;
+        const char *top_origin = NULL;
+        for (size_t i = 0; i < source_count; i++) {
+            if (sources[i].ts >= top_end) {
+                top_end = sources[i].ts + sources[i].dur;
+                top_origin = find_include_origin(sources[i].path, origins, origin_count);
+            }
+            add_cost(table, "header", sources[i].path, top_origin, sources[i].dur);
+        }
+        free(sources);
+    }
+
+    free(origins);
+    json_decref(root);
+    return 0;
+}
+
+/**
+ * @brief Aggregates one gcc -ftime-report table. Lines look like
+ * " phase parsing   :   0.03 ( 43%)   0.00 (  0%)   0.03 ( 34%)  1374k ( 10%)"
+ * where the third column is wall time in seconds.
+ */
+static int aggregate_gcc_report(const char *report_path, ProfileTable *table) {
+    char *content = read_file_to_string(report_path);
+    if (!content) return 1;
+    char *report = strstr(content, GCC_REPORT_HEADER);
+    if (!report) {
+        free(content);
+        return 1;
+    }
+
+    char *save = NULL;
+    for (char *line = strtok_r(report, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        char *colon = strchr(line, ':');
+        if (!colon) continue;
+        double usr, sys, wall;
+        if (sscanf(colon + 1, " %lf ( %*d%%) %lf ( %*d%%) %lf", &usr, &sys, &wall) != 3) continue;
+
+        *colon = '\0';
+        char *name = line;
+        while (isspace((unsigned char)*name)) name++;
+        size_t len = strlen(name);
+        while (len > 0 && isspace((unsigned char)name[len - 1])) name[--len] = '\0';
+        if (len == 0 || strcmp(name, "TOTAL") == 0) continue;
+
+        long long us = (long long)(wall * 1e6);
+        if (strncmp(name, "phase ", 6) == 0) {
+            add_cost(table, "phase", name + 6, NULL, us);
+        } else {
+            add_cost(table, "pass", name, NULL, us);
+        }
+    }
+    free(content);
+    return 0;
+}
+
+static int compare_entries_by_cost(const void *a, const void *b) {
+    const ProfileEntry *left = (const ProfileEntry *)a;
+    const ProfileEntry *right = (const ProfileEntry *)b;
+    if (left->total_us == right->total_us) return 0;
+    return left->total_us < right->total_us ? 1 : -1;
+}
+
+static void print_category(const ProfileTable *table, const char *category, const char *title) {
+    int printed = 0;
+    for (size_t i = 0; i < table->count && printed < REPORT_TOP_N; i++) {
+        const ProfileEntry *entry = &table->items[i];
+        if (strcmp(entry->category, category) != 0) continue;
+        if (printed == 0) printf("\n%s\n", title);
+        printf("  %10.1f ms  x%-4d %s", entry->total_us / 1000.0, entry->count, entry->name);
+        if (entry->origin[0] != '\0') printf("  (from %s)", entry->origin);
+        printf("\n");
+        printed++;
+    }
+}
+
+int report_compile_profile(ProfilerKind kind, const char *build_dir, const char **unity_files, const char **src_files) {
+    ProfileTable table = { NULL, 0, 0, NULL, 0 };
+    FunctionDefinition *definitions = NULL;
+    int definition_count = 0;
+    if (kind == PROFILER_CLANG_TIME_TRACE) {
+        index_function_definitions(src_files, &definitions, &definition_count);
+    }
+
+    // 1. Aggregate the raw profile of every unity translation unit
+    int aggregated = 0;
+    for (int i = 0; unity_files[i] != NULL; i++) {
+        char profile_path[4096];
+        // The build engine names objects this way; the raw profile sits next to the object
+        char *object_path = derived_path_for(build_dir, unity_files[i], ".o");
+        if (!object_path) continue;
+        get_profile_output_path(kind, object_path, profile_path, sizeof(profile_path));
+        free(object_path);
+
+        int rc = (kind == PROFILER_CLANG_TIME_TRACE)
+                     ? aggregate_clang_trace(profile_path, unity_files[i], &table, definitions, definition_count, src_files)
+                     : aggregate_gcc_report(profile_path, &table);
+        if (rc == 0) aggregated++;
+    }
+    free(definitions);
+    free(table.slots); // sorting below reorders the items, which invalidates the index
+
+    if (aggregated == 0) {
+        fprintf(stderr, "[ERROR] No compile profiles were produced.\n");
+        free(table.items);
+        return 1;
+    }
+
+    // 2. Print the most expensive entries per category
+    qsort(table.items, table.count, sizeof(ProfileEntry), compare_entries_by_cost);
+    printf("\n===== Compile-time hotspots (%d translation unit%s) =====\n", aggregated, aggregated == 1 ? "" : "s");
+    print_category(&table, "phase", "Phases:");
+    print_category(&table, "pass", "Compiler passes:");
+    print_category(&table, "header", "Headers (inclusive parse time):");
+    print_category(&table, "function", "Functions:");
+    if (kind == PROFILER_GCC_TIME_REPORT) {
+        printf("\nNote: gcc only reports phases and passes; use clang for per-header and per-function costs.\n");
+    }
+
+    // 3. Save the full report for tooling
+    json_t *root = json_array();
+    for (size_t i = 0; i < table.count; i++) {
+        json_t *item = json_object();
+        json_object_set_new(item, "category", json_string(table.items[i].category));
+        json_object_set_new(item, "name", json_string(table.items[i].name));
+        json_object_set_new(item, "total_ms", json_real(table.items[i].total_us / 1000.0));
+        json_object_set_new(item, "count", json_integer(table.items[i].count));
+        if (table.items[i].origin[0] != '\0') {
+            json_object_set_new(item, "source_file", json_string(table.items[i].origin));
+        }
+        json_array_append_new(root, item);
+    }
+    char report_path[4096];
+    snprintf(report_path, sizeof(report_path), "%s/%s", build_dir, PROFILE_REPORT_NAME);
+    if (json_dump_file(root, report_path, JSON_INDENT(2)) != 0) {
+        fprintf(stderr, "[WARN] Failed to write %s.\n", report_path);
+    } else {
+        printf("\nFull report written to %s.\n", report_path);
+    }
+    json_decref(root);
+    free(table.items);
+    return 0;
+}
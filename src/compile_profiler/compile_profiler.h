@@ -0,0 +1,61 @@
+#ifndef COMPILE_PROFILER_H
+#define COMPILE_PROFILER_H
+
+#include <stddef.h>
+
+/**
+ * @brief The per-TU timing output a compiler can produce.
+ */
+typedef enum {
+    PROFILER_UNSUPPORTED,
+    PROFILER_CLANG_TIME_TRACE,  // clang -ftime-trace: Chrome trace JSON next to the object file
+    PROFILER_GCC_TIME_REPORT    // gcc -ftime-report: phase table printed to stderr
+} ProfilerKind;
+
+/**
+ * @brief Determines which profiling output the configured compiler supports.
+ * @param compiler The compiler executable (e.g. "clang", "gcc").
+ * @return The profiler kind, or PROFILER_UNSUPPORTED.
+ */
+ProfilerKind detect_profiler_kind(const char *compiler);
+
+/**
+ * @brief Returns the compiler flag that enables profiling output.
+ * @param kind The profiler kind.
+ * @return "-ftime-trace", "-ftime-report", or NULL.
+ */
+const char *get_profiler_flag(ProfilerKind kind);
+
+/**
+ * @brief Builds the path of the raw profile written for one object file.
+ * For clang this is where -ftime-trace puts its JSON; for gcc it is the file
+ * the build engine redirects the compiler's stderr into.
+ * @param kind The profiler kind.
+ * @param object_path The object file being produced (e.g. "build/temp_coda.o").
+ * @param out Buffer receiving the path.
+ * @param out_size Size of the buffer.
+ */
+void get_profile_output_path(ProfilerKind kind, const char *object_path, char *out, size_t out_size);
+
+/**
+ * @brief Prints the compiler diagnostics captured alongside a gcc time report,
+ * so warnings and errors are not hidden by profiling.
+ * @param kind The profiler kind.
+ * @param profile_path The raw profile of one translation unit.
+ */
+void forward_profile_diagnostics(ProfilerKind kind, const char *profile_path);
+
+/**
+ * @brief Aggregates the raw per-TU profiles into a report of the most expensive
+ * phases, headers and functions across the project, mapping each header and
+ * function back to the original source file that pulled it into the unity file.
+ * The report is printed and saved to <build_dir>/compile-profile.json.
+ * @param kind The profiler kind used for the build.
+ * @param build_dir The build directory holding the objects and raw profiles.
+ * @param unity_files NULL-terminated list of the generated unity files.
+ * @param src_files NULL-terminated list of the project's source files.
+ * @return 0 on success, 1 on failure.
+ */
+int report_compile_profile(ProfilerKind kind, const char *build_dir, const char **unity_files, const char **src_files);
+
+#endif // COMPILE_PROFILER_H
@@ -2,6 +2,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "process_runner.h"
 
 char *read_file_to_string(const char *path) {
     FILE *fp = fopen(path, "r");
@@ -29,4 +36,130 @@ char *read_file_to_string(const char *path) {
 
     fclose(fp);
     return buffer;
-}
\ No newline at end of file
+}
+
+int ensure_directory(const char *path) {
+    char buffer[4096];
+    if (snprintf(buffer, sizeof(buffer), "%s", path) >= (int)sizeof(buffer)) {
+        return 1;
+    }
+
+    // Create every intermediate component in turn
+    for (char *p = buffer + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(buffer, 0755) == -1 && errno != EEXIST) {
+                return 1;
+            }
+            *p = '/';
+        }
+    }
+    if (mkdir(buffer, 0755) == -1 && errno != EEXIST) {
+        return 1;
+    }
+    return 0;
+}
+
+int copy_file_atomic(const char *src_path, const char *dest_path, unsigned int mode) {
+    FILE *src = fopen(src_path, "rb");
+    if (!src) {
+        return 1;
+    }
+
+    char temp_path[4096];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp.%d", dest_path, (int)getpid());
+    FILE *dest = fopen(temp_path, "wb");
+    if (!dest) {
+        fclose(src);
+        return 1;
+    }
+
+    char chunk[65536];
+    size_t n;
+    int failed = 0;
+    while ((n = fread(chunk, 1, sizeof(chunk), src)) > 0) {
+        if (fwrite(chunk, 1, n, dest) != n) {
+            failed = 1;
+            break;
+        }
+    }
+    if (ferror(src)) failed = 1;
+    fclose(src);
+    if (fclose(dest) != 0) failed = 1;
+
+    if (failed || chmod(temp_path, mode) != 0 || rename(temp_path, dest_path) != 0) {
+        unlink(temp_path);
+        return 1;
+    }
+    return 0;
+}
+
+
+int run_command_to_file(char *const *argv, const char *stdout_path, const char *stderr_path) {
+    ProcessSpec spec = { 0 };
+    spec.argv = argv;
+    spec.stdout_path = stdout_path;
+    spec.stderr_path = stderr_path;
+    return process_run(&spec, NULL);
+}
+
+// Reads one line from a file into buf without the trailing newline. Returns 0 on success.
+static int read_first_line(const char *path, char *buf, size_t size) {
+    FILE *file = fopen(path, "r");
+    if (!file) return 1;
+    int ok = fgets(buf, (int)size, file) != NULL;
+    fclose(file);
+    if (!ok) return 1;
+    buf[strcspn(buf, "\r\n")] = '\0';
+    return 0;
+}
+
+char *derived_path_for(const char *build_dir, const char *path, const char *extension) {
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    size_t len = strlen(name);
+    size_t size = strlen(build_dir) + 1 + len + strlen(extension) + 1;
+    char *derived_path = (char *)malloc(size);
+    if (!derived_path) return NULL;
+    if (len > 2 && strcmp(name + len - 2, ".c") == 0) len -= 2;
+    snprintf(derived_path, size, "%s/%.*s%s", build_dir, (int)len, name, extension);
+    return derived_path;
+}
+
+int read_git_head(const char *repo_dir, char *commit, size_t size) {
+    char git_dir[2048], path[4096], line[2048];
+    snprintf(git_dir, sizeof(git_dir), "%s/.git", repo_dir);
+    // Worktrees and submodules use a ".git" file that points at the real directory
+    if (read_first_line(git_dir, line, sizeof(line)) == 0 && strncmp(line, "gitdir: ", 8) == 0) {
+        if (line[8] == '/') snprintf(git_dir, sizeof(git_dir), "%s", line + 8);
+        else snprintf(git_dir, sizeof(git_dir), "%s/%s", repo_dir, line + 8);
+    }
+
+    snprintf(path, sizeof(path), "%s/HEAD", git_dir);
+    if (read_first_line(path, line, sizeof(line)) != 0) return 1;
+    if (strncmp(line, "ref: ", 5) != 0) {
+        snprintf(commit, size, "%s", line); // detached HEAD
+        return 0;
+    }
+
+    char ref[sizeof(line)];
+    snprintf(ref, sizeof(ref), "%s", line + 5);
+    snprintf(path, sizeof(path), "%s/%s", git_dir, ref);
+    if (read_first_line(path, commit, size) == 0) return 0;
+
+    snprintf(path, sizeof(path), "%s/packed-refs", git_dir);
+    FILE *packed = fopen(path, "r");
+    if (!packed) return 1;
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), packed)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char *space = strchr(line, ' ');
+        if (space && strcmp(space + 1, ref) == 0) {
+            *space = '\0';
+            snprintf(commit, size, "%s", line);
+            found = 1;
+        }
+    }
+    fclose(packed);
+    return found ? 0 : 1;
+}
@@ -1,6 +1,8 @@
 #ifndef CORE_UTILS_H
 #define CORE_UTILS_H
 
+#include <stddef.h>
+
 /**
  * @brief Reads the entire content of a file into a dynamically allocated string.
  * @param path The path to the file.
@@ -9,4 +11,50 @@
  */
 char *read_file_to_string(const char *path);
 
+/**
+ * @brief Creates a directory and any missing parent directories (like `mkdir -p`).
+ * @param path The directory to create.
+ * @return 0 on success or if it already exists, 1 on failure.
+ */
+int ensure_directory(const char *path);
+
+/**
+ * @brief Copies a file, writing to a temporary name first and renaming it into place
+ * so that readers never observe a partially written destination.
+ * @param src_path The file to copy.
+ * @param dest_path The destination path.
+ * @param mode The permission bits for the destination (e.g. 0755 for executables).
+ * @return 0 on success, 1 on failure.
+ */
+int copy_file_atomic(const char *src_path, const char *dest_path, unsigned int mode);
+
+/**
+ * @brief Runs a command and waits for it, optionally redirecting its output to files.
+ * @param argv The NULL-terminated argument vector; argv[0] is looked up in PATH.
+ * @param stdout_path File that receives stdout, or NULL to inherit it.
+ * @param stderr_path File that receives stderr, or NULL to inherit it.
+ * @return 0 if the command exited with status 0, 1 otherwise.
+ */
+int run_command_to_file(char *const *argv, const char *stdout_path, const char *stderr_path);
+
+/**
+ * @brief Names a file derived from a source or unity file inside the build
+ * directory, e.g. ("build", "build/temp_coda_1.c", ".o") -> "build/temp_coda_1.o".
+ * @param build_dir The build directory.
+ * @param path The file the derived one belongs to; only its base name is used.
+ * @param extension Replaces a ".c" extension, e.g. ".o" or ".d".
+ * @return The allocated path, or NULL on failure. The caller frees it.
+ */
+char *derived_path_for(const char *build_dir, const char *path, const char *extension);
+
+/**
+ * @brief Resolves the commit checked out in a git working tree by reading
+ * .git/HEAD and the ref it points to (loose or packed), without running git.
+ * @param repo_dir The working tree, e.g. "." or "modules/libyaml".
+ * @param commit Receives the commit hash.
+ * @param size The size of the commit buffer.
+ * @return 0 on success, 1 if the directory is not a git checkout.
+ */
+int read_git_head(const char *repo_dir, char *commit, size_t size);
+
 #endif // CORE_UTILS_H
\ No newline at end of file
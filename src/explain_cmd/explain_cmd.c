@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "explain_cmd.h"
+#include "build_engine.h"
+#include "build_state.h"
+#include "project_mgr.h"
+
+// Returns a string member of a state, or "" when it is absent.
+static const char *state_string(const json_t *state, const char *key) {
+    const char *value = json_string_value(json_object_get(state, key));
+    return value ? value : "";
+}
+
+/**
+ * @brief Reports entries of a { path: hash } object that were added, removed or changed.
+ * @return The number of differences found.
+ */
+static int compare_hashes(const char *kind, const json_t *before, const json_t *after) {
+    int differences = 0;
+    const char *path;
+    json_t *value;
+    json_object_foreach((json_t *)after, path, value) {
+        const char *old_hash = json_string_value(json_object_get(before, path));
+        const char *new_hash = json_string_value(value);
+        if (!old_hash) {
+            printf("  - %s added: %s\n", kind, path);
+            differences++;
+        } else if (new_hash && strcmp(new_hash, "missing") == 0 && strcmp(old_hash, "missing") != 0) {
+            printf("  - %s removed: %s\n", kind, path);
+            differences++;
+        } else if (new_hash && strcmp(old_hash, new_hash) != 0) {
+            printf("  - %s changed: %s\n", kind, path);
+            differences++;
+        }
+    }
+    json_object_foreach((json_t *)before, path, value) {
+        if (!json_object_get(after, path)) {
+            printf("  - %s removed: %s\n", kind, path);
+            differences++;
+        }
+    }
+    return differences;
+}
+
+// Counts how often an argument occurs in a JSON argv array
+static int count_argument(const json_t *argv, const char *arg) {
+    int count = 0;
+    for (size_t i = 0; i < json_array_size(argv); i++) {
+        const char *value = json_string_value(json_array_get(argv, i));
+        if (value && strcmp(value, arg) == 0) count++;
+    }
+    return count;
+}
+
+// Prints the arguments of `argv` that occur more often there than in `other`
+static int report_extra_arguments(const json_t *argv, const json_t *other, const char *sign) {
+    int differences = 0;
+    for (size_t i = 0; i < json_array_size(argv); i++) {
+        const char *arg = json_string_value(json_array_get(argv, i));
+        if (!arg) continue;
+        // Report each distinct argument once, at its first occurrence
+        int seen_before = 0;
+        for (size_t j = 0; j < i && !seen_before; j++) {
+            const char *earlier = json_string_value(json_array_get(argv, j));
+            seen_before = earlier && strcmp(earlier, arg) == 0;
+        }
+        if (seen_before) continue;
+        int extra = count_argument(argv, arg) - count_argument(other, arg);
+        for (int k = 0; k < extra; k++) {
+            printf("      %s %s\n", sign, arg);
+            differences++;
+        }
+    }
+    return differences;
+}
+
+/**
+ * @brief Reports compiler argv differences. Pure reorderings are reported as
+ * one difference because argument order can change the result.
+ * @return The number of differences found.
+ */
+static int compare_argv(const json_t *before, const json_t *after) {
+    if (json_equal(before, after)) return 0;
+    printf("  - compiler arguments changed:\n");
+    int differences = report_extra_arguments(after, before, "+");
+    differences += report_extra_arguments(before, after, "-");
+    if (differences == 0) {
+        printf("      (same arguments in a different order)\n");
+        differences = 1;
+    }
+    return differences;
+}
+
+/**
+ * @brief Reports dependency commit bumps and added or removed dependencies.
+ * @return The number of differences found.
+ */
+static int compare_dependencies(const json_t *before, const json_t *after) {
+    int differences = 0;
+    const char *name;
+    json_t *value;
+    json_object_foreach((json_t *)after, name, value) {
+        const char *old_commit = json_string_value(json_object_get(before, name));
+        const char *new_commit = json_string_value(value);
+        if (!old_commit) {
+            printf("  - dependency added: %s at %.12s\n", name, new_commit ? new_commit : "?");
+            differences++;
+        } else if (new_commit && strcmp(old_commit, new_commit) != 0) {
+            printf("  - dependency bumped: %s %.12s -> %.12s\n", name, old_commit, new_commit);
+            differences++;
+        }
+    }
+    json_object_foreach((json_t *)before, name, value) {
+        if (!json_object_get(after, name)) {
+            printf("  - dependency removed: %s\n", name);
+            differences++;
+        }
+    }
+    return differences;
+}
+
+// Compares two states and prints every input difference. Returns the number found.
+static int report_input_changes(const json_t *before, const json_t *after) {
+    int differences = 0;
+    const char *old_compiler = state_string(before, "compiler_version");
+    const char *new_compiler = state_string(after, "compiler_version");
+    if (strcmp(old_compiler, new_compiler) != 0) {
+        printf("  - compiler changed: %s -> %s\n", old_compiler, new_compiler);
+        differences++;
+    }
+    differences += compare_argv(json_object_get(before, "argv"), json_object_get(after, "argv"));
+    differences += compare_hashes("source", json_object_get(before, "sources"), json_object_get(after, "sources"));
+    differences += compare_hashes("header", json_object_get(before, "headers"), json_object_get(after, "headers"));
+    differences += compare_dependencies(json_object_get(before, "dependencies"), json_object_get(after, "dependencies"));
+    return differences;
+}
+
+// Explains the cache outcome of the last build given how many inputs changed
+static void report_last_cache_result(const json_t *state, int differences) {
+    const char *cache = state_string(state, "cache");
+    const char *key = state_string(state, "action_key");
+    if (strcmp(state_string(state, "outcome"), "restored") == 0) {
+        printf("Nothing was compiled: the artifact for action key %.16s was restored from the cache.\n", key);
+    } else if (strcmp(cache, "disabled") == 0) {
+        printf("The artifact cache was not consulted (\"cache\": false, or a --profile-compile build), so the build always compiles.\n");
+    } else if (differences == 0) {
+        printf("Cache miss: no input changed, but the artifact for action key %.16s was in neither the local nor the remote cache.\n", key);
+    } else {
+        printf("Cache miss on the new action key %.16s, as expected after the changes above.\n", key);
+    }
+}
+
+int explain_build(const char *config_path, const char *target, int next_build) {
+    ProjectConfig config;
+    if (parse_config_from_file(config_path, &config) != 0) {
+        fprintf(stderr, "Error: Failed to parse configuration from %s.\n", config_path);
+        return 1;
+    }
+    json_t *last = build_state_load(config.build_dir, 0);
+    json_t *previous = next_build ? NULL : build_state_load(config.build_dir, 1);
+    if (!last) {
+        fprintf(stderr, "No build state found in %s/%s. Run 'coda build' first.\n", config.build_dir, BUILD_STATE_FILE_NAME);
+        json_decref(previous);
+        free_config(&config);
+        return 1;
+    }
+    free_config(&config);
+
+    json_t *before = NULL;
+    json_t *after = NULL;
+    if (next_build) {
+        after = capture_next_build_state(config_path);
+        if (!after) {
+            json_decref(last);
+            return 1;
+        }
+        before = last;
+    } else {
+        before = previous;
+        after = last;
+    }
+
+    if (target && strcmp(target, state_string(after, "target")) != 0 &&
+        strcmp(target, state_string(after, "project_name")) != 0) {
+        fprintf(stderr, "Error: Unknown target '%s'. This project builds '%s'.\n", target, state_string(after, "target"));
+        json_decref(before);
+        json_decref(after);
+        return 1;
+    }
+
+    if (next_build) {
+        printf("Next build of %s, compared with the last build:\n", state_string(after, "target"));
+        int differences = report_input_changes(before, after);
+        if (differences > 0) {
+            printf("The next build has %d changed input(s) and will compile unless the new action is already cached.\n", differences);
+        } else if (strcmp(state_string(before, "outcome"), "failed") == 0) {
+            printf("  (no input changed)\nThe last build failed, so the next build will compile again.\n");
+        } else if (strcmp(state_string(before, "cache"), "disabled") == 0) {
+            printf("  (no input changed)\nThe artifact cache is not used, so the next build will compile anyway.\n");
+        } else {
+            printf("  (no input changed)\nThe next build will restore action key %.16s from the cache.\n",
+                   state_string(before, "action_key"));
+        }
+    } else {
+        printf("Last build of %s: %s (cache %s).\n", state_string(after, "target"),
+               state_string(after, "outcome"), state_string(after, "cache"));
+        if (!before) {
+            printf("  - no earlier build recorded; everything was built from scratch\n");
+        } else {
+            int differences = report_input_changes(before, after);
+            if (differences == 0) printf("  (no input changed since the build before it)\n");
+            report_last_cache_result(after, differences);
+        }
+    }
+
+    json_decref(before);
+    json_decref(after);
+    return 0;
+}
@@ -0,0 +1,15 @@
+#ifndef EXPLAIN_CMD_H
+#define EXPLAIN_CMD_H
+
+/**
+ * @brief Explains why the last build did work, or what the next build will do,
+ * by comparing the persisted build states: changed sources and headers, compiler
+ * argv differences, compiler upgrades, dependency commit bumps and cache misses.
+ * @param config_path The path to the coda.json file.
+ * @param target The target to explain (output path or project name), or NULL for the project's target.
+ * @param next_build 0 explains the last build, 1 explains the next one.
+ * @return 0 on success, 1 on failure.
+ */
+int explain_build(const char *config_path, const char *target, int next_build);
+
+#endif // EXPLAIN_CMD_H
@@ -1,6 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
 #include "fs_monitor.h"
 
-// Tidak ada implementasi di sini, karena logika utama `inotify` sudah
-// ada di dalam file `watch_cmd.c`. Modul ini bisa diisi di kemudian hari
-// jika kita memutuskan untuk memisahkan fungsionalitas `inotify` ke modul
-// yang lebih terisolasi.
\ No newline at end of file
+// IN_CLOSE_WRITE rather than IN_MODIFY: a file is only worth rebuilding once the writer is done with it
+#define WATCH_MASK (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+#define EVENT_BUF_LEN (64 * (sizeof(struct inotify_event) + NAME_MAX + 1))
+
+// pidfd_open() is called through syscall() so Coda still builds against older C libraries
+static int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static int add_to_epoll(int epoll_fd, int fd) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void push_event(FsMonitor *monitor, const FsEvent *event) {
+    if (monitor->queue_count == FS_MONITOR_QUEUE_SIZE) {
+        // Queue full: a change is already pending, which is all a rebuild needs to know
+        if (event->type == FS_EVENT_CHANGE) return;
+        monitor->queue_head = (monitor->queue_head + 1) % FS_MONITOR_QUEUE_SIZE;
+        monitor->queue_count--;
+    }
+    int tail = (monitor->queue_head + monitor->queue_count) % FS_MONITOR_QUEUE_SIZE;
+    monitor->queue[tail] = *event;
+    monitor->queue_count++;
+}
+
+int fs_monitor_init(FsMonitor *monitor) {
+    memset(monitor, 0, sizeof(*monitor));
+    monitor->epoll_fd = monitor->inotify_fd = monitor->signal_fd = -1;
+
+    // Signals are consumed through a signalfd instead of asynchronous handlers
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGCHLD);
+    if (sigprocmask(SIG_BLOCK, &mask, &monitor->previous_mask) != 0) {
+        perror("sigprocmask failed");
+        return 1;
+    }
+
+    monitor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    monitor->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    monitor->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (monitor->epoll_fd < 0 || monitor->inotify_fd < 0 || monitor->signal_fd < 0 ||
+        add_to_epoll(monitor->epoll_fd, monitor->inotify_fd) != 0 ||
+        add_to_epoll(monitor->epoll_fd, monitor->signal_fd) != 0) {
+        perror("Failed to set up the file system monitor");
+        fs_monitor_close(monitor);
+        return 1;
+    }
+    return 0;
+}
+
+int fs_monitor_add_directory(FsMonitor *monitor, const char *path) {
+    if (monitor->watch_count == FS_MONITOR_MAX_WATCHES) {
+        fprintf(stderr, "Warning: watch limit reached; not watching '%s'.\n", path);
+        return 1;
+    }
+    int wd = inotify_add_watch(monitor->inotify_fd, path, WATCH_MASK);
+    if (wd < 0) {
+        perror("inotify_add_watch failed");
+        return 1;
+    }
+    monitor->watch_descriptors[monitor->watch_count] = wd;
+    monitor->watch_paths[monitor->watch_count] = strdup(path);
+    monitor->watch_count++;
+
+    // Recurse into subdirectories, skipping hidden ones
+    DIR *dir = opendir(path);
+    if (!dir) return 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        char child_path[1024];
+        struct stat st;
+        snprintf(child_path, sizeof(child_path), "%s/%s", path, entry->d_name);
+        if (stat(child_path, &st) == 0 && S_ISDIR(st.st_mode)) {
+            fs_monitor_add_directory(monitor, child_path);
+        }
+    }
+    closedir(dir);
+    return 0;
+}
+
+int fs_monitor_track_child(FsMonitor *monitor, pid_t pid) {
+    if (monitor->child_count == FS_MONITOR_MAX_CHILDREN) {
+        fprintf(stderr, "Error: too many tracked child processes.\n");
+        return 1;
+    }
+    int pidfd = open_pidfd(pid);
+    if (pidfd >= 0 && add_to_epoll(monitor->epoll_fd, pidfd) != 0) {
+        close(pidfd);
+        pidfd = -1;
+    }
+    // Without a pidfd the child is still noticed through SIGCHLD on the signalfd
+    monitor->child_pids[monitor->child_count] = pid;
+    monitor->child_pidfds[monitor->child_count] = pidfd;
+    monitor->child_count++;
+    return 0;
+}
+
+// Reaps a tracked child if it has exited, queueing FS_EVENT_CHILD_EXIT.
+static void reap_child(FsMonitor *monitor, int index) {
+    int status;
+    struct rusage usage;
+    pid_t pid = monitor->child_pids[index];
+    if (wait4(pid, &status, WNOHANG, &usage) != pid) return;
+
+    if (monitor->child_pidfds[index] >= 0) {
+        epoll_ctl(monitor->epoll_fd, EPOLL_CTL_DEL, monitor->child_pidfds[index], NULL);
+        close(monitor->child_pidfds[index]);
+    }
+    monitor->child_count--;
+    monitor->child_pids[index] = monitor->child_pids[monitor->child_count];
+    monitor->child_pidfds[index] = monitor->child_pidfds[monitor->child_count];
+
+    FsEvent event;
+    memset(&event, 0, sizeof(event));
+    event.type = FS_EVENT_CHILD_EXIT;
+    event.child_pid = pid;
+    event.child_status = status;
+    event.child_usage = usage;
+    push_event(monitor, &event);
+}
+
+static const char *find_watch_path(const FsMonitor *monitor, int wd) {
+    for (int i = 0; i < monitor->watch_count; i++) {
+        if (monitor->watch_descriptors[i] == wd) return monitor->watch_paths[i];
+    }
+    return NULL;
+}
+
+static void drain_inotify(FsMonitor *monitor) {
+    char buffer[EVENT_BUF_LEN] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t length = read(monitor->inotify_fd, buffer, sizeof(buffer));
+        if (length <= 0) return;
+
+        for (ssize_t i = 0; i < length;) {
+            struct inotify_event *ev = (struct inotify_event *)&buffer[i];
+            i += (ssize_t)(sizeof(struct inotify_event) + ev->len);
+
+            const char *dir_path = find_watch_path(monitor, ev->wd);
+            if (!dir_path || ev->len == 0 || ev->name[0] == '.') continue;
+
+            FsEvent event;
+            memset(&event, 0, sizeof(event));
+            event.type = FS_EVENT_CHANGE;
+            snprintf(event.path, sizeof(event.path), "%s/%s", dir_path, ev->name);
+            if ((ev->mask & (IN_CREATE | IN_MOVED_TO)) && (ev->mask & IN_ISDIR)) {
+                fs_monitor_add_directory(monitor, event.path);
+            }
+            push_event(monitor, &event);
+        }
+    }
+}
+
+static void drain_signals(FsMonitor *monitor) {
+    struct signalfd_siginfo info;
+    while (read(monitor->signal_fd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+        if (info.ssi_signo == SIGCHLD) {
+            // Only children without a pidfd need this; the rest are reaped via their pidfd
+            for (int i = monitor->child_count - 1; i >= 0; i--) {
+                if (monitor->child_pidfds[i] < 0) reap_child(monitor, i);
+            }
+            continue;
+        }
+        FsEvent event;
+        memset(&event, 0, sizeof(event));
+        event.type = FS_EVENT_SIGNAL;
+        event.signal_number = (int)info.ssi_signo;
+        push_event(monitor, &event);
+    }
+}
+
+int fs_monitor_next_event(FsMonitor *monitor, int timeout_ms, FsEvent *event) {
+    while (monitor->queue_count == 0) {
+        struct epoll_event ready[16];
+        int count = epoll_wait(monitor->epoll_fd, ready, 16, timeout_ms);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait failed");
+            return -1;
+        }
+        if (count == 0) return 0;
+
+        for (int i = 0; i < count; i++) {
+            int fd = ready[i].data.fd;
+            if (fd == monitor->inotify_fd) {
+                drain_inotify(monitor);
+            } else if (fd == monitor->signal_fd) {
+                drain_signals(monitor);
+            } else {
+                for (int c = 0; c < monitor->child_count; c++) {
+                    if (monitor->child_pidfds[c] == fd) {
+                        reap_child(monitor, c);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    *event = monitor->queue[monitor->queue_head];
+    monitor->queue_head = (monitor->queue_head + 1) % FS_MONITOR_QUEUE_SIZE;
+    monitor->queue_count--;
+    return 1;
+}
+
+void fs_monitor_restore_signal_mask(const FsMonitor *monitor) {
+    sigprocmask(SIG_SETMASK, &monitor->previous_mask, NULL);
+}
+
+void fs_monitor_close(FsMonitor *monitor) {
+    for (int i = 0; i < monitor->watch_count; i++) {
+        if (monitor->inotify_fd >= 0) inotify_rm_watch(monitor->inotify_fd, monitor->watch_descriptors[i]);
+        free(monitor->watch_paths[i]);
+    }
+    monitor->watch_count = 0;
+    for (int i = 0; i < monitor->child_count; i++) {
+        if (monitor->child_pidfds[i] >= 0) close(monitor->child_pidfds[i]);
+    }
+    monitor->child_count = 0;
+    if (monitor->inotify_fd >= 0) close(monitor->inotify_fd);
+    if (monitor->signal_fd >= 0) close(monitor->signal_fd);
+    if (monitor->epoll_fd >= 0) close(monitor->epoll_fd);
+    monitor->inotify_fd = monitor->signal_fd = monitor->epoll_fd = -1;
+    fs_monitor_restore_signal_mask(monitor);
+}
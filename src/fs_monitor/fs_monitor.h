@@ -1,8 +1,108 @@
 #ifndef FS_MONITOR_H
 #define FS_MONITOR_H
 
-// Tidak ada fungsi publik yang dibutuhkan di luar modul ini,
-// karena `watch_cmd` memanggil fungsionalitasnya secara internal.
-// Header ini hanya untuk definisi internal jika diperlukan.
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/types.h>
 
-#endif // FS_MONITOR_H
\ No newline at end of file
+#define FS_MONITOR_MAX_WATCHES 1024
+#define FS_MONITOR_MAX_CHILDREN 64
+#define FS_MONITOR_QUEUE_SIZE 128
+
+/**
+ * @brief The kinds of events delivered by the monitor's epoll loop.
+ */
+typedef enum {
+    FS_EVENT_CHANGE,      // a file in a watched directory was modified, created, moved or deleted
+    FS_EVENT_SIGNAL,      // SIGINT or SIGTERM arrived (through a signalfd, never a handler)
+    FS_EVENT_CHILD_EXIT   // a tracked child process exited and has been reaped
+} FsEventType;
+
+/**
+ * @struct FsEvent
+ * @brief One event returned by fs_monitor_next_event().
+ */
+typedef struct {
+    FsEventType type;
+    char path[1024];      // FS_EVENT_CHANGE: "<watched dir>/<name>"
+    int signal_number;    // FS_EVENT_SIGNAL
+    pid_t child_pid;      // FS_EVENT_CHILD_EXIT
+    int child_status;     // FS_EVENT_CHILD_EXIT: raw status as returned by waitpid()
+    struct rusage child_usage; // FS_EVENT_CHILD_EXIT: usage of the child and the descendants it waited for
+} FsEvent;
+
+/**
+ * @struct FsMonitor
+ * @brief An epoll-based event engine that multiplexes an inotify descriptor,
+ * a signalfd for SIGINT/SIGTERM and a pidfd per tracked child process.
+ * Initialize with fs_monitor_init() and release with fs_monitor_close().
+ */
+typedef struct {
+    int epoll_fd;
+    int inotify_fd;
+    int signal_fd;
+    sigset_t previous_mask;
+
+    int watch_count;
+    int watch_descriptors[FS_MONITOR_MAX_WATCHES];
+    char *watch_paths[FS_MONITOR_MAX_WATCHES];
+
+    int child_count;
+    pid_t child_pids[FS_MONITOR_MAX_CHILDREN];
+    int child_pidfds[FS_MONITOR_MAX_CHILDREN]; // -1 when pidfd_open() is unavailable (SIGCHLD fallback)
+
+    int queue_head;
+    int queue_count;
+    FsEvent queue[FS_MONITOR_QUEUE_SIZE];
+} FsMonitor;
+
+/**
+ * @brief Creates the epoll, inotify and signalfd descriptors.
+ * SIGINT, SIGTERM and SIGCHLD are blocked for the calling thread so they are
+ * only ever delivered through the signalfd.
+ * @param monitor The monitor to initialize.
+ * @return 0 on success, 1 on failure.
+ */
+int fs_monitor_init(FsMonitor *monitor);
+
+/**
+ * @brief Watches a directory and all of its subdirectories. Directories created
+ * later inside a watched directory are picked up automatically.
+ * @param monitor The monitor.
+ * @param path The directory to watch.
+ * @return 0 on success, 1 on failure.
+ */
+int fs_monitor_add_directory(FsMonitor *monitor, const char *path);
+
+/**
+ * @brief Starts tracking a child process; its exit is reported as FS_EVENT_CHILD_EXIT.
+ * @param monitor The monitor.
+ * @param pid The child to track.
+ * @return 0 on success, 1 on failure.
+ */
+int fs_monitor_track_child(FsMonitor *monitor, pid_t pid);
+
+/**
+ * @brief Waits for the next event.
+ * @param monitor The monitor.
+ * @param timeout_ms Maximum time to wait; -1 waits forever.
+ * @param event Receives the event.
+ * @return 1 if an event was returned, 0 on timeout, -1 on error.
+ */
+int fs_monitor_next_event(FsMonitor *monitor, int timeout_ms, FsEvent *event);
+
+/**
+ * @brief Restores the signal mask that was active before fs_monitor_init().
+ * Child processes call this right after fork() so they behave normally.
+ * @param monitor The monitor.
+ */
+void fs_monitor_restore_signal_mask(const FsMonitor *monitor);
+
+/**
+ * @brief Closes all descriptors, removes all watches and restores the signal mask.
+ * Tracked children are not killed or reaped.
+ * @param monitor The monitor.
+ */
+void fs_monitor_close(FsMonitor *monitor);
+
+#endif // FS_MONITOR_H
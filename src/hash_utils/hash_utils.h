@@ -0,0 +1,74 @@
+#ifndef HASH_UTILS_H
+#define HASH_UTILS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Length of a hex-encoded SHA-256 digest, including the null terminator.
+#define HASH_HEX_LEN 65
+
+/**
+ * @struct HashContext
+ * @brief Streaming SHA-256 state used for content-addressed keys.
+ */
+typedef struct {
+    uint32_t state[8];
+    uint64_t total_len;
+    unsigned char block[64];
+    size_t block_len;
+} HashContext;
+
+/**
+ * @brief Initializes a hashing context.
+ * @param ctx The context to initialize.
+ */
+void hash_init(HashContext *ctx);
+
+/**
+ * @brief Feeds bytes into the hashing context.
+ * @param ctx The context to update.
+ * @param data The bytes to hash.
+ * @param len The number of bytes.
+ */
+void hash_update(HashContext *ctx, const void *data, size_t len);
+
+/**
+ * @brief Feeds a string into the context, including its null terminator so
+ * that consecutive strings cannot run into each other.
+ * @param ctx The context to update.
+ * @param str The string to hash.
+ */
+void hash_update_string(HashContext *ctx, const char *str);
+
+/**
+ * @brief Finishes hashing and writes the digest as lowercase hex.
+ * @param ctx The context to finalize.
+ * @param out Buffer of at least HASH_HEX_LEN bytes.
+ */
+void hash_final_hex(HashContext *ctx, char *out);
+
+/**
+ * @brief Feeds the entire content of a file into the context.
+ * @param ctx The context to update.
+ * @param path The path to the file.
+ * @return 0 on success, 1 on failure.
+ */
+int hash_update_file(HashContext *ctx, const char *path);
+
+/**
+ * @brief Computes the hex SHA-256 digest of a file.
+ * @param path The path to the file.
+ * @param out Buffer of at least HASH_HEX_LEN bytes.
+ * @return 0 on success, 1 on failure.
+ */
+int hash_file_hex(const char *path, char *out);
+
+/**
+ * @brief Checks whether a string is a well-formed hex digest (and therefore
+ * safe to use as a file name).
+ * @param key The string to check.
+ * @return 1 if valid, 0 otherwise.
+ */
+int hash_is_valid_hex(const char *key);
+
+#endif // HASH_UTILS_H
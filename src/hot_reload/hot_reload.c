@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <dlfcn.h>
+
+#include "hot_reload.h"
+#include "core_utils.h"
+
+typedef void *(*HotLoadFn)(void *state);
+typedef int (*HotStepFn)(void *state);
+typedef void (*HotUnloadFn)(void *state);
+
+/**
+ * @struct HotModule
+ * @brief The currently loaded generation of the project library.
+ */
+typedef struct {
+    void *handle;
+    HotLoadFn load;
+    HotStepFn step;
+    HotUnloadFn unload;
+    char loaded_path[4096];
+} HotModule;
+
+static volatile sig_atomic_t reload_requested = 0;
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_reload_signal(int signum) {
+    (void)signum;
+    reload_requested = 1;
+}
+
+static void handle_stop_signal(int signum) {
+    (void)signum;
+    stop_requested = 1;
+}
+
+/**
+ * @brief Loads a private copy of the library. Copying gives every generation a
+ * distinct path, so dlopen() never hands back the stale cached handle, and the
+ * compiler can overwrite the original while the copy stays mapped.
+ * @return 0 on success, 1 on failure.
+ */
+static int load_module(HotModule *module, const char *library_path, int generation) {
+    snprintf(module->loaded_path, sizeof(module->loaded_path), "%s.gen%d", library_path, generation);
+    if (copy_file_atomic(library_path, module->loaded_path, 0755) != 0) {
+        fprintf(stderr, "[HOT] Failed to copy %s.\n", library_path);
+        return 1;
+    }
+
+    module->handle = dlopen(module->loaded_path, RTLD_NOW | RTLD_LOCAL);
+    if (!module->handle) {
+        fprintf(stderr, "[HOT] dlopen failed: %s\n", dlerror());
+        unlink(module->loaded_path);
+        return 1;
+    }
+    module->load = (HotLoadFn)dlsym(module->handle, HOT_LOAD_SYMBOL);
+    module->step = (HotStepFn)dlsym(module->handle, HOT_STEP_SYMBOL);
+    module->unload = (HotUnloadFn)dlsym(module->handle, HOT_UNLOAD_SYMBOL);
+    if (!module->load || !module->step) {
+        fprintf(stderr, "[HOT] %s must export %s() and %s().\n", library_path, HOT_LOAD_SYMBOL, HOT_STEP_SYMBOL);
+        dlclose(module->handle);
+        module->handle = NULL;
+        unlink(module->loaded_path);
+        return 1;
+    }
+    return 0;
+}
+
+static void unload_module(HotModule *module, void *state) {
+    if (!module->handle) return;
+    if (module->unload) module->unload(state);
+    dlclose(module->handle);
+    unlink(module->loaded_path);
+    module->handle = NULL;
+}
+
+int run_hot_host(const char *library_path) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_reload_signal;
+    sigaction(SIGUSR1, &sa, NULL);
+    sa.sa_handler = handle_stop_signal;
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+
+    int generation = 0;
+    HotModule module;
+    memset(&module, 0, sizeof(module));
+    if (load_module(&module, library_path, generation) != 0) {
+        return 1;
+    }
+    void *state = module.load(NULL);
+    printf("[HOT] Loaded %s.\n", library_path);
+    fflush(stdout);
+
+    int exit_code = 0;
+    while (!stop_requested) {
+        if (reload_requested) {
+            reload_requested = 0;
+            HotModule next;
+            memset(&next, 0, sizeof(next));
+            // Load the new generation first, so a broken build keeps the old code running
+            if (load_module(&next, library_path, generation + 1) != 0) {
+                fprintf(stderr, "[HOT] Keeping the previous version.\n");
+            } else {
+                generation++;
+                unload_module(&module, state);
+                module = next;
+                state = module.load(state);
+                printf("[HOT] Reloaded %s (generation %d).\n", library_path, generation);
+                fflush(stdout);
+            }
+        }
+
+        int rc = module.step(state);
+        if (rc != 0) {
+            exit_code = rc;
+            break;
+        }
+    }
+
+    unload_module(&module, state);
+    return exit_code;
+}
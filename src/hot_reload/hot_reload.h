@@ -0,0 +1,32 @@
+#ifndef HOT_RELOAD_H
+#define HOT_RELOAD_H
+
+/**
+ * The contract between the hot-reload host and a project built with `coda watch --hot`.
+ * The project is compiled as a shared object that exports:
+ *
+ *   void *coda_hot_load(void *state);  // called after every (re)load; receives the previous
+ *                                      // state (NULL the first time) and returns the state to keep
+ *   int coda_hot_step(void *state);    // called repeatedly; return non-zero to exit the host
+ *   void coda_hot_unload(void *state); // optional; called before the library is swapped out
+ *
+ * State survives a reload only if it lives on the heap; static variables in the
+ * library are reset every time it is loaded.
+ */
+#define HOT_LOAD_SYMBOL "coda_hot_load"
+#define HOT_STEP_SYMBOL "coda_hot_step"
+#define HOT_UNLOAD_SYMBOL "coda_hot_unload"
+
+// The shared object produced by `coda watch --hot`, inside the project's build directory
+#define HOT_LIBRARY_FILE_NAME "hot/libcoda_hot.so"
+
+/**
+ * @brief Runs the hot-reload host: loads the library, then calls coda_hot_step()
+ * in a loop. On SIGUSR1 the library is unloaded and the latest build is loaded
+ * in its place, handing the current state over.
+ * @param library_path The shared object to load.
+ * @return The exit code for the host process.
+ */
+int run_hot_host(const char *library_path);
+
+#endif // HOT_RELOAD_H
@@ -2,16 +2,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <jansson.h>
 #include <limits.h>
 
 #include "install_cmd.h"
 #include "project_mgr.h"
+#include "../registry_data.h"
+#include "process_runner.h"
+#include "build_isolation.h"
 
-// Mendeklarasikan variabel eksternal yang berisi data registri
-extern const char *coda_registry_data;
+// A clone that takes longer than this is abandoned
+#define CLONE_TIMEOUT_MS (15 * 60 * 1000)
+// A directory of bare repositories ("<name>.git") or a URL prefix to install from instead of upstream
+#define MIRROR_ENV "CODA_MIRROR"
+#define MAX_SPARSE_PATHS 64
 
 /**
  * @brief Checks if a tool (like git) is available in the system's PATH.
@@ -39,73 +42,148 @@ static int is_tool_available(const char *tool_name) {
 }
 
 /**
- * @brief Installs a package by its name, looking up the URL in the embedded registry.
- * @param package_name The name of the package to install.
+ * @brief Looks a package up in the embedded registry (src/registry_data.c).
+ * @return The registry entry, or NULL if the package is unknown.
+ */
+static const DependencyRegistryItem *find_registry_item(const char *package_name) {
+    for (int i = 0; dependency_registry[i].name != NULL; i++) {
+        if (strcmp(dependency_registry[i].name, package_name) == 0) {
+            return &dependency_registry[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Chooses where to fetch a package from: "<CODA_MIRROR>/<name>.git" when a
+ * mirror is configured (for a local mirror directory, only if it has the package),
+ * otherwise the registry URL.
+ */
+static void resolve_fetch_url(const DependencyRegistryItem *item, char *url, size_t size) {
+    const char *mirror = getenv(MIRROR_ENV);
+    if (mirror && mirror[0] != '\0') {
+        snprintf(url, size, "%s/%s.git", mirror, item->name);
+        if (strstr(mirror, "://")) {
+            return;
+        }
+        // A local mirror is cloned over file:// so that --depth and --filter still apply
+        if (access(url, F_OK) == 0) {
+            char *resolved = realpath(url, NULL);
+            if (resolved) {
+                snprintf(url, size, "file://%s", resolved);
+                free(resolved);
+            }
+            return;
+        }
+    }
+    snprintf(url, size, "%s", item->url);
+}
+
+// Runs one git command with the clone timeout. Returns 0 on success, 1 otherwise.
+static int run_git(char **args) {
+    ProcessSpec spec = { 0 };
+    spec.argv = args;
+    spec.timeout_ms = CLONE_TIMEOUT_MS;
+    return process_run(&spec, NULL);
+}
+
+/**
+ * @brief Fetches only the listed paths of a repository: a shallow partial clone
+ * (--filter=blob:none) downloads the latest commit's trees, and a sparse checkout
+ * then fetches and writes just the blobs under the given paths.
+ * @param paths Files, directories or glob patterns relative to the repository root.
  * @return 0 on success, 1 on failure.
  */
+static int sparse_clone(const char *url, const char *install_path, const char *const *paths, int path_count) {
+    char *clone_args[] = { "git", "-c", "http.postBuffer=524288000", "clone", "--depth", "1", "--filter=blob:none",
+                           "--no-checkout", (char *)url, (char *)install_path, NULL };
+    if (run_git(clone_args) != 0) {
+        return 1;
+    }
+
+    // Non-cone patterns anchored at the root, so single files work as well as directories
+    char *sparse_args[MAX_SPARSE_PATHS + 7] = { "git", "-C", (char *)install_path, "sparse-checkout", "set", "--no-cone" };
+    char patterns[MAX_SPARSE_PATHS][PATH_MAX];
+    int arg_count = 6;
+    for (int i = 0; i < path_count; i++) {
+        snprintf(patterns[i], sizeof(patterns[i]), "%s%s", paths[i][0] == '/' ? "" : "/", paths[i]);
+        sparse_args[arg_count++] = patterns[i];
+    }
+    sparse_args[arg_count] = NULL;
+    char *checkout_args[] = { "git", "-C", (char *)install_path, "checkout", NULL };
+    return (run_git(sparse_args) == 0 && run_git(checkout_args) == 0) ? 0 : 1;
+}
+
 int install_dependency(const char *package_name) {
+    return install_dependency_paths(package_name, NULL);
+}
+
+int install_dependency_paths(const char *package_name, const char *const *paths) {
     // 1. Verifikasi ketersediaan git
     if (!is_tool_available("git")) {
         fprintf(stderr, "Error: 'git' tool not found in system PATH. Please install it.\n");
         return 1;
     }
 
-    // 2. Muat database dari string literal
-    json_t *root;
-    json_error_t error;
-    root = json_loads(coda_registry_data, 0, &error);
-
-    if (!root) {
-        fprintf(stderr, "Error: Internal package registry is corrupted: %s\n", error.text);
+    // 2. Cari paket di registri
+    const DependencyRegistryItem *item = find_registry_item(package_name);
+    if (!item) {
+        fprintf(stderr, "Error: Package '%s' not found in the Coda registry.\n", package_name);
         return 1;
     }
 
-    // 3. Cari URL paket
-    json_t *packages_obj = json_object_get(root, "packages");
-    json_t *package_info = json_object_get(packages_obj, package_name);
-    json_t *url_json = json_object_get(package_info, "url");
-
-    if (!json_is_string(url_json)) {
-        fprintf(stderr, "Error: Package '%s' not found in the Coda registry.\n", package_name);
-        json_decref(root);
-        return 1;
+    // 3. Tentukan path yang dibutuhkan: dari argumen --path, atau dari registri
+    char registry_paths[1024];
+    const char *sparse_paths[MAX_SPARSE_PATHS];
+    int path_count = 0;
+    for (int i = 0; paths && paths[i] != NULL && path_count < MAX_SPARSE_PATHS; i++) {
+        sparse_paths[path_count++] = paths[i];
+    }
+    if (path_count == 0 && item->sparse_paths) {
+        snprintf(registry_paths, sizeof(registry_paths), "%s", item->sparse_paths);
+        char *save = NULL;
+        for (char *path = strtok_r(registry_paths, " ", &save); path && path_count < MAX_SPARSE_PATHS;
+             path = strtok_r(NULL, " ", &save)) {
+            sparse_paths[path_count++] = path;
+        }
     }
 
-    const char *repo_url = json_string_value(url_json);
+    char fetch_url[PATH_MAX];
+    resolve_fetch_url(item, fetch_url, sizeof(fetch_url));
     char install_path[1024];
     snprintf(install_path, sizeof(install_path), "modules/%s", package_name);
+    if (strcmp(fetch_url, item->url) != 0) {
+        printf("Fetching '%s' from mirror %s.\n", package_name, fetch_url);
+    }
 
-    // 4. Tambahkan konfigurasi git untuk menangani repositori besar
-    //    Ini akan membuat unduhan lebih stabil dan mencegah error timeout
-    system("git config http.postBuffer 524288000");
-
-    // 5. Jalankan git clone sebagai proses anak (child process)
-    pid_t pid = fork();
-    if (pid == -1) {
-        perror("Failed to fork process");
-        json_decref(root);
-        return 1;
+    // Proses git mewarisi isolasi build dari coda.json (cgroup atau nice/ionice)
+    ProjectConfig config;
+    if (access("coda.json", F_OK) == 0 && parse_config_from_file("coda.json", &config) == 0) {
+        build_isolation_apply(&config.isolation);
+        free_config(&config);
     }
-    if (pid == 0) {
-        char *args[] = { "git", "clone", (char *)repo_url, install_path, NULL };
-        execvp("git", args);
-        perror("Failed to run 'git clone'");
-        _exit(1);
+
+    // 4. Jalankan git clone sebagai proses anak (child process).
+    //    http.postBuffer dibesarkan hanya untuk clone ini (-c), agar repositori besar
+    //    terunduh lebih stabil tanpa mengubah konfigurasi git pengguna
+    int rc;
+    if (path_count > 0) {
+        printf("Fetching only %d path(s) of '%s' (partial clone with sparse checkout).\n", path_count, package_name);
+        rc = sparse_clone(fetch_url, install_path, sparse_paths, path_count);
     } else {
-        int status;
-        waitpid(pid, &status, 0);
-        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
-            fprintf(stdout, "Repository '%s' successfully downloaded.\n", package_name);
-            
-            // 6. Perbarui file coda.json proyek
-            if (add_dependency_to_project_config(package_name, repo_url) != 0) {
-                fprintf(stderr, "Warning: Failed to update 'coda.json' with new dependency.\n");
-            }
-            json_decref(root);
-            return 0;
+        char *args[] = { "git", "-c", "http.postBuffer=524288000", "clone", fetch_url, install_path, NULL };
+        rc = run_git(args);
+    }
+    build_isolation_release();
+    if (rc == 0) {
+        fprintf(stdout, "Repository '%s' successfully downloaded.\n", package_name);
+
+        // 5. Perbarui file coda.json proyek (selalu dengan URL upstream, bukan mirror)
+        if (add_dependency_to_project_config(package_name, item->url) != 0) {
+            fprintf(stderr, "Warning: Failed to update 'coda.json' with new dependency.\n");
         }
+        return 0;
     }
-    json_decref(root);
     fprintf(stderr, "Error: Installation failed.\n");
     return 1;
-}
\ No newline at end of file
+}
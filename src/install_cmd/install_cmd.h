@@ -8,4 +8,14 @@
  */
 int install_dependency(const char *package_name);
 
+/**
+ * @brief Installs a package, fetching only the given paths (partial clone with
+ * sparse checkout). Honors CODA_MIRROR.
+ * @param package_name The name of the package to install.
+ * @param paths NULL-terminated files, directories or patterns to fetch; NULL or
+ * empty uses the registry's sparse paths, and the whole repository if it has none.
+ * @return 0 on success, 1 on failure.
+ */
+int install_dependency_paths(const char *package_name, const char *const *paths);
+
 #endif // INSTALL_CMD_H
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -9,6 +10,15 @@
 #include "build_engine.h"
 #include "install_cmd.h"
 #include "watch_cmd.h"
+#include "watch_metrics.h"
+#include "cache_server_cmd.h"
+#include "hot_reload.h"
+#include "explain_cmd.h"
+#include "tune_cmd.h"
+#include "bench_cmd.h"
+#include "workspace.h"
+#include "vendor_cmd.h"
+#include "toolchain.h"
 
 /**
  * @brief Prints the tool's usage instructions to stderr.
@@ -17,9 +27,31 @@ static void print_usage() {
     fprintf(stderr, "Usage: coda <command> [arguments]\n");
     fprintf(stderr, "Commands:\n");
     fprintf(stderr, "  init             Initializes a new Coda project.\n");
-    fprintf(stderr, "  build            Reads the project config and compiles.\n");
-    fprintf(stderr, "  install <package_name> Downloads a dependency from the package registry.\n");
-    fprintf(stderr, "  watch            Monitors source files and rebuilds automatically.\n");
+    fprintf(stderr, "  build [--profile-compile] [--profile <name>] [--reproducible] [--verify-repro] [--matrix] [-j N]\n");
+    fprintf(stderr, "                   Reads the project config and compiles.\n");
+    fprintf(stderr, "                   --profile-compile reports the most expensive phases, headers and functions.\n");
+    fprintf(stderr, "                   --profile adds the compiler flags of a profile from coda.json (see 'tune').\n");
+    fprintf(stderr, "                   --reproducible makes the output independent of the checkout path and build time.\n");
+    fprintf(stderr, "                   --verify-repro builds twice in reproducible mode and compares the outputs.\n");
+    fprintf(stderr, "                   --matrix builds every configuration of \"matrix\" in coda.json at once; -j caps them.\n");
+    fprintf(stderr, "                   In a workspace root (coda-workspace.json), builds every member; -j caps parallel members.\n");
+    fprintf(stderr, "  install <package_name> [--path <path>]... Downloads a dependency from the package registry.\n");
+    fprintf(stderr, "                   --path fetches only the given files or directories (sparse checkout).\n");
+    fprintf(stderr, "  vendor pack [bundle] Writes all dependencies in modules/ into one compressed bundle (default: %s).\n",
+            VENDOR_DEFAULT_BUNDLE);
+    fprintf(stderr, "  vendor unpack [bundle] [-j N] Restores modules/ from a bundle, verifying every file's hash.\n");
+    fprintf(stderr, "  watch [--run | --hot] [--metrics file] [-- args...] Monitors source files and rebuilds automatically.\n");
+    fprintf(stderr, "                   --run restarts the built executable (with args) after every successful build.\n");
+    fprintf(stderr, "                   --hot builds a shared object and reloads it into a running host process.\n");
+    fprintf(stderr, "                   --metrics publishes build latency metrics to this file (default: %s in the build directory).\n",
+            WATCH_METRICS_FILE_NAME);
+    fprintf(stderr, "  tune [--runs N] [--warmup N] [--write [name]] Benchmarks compiler-flag variants and reports the fastest.\n");
+    fprintf(stderr, "                   --write saves the winner as a build profile (default name: tuned).\n");
+    fprintf(stderr, "  bench [--runs N] [--warmup N] [--baseline <commit|file>] [--save-baseline] [--no-pin]\n");
+    fprintf(stderr, "                   Builds the benchmark targets in release mode, measures them and flags regressions.\n");
+    fprintf(stderr, "  toolchain [compiler] Shows the probed version, target and supported flags of the compiler.\n");
+    fprintf(stderr, "  explain [target] [--next] Explains why the last build did work, or what the next one will do.\n");
+    fprintf(stderr, "  cache-server [dir] [port] Serves a directory as a remote artifact cache (default: .coda-cache 7070).\n");
 }
 
 int main(int argc, char *argv[]) {
@@ -41,26 +73,206 @@ int main(int argc, char *argv[]) {
         // FIX: Changed init_project() to the correct name, init_project_config()
         return init_project_config();
     } else if (strcmp(command, "build") == 0) {
-        if (argc != 2) {
-            fprintf(stderr, "Error: 'build' command takes no arguments.\n");
-            print_usage();
+        BuildOptions options = { 0 };
+        int jobs = 0, jobs_given = 0;
+        int verify_repro = 0;
+        int matrix = 0;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--profile-compile") == 0) {
+                options.profile_compile = 1;
+            } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+                options.profile = argv[++i];
+            } else if (strcmp(argv[i], "--reproducible") == 0) {
+                options.reproducible = 1;
+            } else if (strcmp(argv[i], "--verify-repro") == 0) {
+                verify_repro = 1;
+            } else if (strcmp(argv[i], "--matrix") == 0) {
+                matrix = 1;
+            } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+                jobs = atoi(argv[++i]);
+                jobs_given = 1;
+            } else {
+                fprintf(stderr, "Error: Unknown option '%s' for 'build'.\n", argv[i]);
+                print_usage();
+                return 1;
+            }
+        }
+        if (verify_repro && matrix) {
+            fprintf(stderr, "Error: '--verify-repro' and '--matrix' cannot be combined.\n");
+            return 1;
+        }
+        if (access(WORKSPACE_FILE, F_OK) == 0) {
+            if (verify_repro || matrix) {
+                fprintf(stderr, "Error: Run 'build %s' inside a workspace member.\n", matrix ? "--matrix" : "--verify-repro");
+                return 1;
+            }
+            Workspace workspace;
+            if (load_workspace(WORKSPACE_FILE, &workspace) != 0) return 1;
+            if (jobs > 0) workspace.jobs = jobs;
+            int rc = build_workspace(&workspace, NULL, &options);
+            free_workspace(&workspace);
+            return rc;
+        }
+        if (jobs_given && !matrix) {
+            fprintf(stderr, "Error: '-j' requires a workspace root or --matrix.\n");
             return 1;
         }
-        return build_project("coda.json");
+        if (verify_repro) {
+            return verify_reproducible_build("coda.json", &options);
+        }
+        if (matrix) {
+            return build_matrix("coda.json", &options, jobs);
+        }
+        return build_project_with_options("coda.json", &options);
     } else if (strcmp(command, "install") == 0) {
-        if (argc != 3) {
+        if (argc < 3 || argv[2][0] == '-') {
             fprintf(stderr, "Error: 'install' command requires one argument: <package_name>.\n");
             print_usage();
             return 1;
         }
-        return install_dependency(argv[2]);
+        const char **paths = (const char **)calloc((size_t)argc, sizeof(char *));
+        if (!paths) return 1;
+        int path_count = 0;
+        for (int i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "--path") == 0 && i + 1 < argc) {
+                paths[path_count++] = argv[++i];
+            } else {
+                fprintf(stderr, "Error: Unknown option '%s' for 'install'.\n", argv[i]);
+                free(paths);
+                print_usage();
+                return 1;
+            }
+        }
+        int rc = install_dependency_paths(argv[2], paths);
+        free(paths);
+        return rc;
+    } else if (strcmp(command, "vendor") == 0) {
+        if (argc < 3 || (strcmp(argv[2], "pack") != 0 && strcmp(argv[2], "unpack") != 0)) {
+            fprintf(stderr, "Error: 'vendor' command requires 'pack' or 'unpack'.\n");
+            print_usage();
+            return 1;
+        }
+        int unpack = strcmp(argv[2], "unpack") == 0;
+        const char *bundle_path = NULL;
+        int jobs = 0;
+        for (int i = 3; i < argc; i++) {
+            if (unpack && strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+                jobs = atoi(argv[++i]);
+            } else if (argv[i][0] != '-' && !bundle_path) {
+                bundle_path = argv[i];
+            } else {
+                fprintf(stderr, "Error: Unknown option '%s' for 'vendor %s'.\n", argv[i], argv[2]);
+                print_usage();
+                return 1;
+            }
+        }
+        if (!bundle_path) bundle_path = VENDOR_DEFAULT_BUNDLE;
+        return unpack ? vendor_unpack("coda.json", bundle_path, jobs) : vendor_pack("coda.json", bundle_path);
     } else if (strcmp(command, "watch") == 0) {
-        if (argc != 2) {
-            fprintf(stderr, "Error: 'watch' command takes no arguments.\n");
+        WatchOptions options = { 0, 0, NULL, NULL };
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--run") == 0) {
+                options.run_after_build = 1;
+            } else if (strcmp(argv[i], "--hot") == 0) {
+                options.hot_reload = 1;
+            } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+                options.metrics_path = argv[++i];
+            } else if (strcmp(argv[i], "--") == 0) {
+                options.run_args = &argv[i + 1];
+                break;
+            } else {
+                fprintf(stderr, "Error: Unknown option '%s' for 'watch'.\n", argv[i]);
+                print_usage();
+                return 1;
+            }
+        }
+        if (options.run_after_build && options.hot_reload) {
+            fprintf(stderr, "Error: '--run' and '--hot' cannot be combined.\n");
+            return 1;
+        }
+        if (options.run_args && !options.run_after_build) {
+            fprintf(stderr, "Error: Arguments after '--' require '--run'.\n");
+            return 1;
+        }
+        return watch_project_with_options("coda.json", &options);
+    } else if (strcmp(command, "hot-host") == 0) {
+        // Internal: started by 'watch --hot', not listed in the usage text
+        if (argc != 3) {
+            fprintf(stderr, "Error: 'hot-host' command requires one argument: <library>.\n");
+            return 1;
+        }
+        return run_hot_host(argv[2]);
+    } else if (strcmp(command, "tune") == 0) {
+        TuneOptions options = { 0, -1, NULL };
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+                options.runs = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+                options.warmup = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--write") == 0) {
+                options.write_profile = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : "tuned";
+            } else {
+                fprintf(stderr, "Error: Unknown option '%s' for 'tune'.\n", argv[i]);
+                print_usage();
+                return 1;
+            }
+        }
+        return tune_project("coda.json", &options);
+    } else if (strcmp(command, "bench") == 0) {
+        BenchOptions options = { 0, -1, 0, NULL, 0 };
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+                options.runs = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+                options.warmup = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+                options.baseline = argv[++i];
+            } else if (strcmp(argv[i], "--save-baseline") == 0) {
+                options.save_baseline = 1;
+            } else if (strcmp(argv[i], "--no-pin") == 0) {
+                options.no_pin = 1;
+            } else {
+                fprintf(stderr, "Error: Unknown option '%s' for 'bench'.\n", argv[i]);
+                print_usage();
+                return 1;
+            }
+        }
+        return bench_project("coda.json", &options);
+    } else if (strcmp(command, "explain") == 0) {
+        const char *target = NULL;
+        int next_build = 0;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--next") == 0) {
+                next_build = 1;
+            } else if (argv[i][0] != '-' && !target) {
+                target = argv[i];
+            } else {
+                fprintf(stderr, "Error: Unknown option '%s' for 'explain'.\n", argv[i]);
+                print_usage();
+                return 1;
+            }
+        }
+        return explain_build("coda.json", target, next_build);
+    } else if (strcmp(command, "toolchain") == 0) {
+        if (argc > 3) {
+            fprintf(stderr, "Error: 'toolchain' command takes at most one argument: [compiler].\n");
             print_usage();
             return 1;
         }
-        return watch_project("coda.json");
+        return print_toolchain_info("coda.json", argc == 3 ? argv[2] : NULL);
+    } else if (strcmp(command, "cache-server") == 0) {
+        if (argc > 4) {
+            fprintf(stderr, "Error: 'cache-server' command takes at most two arguments: [dir] [port].\n");
+            print_usage();
+            return 1;
+        }
+        const char *cache_dir = argc >= 3 ? argv[2] : ".coda-cache";
+        int port = argc == 4 ? atoi(argv[3]) : 7070;
+        if (port <= 0 || port > 65535) {
+            fprintf(stderr, "Error: Invalid port '%s'.\n", argv[3]);
+            return 1;
+        }
+        return run_cache_server(cache_dir, port);
     } else {
         fprintf(stderr, "Error: Invalid command '%s'.\n", command);
         print_usage();
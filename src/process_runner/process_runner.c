@@ -0,0 +1,330 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "process_runner.h"
+
+extern char **environ;
+
+// Captured output beyond this is dropped so a runaway process cannot exhaust memory
+#define PROCESS_OUTPUT_LIMIT (16 * 1024 * 1024)
+// How long a timed-out process gets to exit after SIGTERM before it is killed
+#define TIMEOUT_GRACE_MS 2000
+// Exit polling interval for children without a pidfd (older kernels)
+#define REAP_POLL_MS 10
+
+static long long monotonic_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// pidfd_open() is called through syscall() so Coda still builds against older C libraries
+static int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+/**
+ * @brief Builds the child's environment: the current one, with the entries of
+ * extra_env replacing variables of the same name.
+ * @return A NULL-terminated array whose strings are borrowed (free only the array), or NULL.
+ */
+static char **merge_environment(const char *const *extra_env) {
+    int env_count = 0, extra_count = 0;
+    while (environ[env_count]) env_count++;
+    while (extra_env[extra_count]) extra_count++;
+    char **envp = (char **)calloc((size_t)(env_count + extra_count + 1), sizeof(char *));
+    if (!envp) return NULL;
+
+    int n = 0;
+    for (int i = 0; i < env_count; i++) {
+        int overridden = 0;
+        for (int j = 0; j < extra_count && !overridden; j++) {
+            size_t name_len = strcspn(extra_env[j], "=");
+            overridden = strncmp(environ[i], extra_env[j], name_len) == 0 && environ[i][name_len] == '=';
+        }
+        if (!overridden) envp[n++] = environ[i];
+    }
+    for (int j = 0; j < extra_count; j++) envp[n++] = (char *)extra_env[j];
+    return envp;
+}
+
+/**
+ * @brief Starts the program described by spec. Streams that are neither sent to
+ * a file nor captured (capture_fd < 0) are inherited.
+ * @return The pid, or -1 on failure.
+ */
+static pid_t spawn_process(const ProcessSpec *spec, int capture_fd) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attr);
+
+    if (spec->stdout_path) {
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, spec->stdout_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    } else if (capture_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, capture_fd, STDOUT_FILENO);
+    }
+    if (spec->stderr_path) {
+        posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, spec->stderr_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    } else if (capture_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, capture_fd, STDERR_FILENO);
+    }
+
+    // Coda may block signals (the watch loop reads them from a signalfd); children must not inherit that
+    sigset_t empty_mask, default_signals;
+    sigemptyset(&empty_mask);
+    sigemptyset(&default_signals);
+    sigaddset(&default_signals, SIGINT);
+    sigaddset(&default_signals, SIGTERM);
+    sigaddset(&default_signals, SIGCHLD);
+    sigaddset(&default_signals, SIGPIPE);
+    posix_spawnattr_setsigmask(&attr, &empty_mask);
+    posix_spawnattr_setsigdefault(&attr, &default_signals);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    char **envp = spec->extra_env ? merge_environment(spec->extra_env) : environ;
+    pid_t pid = -1;
+    int rc = envp ? posix_spawnp(&pid, spec->argv[0], &actions, &attr, spec->argv, envp) : ENOMEM;
+    if (rc != 0) {
+        fprintf(stderr, "[ERROR] Failed to start '%s': %s\n", spec->argv[0], strerror(rc));
+        pid = -1;
+    }
+    if (envp != environ) free(envp);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return pid;
+}
+
+pid_t process_spawn(const ProcessSpec *spec) {
+    fflush(stdout);
+    fflush(stderr);
+    return spawn_process(spec, -1);
+}
+
+void process_runner_init(ProcessRunner *runner) {
+    memset(runner, 0, sizeof(*runner));
+}
+
+// Appends a job slot for `pid`. Returns its index, or -1 on failure.
+static int add_job(ProcessRunner *runner, pid_t pid, int timeout_ms) {
+    if (runner->count == runner->capacity) {
+        int capacity = runner->capacity ? runner->capacity * 2 : 8;
+        ProcessJob *jobs = (ProcessJob *)realloc(runner->jobs, (size_t)capacity * sizeof(ProcessJob));
+        if (!jobs) return -1;
+        runner->jobs = jobs;
+        runner->capacity = capacity;
+    }
+    ProcessJob *job = &runner->jobs[runner->count];
+    memset(job, 0, sizeof(*job));
+    job->pid = pid;
+    job->running = 1;
+    job->output_fd = -1;
+    job->pid_fd = open_pidfd(pid); // without one, exits are polled every REAP_POLL_MS
+    job->deadline_ms = timeout_ms > 0 ? monotonic_ms() + timeout_ms : 0;
+    return runner->count++;
+}
+
+int process_runner_spawn(ProcessRunner *runner, const ProcessSpec *spec) {
+    int capture_pipe[2] = { -1, -1 };
+    int needs_pipe = spec->capture_output && (!spec->stdout_path || !spec->stderr_path);
+    // O_CLOEXEC keeps other children from holding the pipe open; only our read end is non-blocking
+    if (needs_pipe && (pipe2(capture_pipe, O_CLOEXEC) != 0 || fcntl(capture_pipe[0], F_SETFL, O_NONBLOCK) != 0)) {
+        perror("[ERROR] Failed to create output pipe");
+        if (capture_pipe[0] >= 0) close(capture_pipe[0]);
+        if (capture_pipe[1] >= 0) close(capture_pipe[1]);
+        return -1;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = spawn_process(spec, capture_pipe[1]);
+    if (capture_pipe[1] >= 0) close(capture_pipe[1]);
+    int index = pid > 0 ? add_job(runner, pid, spec->timeout_ms) : -1;
+    if (index < 0) {
+        if (capture_pipe[0] >= 0) close(capture_pipe[0]);
+        if (pid > 0) {
+            kill(pid, SIGKILL);
+            waitpid(pid, NULL, 0);
+        }
+        return -1;
+    }
+    runner->jobs[index].output_fd = capture_pipe[0];
+    return index;
+}
+
+int process_runner_adopt(ProcessRunner *runner, pid_t pid, int timeout_ms) {
+    return add_job(runner, pid, timeout_ms);
+}
+
+// Reads everything currently available from a job's capture pipe; closes it at EOF
+static void drain_output(ProcessJob *job) {
+    char chunk[8192];
+    while (job->output_fd >= 0) {
+        ssize_t n = read(job->output_fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                close(job->output_fd);
+                job->output_fd = -1;
+            }
+            return;
+        }
+        if (job->output_len + (size_t)n + 1 > PROCESS_OUTPUT_LIMIT) continue;
+        if (job->output_len + (size_t)n + 1 > job->output_capacity) {
+            size_t capacity = job->output_capacity ? job->output_capacity : 4096;
+            while (capacity < job->output_len + (size_t)n + 1) capacity *= 2;
+            char *output = (char *)realloc(job->output, capacity);
+            if (!output) continue;
+            job->output = output;
+            job->output_capacity = capacity;
+        }
+        memcpy(job->output + job->output_len, chunk, (size_t)n);
+        job->output_len += (size_t)n;
+        job->output[job->output_len] = '\0';
+    }
+}
+
+// Writes a finished job's captured output with as few write() calls as possible
+static void print_output(const ProcessJob *job) {
+    if (job->output_len == 0) return;
+    fflush(stdout);
+    fflush(stderr);
+    size_t written = 0;
+    while (written < job->output_len) {
+        ssize_t n = write(STDERR_FILENO, job->output + written, job->output_len - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += (size_t)n;
+    }
+}
+
+/**
+ * @brief Collects a job if its process has ended. Output still in the pipe is
+ * read first; a grandchild that kept the pipe open does not hold us up.
+ * @return 1 if the job finished, 0 if it is still running.
+ */
+static int try_reap(ProcessJob *job) {
+    int status;
+    pid_t rc;
+    do {
+        rc = wait4(job->pid, &status, WNOHANG, &job->usage);
+    } while (rc == -1 && errno == EINTR);
+    if (rc == 0) return 0;
+    // rc == -1 (e.g. ECHILD) means the process is gone without a status we can use
+    job->status = rc == job->pid ? status : (1 << 8);
+    job->running = 0;
+    drain_output(job);
+    if (job->output_fd >= 0) close(job->output_fd);
+    if (job->pid_fd >= 0) close(job->pid_fd);
+    job->output_fd = job->pid_fd = -1;
+    print_output(job);
+    return 1;
+}
+
+// Sends SIGTERM at a job's deadline and SIGKILL once the grace period is over
+static void enforce_timeout(ProcessJob *job, long long now) {
+    if (job->deadline_ms > 0 && now >= job->deadline_ms && !job->timed_out) {
+        fprintf(stderr, "[WARN] Process %d timed out; stopping it.\n", (int)job->pid);
+        kill(job->pid, SIGTERM);
+        job->timed_out = 1;
+        job->kill_at_ms = now + TIMEOUT_GRACE_MS;
+    } else if (job->kill_at_ms > 0 && now >= job->kill_at_ms) {
+        kill(job->pid, SIGKILL);
+        job->kill_at_ms = 0;
+    }
+}
+
+int process_runner_wait_any(ProcessRunner *runner) {
+    struct pollfd *fds = (struct pollfd *)calloc((size_t)runner->count * 2 + 1, sizeof(struct pollfd));
+    if (!fds) return -1;
+
+    int finished = -1;
+    while (finished < 0) {
+        // 1. Collect a job that has already ended
+        int running = 0;
+        for (int i = 0; i < runner->count && finished < 0; i++) {
+            if (!runner->jobs[i].running) continue;
+            if (try_reap(&runner->jobs[i])) finished = i;
+            else running++;
+        }
+        if (finished >= 0 || running == 0) break;
+
+        // 2. Sleep until output arrives, a process exits or the next deadline passes
+        long long now = monotonic_ms();
+        int timeout_ms = -1, nfds = 0;
+        for (int i = 0; i < runner->count; i++) {
+            ProcessJob *job = &runner->jobs[i];
+            if (!job->running) continue;
+            enforce_timeout(job, now);
+            long long next = job->kill_at_ms > 0 ? job->kill_at_ms : (job->timed_out ? 0 : job->deadline_ms);
+            if (next > 0 && (timeout_ms < 0 || next - now < timeout_ms)) timeout_ms = next > now ? (int)(next - now) : 0;
+            if (job->pid_fd < 0 && (timeout_ms < 0 || timeout_ms > REAP_POLL_MS)) timeout_ms = REAP_POLL_MS;
+            if (job->output_fd >= 0) fds[nfds++] = (struct pollfd){ job->output_fd, POLLIN, 0 };
+            if (job->pid_fd >= 0) fds[nfds++] = (struct pollfd){ job->pid_fd, POLLIN, 0 };
+        }
+        if (poll(fds, (nfds_t)nfds, timeout_ms) < 0 && errno != EINTR) {
+            perror("[ERROR] poll failed");
+            break;
+        }
+        for (int i = 0; i < runner->count; i++) {
+            if (runner->jobs[i].running) drain_output(&runner->jobs[i]);
+        }
+    }
+    free(fds);
+    return finished;
+}
+
+int process_runner_wait_all(ProcessRunner *runner) {
+    while (process_runner_wait_any(runner) >= 0) {
+    }
+    int failed = 0;
+    for (int i = 0; i < runner->count; i++) {
+        if (!process_job_succeeded(&runner->jobs[i])) failed = 1;
+    }
+    return failed;
+}
+
+void process_runner_free(ProcessRunner *runner) {
+    for (int i = 0; i < runner->count; i++) {
+        ProcessJob *job = &runner->jobs[i];
+        if (job->running) {
+            kill(job->pid, SIGKILL);
+            waitpid(job->pid, NULL, 0);
+        }
+        if (job->output_fd >= 0) close(job->output_fd);
+        if (job->pid_fd >= 0) close(job->pid_fd);
+        free(job->output);
+    }
+    free(runner->jobs);
+    memset(runner, 0, sizeof(*runner));
+}
+
+int process_job_succeeded(const ProcessJob *job) {
+    return !job->running && !job->timed_out && WIFEXITED(job->status) && WEXITSTATUS(job->status) == 0;
+}
+
+int process_run(const ProcessSpec *spec, struct rusage *usage) {
+    ProcessRunner runner;
+    process_runner_init(&runner);
+    int failed = process_runner_spawn(&runner, spec) < 0 || process_runner_wait_all(&runner) != 0;
+    if (usage && runner.count > 0) *usage = runner.jobs[0].usage;
+    process_runner_free(&runner);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+#ifndef PROCESS_RUNNER_H
+#define PROCESS_RUNNER_H
+
+#include <sys/types.h>
+#include <sys/resource.h>
+
+/**
+ * @struct ProcessSpec
+ * @brief Describes one program to start. Zero-initialize and fill in what is needed.
+ */
+typedef struct {
+    char *const *argv;            // NULL-terminated; argv[0] is looked up in PATH unless it contains a '/'
+    const char *stdout_path;      // file that receives stdout (truncated), or NULL
+    const char *stderr_path;      // file that receives stderr (truncated), or NULL
+    int capture_output;           // buffer stdout and stderr (those not sent to a file) and print them in one piece when the process ends
+    int timeout_ms;               // 0 for none; afterwards the process gets SIGTERM, then SIGKILL
+    const char *const *extra_env; // NULL-terminated "NAME=value" entries added to the environment, or NULL
+} ProcessSpec;
+
+/**
+ * @struct ProcessJob
+ * @brief A child process tracked by a ProcessRunner.
+ */
+typedef struct {
+    pid_t pid;
+    int running;
+    int status;                   // raw wait status once the process has ended
+    int timed_out;
+    struct rusage usage;          // resource usage once the process has ended
+    char *output;                 // captured output (NUL-terminated), or NULL
+    size_t output_len;
+    size_t output_capacity;
+    int output_fd;                // read end of the capture pipe, -1 when closed
+    int pid_fd;                   // pidfd used to wait for the exit, -1 if unavailable
+    long long deadline_ms;        // monotonic time of the SIGTERM, 0 for none
+    long long kill_at_ms;         // monotonic time of the SIGKILL after a timeout, 0 until then
+} ProcessJob;
+
+/**
+ * @struct ProcessRunner
+ * @brief A set of concurrent children with one reaper: process_runner_wait_any()
+ * multiplexes their output pipes, exits and timeouts in a single poll() loop,
+ * and only ever waits for its own pids.
+ */
+typedef struct {
+    ProcessJob *jobs;
+    int count;
+    int capacity;
+} ProcessRunner;
+
+void process_runner_init(ProcessRunner *runner);
+
+/**
+ * @brief Starts a program with posix_spawn(), which avoids copying the parent's
+ * page tables the way fork() does. The child starts with default signal
+ * handling and an empty signal mask.
+ * @return The index of the new job, or -1 on failure.
+ */
+int process_runner_spawn(ProcessRunner *runner, const ProcessSpec *spec);
+
+/**
+ * @brief Tracks a child that the caller created with fork() (e.g. one running a
+ * build in-process), so it is reaped together with the spawned ones.
+ * @param timeout_ms 0 for none.
+ * @return The index of the new job, or -1 on failure.
+ */
+int process_runner_adopt(ProcessRunner *runner, pid_t pid, int timeout_ms);
+
+/**
+ * @brief Waits until one running job ends, meanwhile draining captured output
+ * and enforcing timeouts. A finished job's captured output is written to
+ * stderr in one piece, so diagnostics of parallel jobs never interleave.
+ * @return The index of the finished job, or -1 if no job is running.
+ */
+int process_runner_wait_any(ProcessRunner *runner);
+
+/**
+ * @brief Waits for every running job.
+ * @return 0 if all jobs of the runner succeeded, 1 otherwise.
+ */
+int process_runner_wait_all(ProcessRunner *runner);
+
+/**
+ * @brief Kills every running job and frees the runner.
+ */
+void process_runner_free(ProcessRunner *runner);
+
+/**
+ * @return 1 if the job exited with status 0 (and did not time out), 0 otherwise.
+ */
+int process_job_succeeded(const ProcessJob *job);
+
+/**
+ * @brief Starts a program without tracking it; the caller reaps it.
+ * @return The pid, or -1 on failure.
+ */
+pid_t process_spawn(const ProcessSpec *spec);
+
+/**
+ * @brief Runs one program to completion.
+ * @param usage Receives its resource usage, or NULL.
+ * @return 0 if it exited with status 0 within its timeout, 1 otherwise.
+ */
+int process_run(const ProcessSpec *spec, struct rusage *usage);
+
+#endif // PROCESS_RUNNER_H
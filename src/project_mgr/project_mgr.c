@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <jansson.h>
 
 /**
@@ -64,6 +65,51 @@ static void free_string_array(const char **arr) {
 }
 
 
+// Reads an optional integer setting and checks its range. Returns 0 on success, 1 if it is invalid.
+static int parse_bounded_integer(json_t *section, const char *key, int min, int max, int *value) {
+    json_t *item = json_object_get(section, key);
+    if (!item) return 0;
+    if (!json_is_integer(item) || json_integer_value(item) < min || json_integer_value(item) > max) {
+        fprintf(stderr, "Error: 'isolation.%s' must be an integer between %d and %d.\n", key, min, max);
+        return 1;
+    }
+    *value = (int)json_integer_value(item);
+    return 0;
+}
+
+/**
+ * @brief Fills in the "isolation" section, applying the defaults for missing keys.
+ * @return 0 on success, 1 if a setting is invalid.
+ */
+static int parse_isolation_settings(json_t *section, IsolationSettings *isolation) {
+    isolation->cpu_weight = 20;
+    isolation->io_weight = 20;
+    isolation->nice_level = 10;
+
+    const char *mode = getenv("CODA_ISOLATION");
+    if (!mode || mode[0] == '\0') {
+        json_t *mode_json = json_object_get(section, "mode");
+        mode = json_is_string(mode_json) ? json_string_value(mode_json) : "off";
+    }
+    if (strcmp(mode, "off") != 0 && strcmp(mode, "cgroup") != 0 && strcmp(mode, "nice") != 0) {
+        fprintf(stderr, "Error: Unknown isolation mode '%s'; expected 'off', 'cgroup' or 'nice'.\n", mode);
+        return 1;
+    }
+    isolation->mode = strdup(mode);
+
+    json_t *memory_high_json = json_object_get(section, "memory_high");
+    if (json_is_string(memory_high_json)) isolation->memory_high = strdup(json_string_value(memory_high_json));
+    json_t *cgroup_json = json_object_get(section, "cgroup");
+    if (json_is_string(cgroup_json)) isolation->cgroup = strdup(json_string_value(cgroup_json));
+
+    if (parse_bounded_integer(section, "cpu_weight", 1, 10000, &isolation->cpu_weight) != 0 ||
+        parse_bounded_integer(section, "io_weight", 1, 10000, &isolation->io_weight) != 0 ||
+        parse_bounded_integer(section, "nice", 0, 19, &isolation->nice_level) != 0) {
+        return 1;
+    }
+    return 0;
+}
+
 int parse_config_from_file(const char *path, ProjectConfig *config) {
     json_t *root;
     json_error_t error;
@@ -74,6 +120,11 @@ int parse_config_from_file(const char *path, ProjectConfig *config) {
     config->compiler_flags = NULL;
     config->linker_flags = NULL;
     config->include_paths = NULL;
+    config->remote_cache = NULL;
+    config->build_dir = NULL;
+    config->isolation.mode = NULL;
+    config->isolation.memory_high = NULL;
+    config->isolation.cgroup = NULL;
 
 
     // 1. Load the JSON configuration file
@@ -125,6 +176,37 @@ int parse_config_from_file(const char *path, ProjectConfig *config) {
         return 1;
     }
 
+    // 6. Artifact cache settings. CODA_REMOTE_CACHE lets CI point every project at a shared cache.
+    json_t *cache_json = json_object_get(root, "cache");
+    config->cache_enabled = json_is_false(cache_json) ? 0 : 1;
+
+    const char *remote_cache_env = getenv("CODA_REMOTE_CACHE");
+    json_t *remote_cache_json = json_object_get(root, "remote_cache");
+    if (remote_cache_env && remote_cache_env[0] != '\0') {
+        config->remote_cache = strdup(remote_cache_env);
+    } else if (json_is_string(remote_cache_json)) {
+        config->remote_cache = strdup(json_string_value(remote_cache_json));
+    }
+
+    // 7. Intermediate build directory
+    json_t *build_dir_json = json_object_get(root, "build_dir");
+    config->build_dir = strdup(json_is_string(build_dir_json) ? json_string_value(build_dir_json) : "build");
+
+    // 8. Reproducible builds
+    config->reproducible = json_is_true(json_object_get(root, "reproducible"));
+
+    // 9. Toolchain-specific speedups
+    config->auto_flags = json_is_false(json_object_get(root, "auto_flags")) ? 0 : 1;
+
+    // 10. Build isolation. CODA_ISOLATION lets the owner of a shared host turn it on for every project.
+    if (parse_isolation_settings(json_object_get(root, "isolation"), &config->isolation) != 0) {
+        json_decref(root);
+        return 1;
+    }
+
+    // 11. Compilation database for editors
+    config->compile_commands = json_is_false(json_object_get(root, "compile_commands")) ? 0 : 1;
+
     json_decref(root);
     return 0;
 }
@@ -162,6 +244,178 @@ int add_dependency_to_project_config(const char *package_name, const char *repo_
     return 0;
 }
 
+int load_config_profile(const char *path, const char *profile_name, const char ***flags) {
+    json_error_t error;
+    json_t *root = json_load_file(path, 0, &error);
+    if (!root) {
+        fprintf(stderr, "Error parsing JSON file '%s': on line %d: %s\n", path, error.line, error.text);
+        return 1;
+    }
+
+    json_t *profile = json_object_get(json_object_get(root, "profiles"), profile_name);
+    if (!json_is_object(profile)) {
+        fprintf(stderr, "Error: Profile '%s' is not defined in '%s'.\n", profile_name, path);
+        json_decref(root);
+        return 1;
+    }
+    int rc = parse_string_array(profile, "compiler_flags", flags);
+    json_decref(root);
+    return rc;
+}
+
+int save_config_profile(const char *path, const char *profile_name, const char *const *flags) {
+    json_error_t error;
+    json_t *root = json_load_file(path, 0, &error);
+    if (!root) {
+        fprintf(stderr, "Error parsing JSON file '%s': on line %d: %s\n", path, error.line, error.text);
+        return 1;
+    }
+
+    json_t *profiles = json_object_get(root, "profiles");
+    if (!json_is_object(profiles)) {
+        profiles = json_object();
+        json_object_set_new(root, "profiles", profiles);
+    }
+    json_t *flags_json = json_array();
+    for (int i = 0; flags && flags[i] != NULL; i++) {
+        json_array_append_new(flags_json, json_string(flags[i]));
+    }
+    json_t *profile = json_object();
+    json_object_set_new(profile, "compiler_flags", flags_json);
+    json_object_set_new(profiles, profile_name, profile);
+
+    if (json_dump_file(root, path, JSON_INDENT(2)) != 0) {
+        fprintf(stderr, "Error writing to '%s'\n", path);
+        json_decref(root);
+        return 1;
+    }
+    json_decref(root);
+    return 0;
+}
+
+// Matrix names become directory and file names, so they are kept to a safe character set
+static int is_valid_matrix_name(const char *name) {
+    if (name[0] == '\0' || name[0] == '.') return 0;
+    for (const char *c = name; *c; c++) {
+        if (!isalnum((unsigned char)*c) && *c != '-' && *c != '_' && *c != '.') return 0;
+    }
+    return 1;
+}
+
+int load_config_matrix(const char *path, MatrixConfiguration **configurations, int *count) {
+    *configurations = NULL;
+    *count = 0;
+    json_error_t error;
+    json_t *root = json_load_file(path, 0, &error);
+    if (!root) {
+        fprintf(stderr, "Error parsing JSON file '%s': on line %d: %s\n", path, error.line, error.text);
+        return 1;
+    }
+
+    json_t *matrix = json_object_get(root, "matrix");
+    if (!json_is_object(matrix) || json_object_size(matrix) == 0) {
+        fprintf(stderr, "Error: '%s' has no \"matrix\" section with build configurations.\n", path);
+        json_decref(root);
+        return 1;
+    }
+    MatrixConfiguration *entries = (MatrixConfiguration *)calloc(json_object_size(matrix), sizeof(MatrixConfiguration));
+    if (!entries) {
+        json_decref(root);
+        return 1;
+    }
+
+    int parsed = 0;
+    int rc = 0;
+    const char *name;
+    json_t *entry_json;
+    json_object_foreach(matrix, name, entry_json) {
+        if (!is_valid_matrix_name(name) || !json_is_object(entry_json)) {
+            fprintf(stderr, "Error: Matrix entry '%s' must be an object named with letters, digits, '-', '_' or '.'.\n", name);
+            rc = 1;
+            break;
+        }
+        MatrixConfiguration *entry = &entries[parsed++];
+        json_t *compiler_json = json_object_get(entry_json, "compiler");
+        json_t *output_path_json = json_object_get(entry_json, "output_path");
+        entry->name = strdup(name);
+        entry->compiler = json_is_string(compiler_json) ? strdup(json_string_value(compiler_json)) : NULL;
+        entry->output_path = json_is_string(output_path_json) ? strdup(json_string_value(output_path_json)) : NULL;
+        if (parse_string_array(entry_json, "compiler_flags", &entry->compiler_flags) != 0 ||
+            parse_string_array(entry_json, "linker_flags", &entry->linker_flags) != 0) {
+            rc = 1;
+            break;
+        }
+    }
+    json_decref(root);
+    if (rc != 0) {
+        free_config_matrix(entries, parsed);
+        return 1;
+    }
+    *configurations = entries;
+    *count = parsed;
+    return 0;
+}
+
+void free_config_matrix(MatrixConfiguration *configurations, int count) {
+    for (int i = 0; configurations && i < count; i++) {
+        free((void *)configurations[i].name);
+        free((void *)configurations[i].compiler);
+        free((void *)configurations[i].output_path);
+        free_string_array(configurations[i].compiler_flags);
+        free_string_array(configurations[i].linker_flags);
+    }
+    free(configurations);
+}
+
+// Copies a NULL-terminated string array; a NULL array stays NULL. Returns 0 on success.
+static int copy_string_array(const char **source, const char ***copy) {
+    *copy = NULL;
+    if (!source) return 0;
+    size_t count = 0;
+    while (source[count] != NULL) count++;
+    const char **items = (const char **)calloc(count + 1, sizeof(char *));
+    if (!items) return 1;
+    for (size_t i = 0; i < count; i++) {
+        items[i] = strdup(source[i]);
+        if (!items[i]) {
+            free_string_array(items);
+            return 1;
+        }
+    }
+    *copy = items;
+    return 0;
+}
+
+static const char *copy_string(const char *source) {
+    return source ? strdup(source) : NULL;
+}
+
+int copy_config(const ProjectConfig *source, ProjectConfig *copy) {
+    *copy = *source;
+    copy->project_name = copy_string(source->project_name);
+    copy->compiler = copy_string(source->compiler);
+    copy->output_path = copy_string(source->output_path);
+    copy->remote_cache = copy_string(source->remote_cache);
+    copy->build_dir = copy_string(source->build_dir);
+    copy->isolation.mode = copy_string(source->isolation.mode);
+    copy->isolation.memory_high = copy_string(source->isolation.memory_high);
+    copy->isolation.cgroup = copy_string(source->isolation.cgroup);
+    int rc = copy_string_array(source->source_files, &copy->source_files) |
+             copy_string_array(source->dependencies, &copy->dependencies) |
+             copy_string_array(source->compiler_flags, &copy->compiler_flags) |
+             copy_string_array(source->linker_flags, &copy->linker_flags) |
+             copy_string_array(source->include_paths, &copy->include_paths);
+    if (rc != 0 || (source->project_name && !copy->project_name) || (source->compiler && !copy->compiler) ||
+        (source->output_path && !copy->output_path) || (source->build_dir && !copy->build_dir) ||
+        (source->isolation.mode && !copy->isolation.mode) ||
+        (source->isolation.memory_high && !copy->isolation.memory_high) ||
+        (source->isolation.cgroup && !copy->isolation.cgroup)) {
+        free_config(copy);
+        return 1;
+    }
+    return 0;
+}
+
 void free_config(ProjectConfig *config) {
     if (!config) return;
     
@@ -169,6 +423,11 @@ void free_config(ProjectConfig *config) {
     if (config->project_name) free((void*)config->project_name);
     if (config->compiler) free((void*)config->compiler);
     if (config->output_path) free((void*)config->output_path);
+    if (config->remote_cache) free((void*)config->remote_cache);
+    if (config->build_dir) free((void*)config->build_dir);
+    if (config->isolation.mode) free((void*)config->isolation.mode);
+    if (config->isolation.memory_high) free((void*)config->isolation.memory_high);
+    if (config->isolation.cgroup) free((void*)config->isolation.cgroup);
 
     // Free array fields using the helper function
     free_string_array(config->source_files);
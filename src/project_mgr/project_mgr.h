@@ -3,6 +3,19 @@
 
 #include <jansson.h>
 
+/**
+ * @struct IsolationSettings
+ * @brief The "isolation" section of coda.json: how builds yield to other work on a shared host.
+ */
+typedef struct {
+    const char *mode;            // "off" (default), "cgroup" (falls back to nice/ionice) or "nice"; CODA_ISOLATION overrides it
+    int cpu_weight;              // cgroup cpu.weight, 1-10000 (other cgroups default to 100)
+    int io_weight;               // cgroup io.weight, 1-10000
+    const char *memory_high;     // cgroup memory.high, e.g. "4G"; NULL leaves it unlimited
+    int nice_level;              // niceness (0-19) used when cgroups are unavailable or mode is "nice"
+    const char *cgroup;          // delegated cgroup v2 directory to create the build cgroup in; NULL for Coda's own
+} IsolationSettings;
+
 /**
  * @struct ProjectConfig
  * @brief A structure to hold parsed project configuration data from coda.json.
@@ -22,8 +35,39 @@ typedef struct {
     const char **linker_flags;   // e.g., "-lm", "-lpthread"
     const char **include_paths;  // e.g., "includes/", "modules/libyaml/include/"
 
+    // Artifact caching
+    int cache_enabled;           // "cache": false disables the local and remote artifact cache
+    const char *remote_cache;    // e.g., "http://127.0.0.1:7070"; NULL when not configured
+
+    // Where unity files, objects, depfiles and the build state are written (default "build")
+    const char *build_dir;
+
+    // "reproducible": true makes outputs independent of the checkout path and build time
+    int reproducible;
+
+    // "auto_flags": false stops Coda from adding the fastest options the toolchain supports (-pipe, -fuse-ld=...)
+    int auto_flags;
+
+    // "isolation": limits placed on compiler and git children
+    IsolationSettings isolation;
+
+    // "compile_commands": false stops Coda from maintaining compile_commands.json for editors
+    int compile_commands;
+
 } ProjectConfig;
 
+/**
+ * @struct MatrixConfiguration
+ * @brief One named entry of the "matrix" section of coda.json, built by `coda build --matrix`.
+ */
+typedef struct {
+    const char *name;
+    const char *compiler;        // replaces "compiler" when set
+    const char *output_path;     // NULL for "<output_path>-<name>"
+    const char **compiler_flags; // appended to "compiler_flags"
+    const char **linker_flags;   // appended to "linker_flags"
+} MatrixConfiguration;
+
 /**
  * @brief Parses a coda.json file and populates the ProjectConfig struct.
  * @param path The path to the coda.json file.
@@ -40,6 +84,46 @@ int parse_config_from_file(const char *path, ProjectConfig *config);
  */
 int add_dependency_to_project_config(const char *package_name, const char *repo_url);
 
+/**
+ * @brief Reads the compiler flags of a named build profile from "profiles" in a coda.json file.
+ * @param path The path to the coda.json file.
+ * @param profile_name The profile to read, e.g. "tuned".
+ * @param flags Receives a NULL-terminated array of flags; the caller frees each string and the array.
+ * @return 0 on success, 1 if the file or profile cannot be read.
+ */
+int load_config_profile(const char *path, const char *profile_name, const char ***flags);
+
+/**
+ * @brief Creates or replaces a named build profile in a coda.json file.
+ * @param path The path to the coda.json file.
+ * @param profile_name The profile to write.
+ * @param flags NULL-terminated array of compiler flags stored in the profile.
+ * @return 0 on success, 1 on failure.
+ */
+int save_config_profile(const char *path, const char *profile_name, const char *const *flags);
+
+/**
+ * @brief Reads the "matrix" section of a coda.json file.
+ * @param path The path to the coda.json file.
+ * @param configurations Receives the configurations in file order; free with free_config_matrix().
+ * @param count Receives the number of configurations.
+ * @return 0 on success, 1 if the file cannot be read or the section is missing or malformed.
+ */
+int load_config_matrix(const char *path, MatrixConfiguration **configurations, int *count);
+
+/**
+ * @brief Frees the configurations returned by load_config_matrix().
+ */
+void free_config_matrix(MatrixConfiguration *configurations, int count);
+
+/**
+ * @brief Deep-copies a parsed configuration.
+ * @param source The configuration to copy.
+ * @param copy Receives the copy; release it with free_config().
+ * @return 0 on success, 1 on failure.
+ */
+int copy_config(const ProjectConfig *source, ProjectConfig *copy);
+
 /**
  * @brief Frees all dynamically allocated memory within the ProjectConfig struct.
  * @param config The struct to be freed.
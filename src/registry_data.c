@@ -7,104 +7,105 @@
  * All package names in the registry are standardized to lowercase 
  * for better user experience (UX), similar to npm/pip conventions.
  * * Note: The repository URL must point to the Git repository path.
+ * Entries for very large repositories list their sparse paths (see registry_data.h).
  */
 const DependencyRegistryItem dependency_registry[] = {
     // -----------------------------------------------------------------------
     // 1. JSON & YAML PARSING (Now all lowercase)
     // -----------------------------------------------------------------------
-    {"jansson", "https://github.com/akheron/jansson.git"},
-    {"cjson", "https://github.com/DaveGamble/cJSON.git"},
-    {"rapidjson", "https://github.com/Tencent/rapidjson.git"},
-    {"json-c", "https://github.com/json-c/json-c.git"},
-    {"libyaml", "https://github.com/yaml/libyaml.git"},
+    {"jansson", "https://github.com/akheron/jansson.git", NULL},
+    {"cjson", "https://github.com/DaveGamble/cJSON.git", NULL},
+    {"rapidjson", "https://github.com/Tencent/rapidjson.git", NULL},
+    {"json-c", "https://github.com/json-c/json-c.git", NULL},
+    {"libyaml", "https://github.com/yaml/libyaml.git", NULL},
 
     // -----------------------------------------------------------------------
     // 2. DATA STRUCTURES & CONTAINERS
     // -----------------------------------------------------------------------
-    {"uthash", "https://github.com/troydhanson/uthash.git"},
-    {"sglib", "https://github.com/clibs/sglib.git"},
-    {"p99", "https://github.com/P99-project/p99.git"},
-    {"klib", "https://github.com/attractivechaos/klib.git"},
-    {"vector.h", "https://github.com/eteran/c-vector.git"},
+    {"uthash", "https://github.com/troydhanson/uthash.git", NULL},
+    {"sglib", "https://github.com/clibs/sglib.git", NULL},
+    {"p99", "https://github.com/P99-project/p99.git", NULL},
+    {"klib", "https://github.com/attractivechaos/klib.git", NULL},
+    {"vector.h", "https://github.com/eteran/c-vector.git", NULL},
     
     // -----------------------------------------------------------------------
     // 3. TESTING FRAMEWORKS
     // -----------------------------------------------------------------------
-    {"unity", "https://github.com/ThrowTheSwitch/Unity.git"},
-    {"cgreen", "https://github.com/cgreen-dev/cgreen.git"},
-    {"check", "https://github.com/libcheck/check.git"},
-    {"catch2", "https://github.com/catchorg/Catch2.git"}, 
-    {"doctest", "https://github.com/doctest/doctest.git"}, 
+    {"unity", "https://github.com/ThrowTheSwitch/Unity.git", NULL},
+    {"cgreen", "https://github.com/cgreen-dev/cgreen.git", NULL},
+    {"check", "https://github.com/libcheck/check.git", NULL},
+    {"catch2", "https://github.com/catchorg/Catch2.git", NULL},
+    {"doctest", "https://github.com/doctest/doctest.git", NULL},
     
     // -----------------------------------------------------------------------
     // 4. NETWORKING & WEB
     // -----------------------------------------------------------------------
-    {"libcurl", "https://github.com/curl/curl.git"},
-    {"mongoose", "https://github.com/cesanta/mongoose.git"},
-    {"libwebsockets", "https://github.com/warmcat/libwebsockets.git"},
-    {"h2o", "https://github.com/h2o/h2o.git"},
-    {"lwip", "https://github.com/lwip/lwip.git"},
+    {"libcurl", "https://github.com/curl/curl.git", NULL},
+    {"mongoose", "https://github.com/cesanta/mongoose.git", NULL},
+    {"libwebsockets", "https://github.com/warmcat/libwebsockets.git", NULL},
+    {"h2o", "https://github.com/h2o/h2o.git", NULL},
+    {"lwip", "https://github.com/lwip/lwip.git", NULL},
 
     // -----------------------------------------------------------------------
     // 5. DATABASE & STORAGE
     // -----------------------------------------------------------------------
-    {"sqlite", "https://github.com/sqlite/sqlite.git"},
-    {"hiredis", "https://github.com/redis/hiredis.git"},
-    {"mysql-connector-c", "https://github.com/mysql/mysql-connector-c.git"},
-    {"postgresql-libpq", "https://github.com/postgres/postgres.git"},
+    {"sqlite", "https://github.com/sqlite/sqlite.git", NULL},
+    {"hiredis", "https://github.com/redis/hiredis.git", NULL},
+    {"mysql-connector-c", "https://github.com/mysql/mysql-connector-c.git", NULL},
+    {"postgresql-libpq", "https://github.com/postgres/postgres.git", "src/interfaces/libpq src/include src/common src/port"},
 
     // -----------------------------------------------------------------------
     // 6. GRAPHICS & GUI (Core Libraries)
     // -----------------------------------------------------------------------
-    {"glfw", "https://github.com/glfw/glfw.git"},
-    {"sdl", "https://github.com/libsdl-org/SDL.git"},
-    {"glew", "https://github.com/nigels-com/glew.git"},
-    {"sokol", "https://github.com/floooh/sokol.git"},
-    {"raylib", "https://github.com/raysan5/raylib.git"},
-    {"nuklear", "https://github.com/Immediate-Mode-UI/Nuklear.git"},
+    {"glfw", "https://github.com/glfw/glfw.git", NULL},
+    {"sdl", "https://github.com/libsdl-org/SDL.git", NULL},
+    {"glew", "https://github.com/nigels-com/glew.git", NULL},
+    {"sokol", "https://github.com/floooh/sokol.git", NULL},
+    {"raylib", "https://github.com/raysan5/raylib.git", NULL},
+    {"nuklear", "https://github.com/Immediate-Mode-UI/Nuklear.git", NULL},
 
     // -----------------------------------------------------------------------
     // 7. COMPRESSION & CRYPTO
     // -----------------------------------------------------------------------
-    {"zlib", "https://github.com/madler/zlib.git"},
-    {"libzip", "https://github.com/nih-at/libzip.git"},
-    {"openssl", "https://github.com/openssl/openssl.git"},
-    {"libsodium", "https://github.com/jedisct1/libsodium.git"},
-    {"mbedtls", "https://github.com/Mbed-TLS/mbedtls.git"},
+    {"zlib", "https://github.com/madler/zlib.git", NULL},
+    {"libzip", "https://github.com/nih-at/libzip.git", NULL},
+    {"openssl", "https://github.com/openssl/openssl.git", "include crypto ssl providers"},
+    {"libsodium", "https://github.com/jedisct1/libsodium.git", NULL},
+    {"mbedtls", "https://github.com/Mbed-TLS/mbedtls.git", NULL},
 
     // -----------------------------------------------------------------------
     // 8. LOGGING & UTILITIES
     // -----------------------------------------------------------------------
-    {"loguru", "https://github.com/emilk/loguru.git"}, 
-    {"spdlog", "https://github.com/gabime/spdlog.git"}, 
-    {"argparse", "https://github.com/kazan-s/argparse.git"},
-    {"docopt", "https://github.com/docopt/docopt.c.git"},
-    {"inih", "https://github.com/benhoyt/inih.git"},
+    {"loguru", "https://github.com/emilk/loguru.git", NULL},
+    {"spdlog", "https://github.com/gabime/spdlog.git", NULL},
+    {"argparse", "https://github.com/kazan-s/argparse.git", NULL},
+    {"docopt", "https://github.com/docopt/docopt.c.git", NULL},
+    {"inih", "https://github.com/benhoyt/inih.git", NULL},
     
     // -----------------------------------------------------------------------
     // 9. EVENT DRIVEN & CONCURRENCY
     // -----------------------------------------------------------------------
-    {"libevent", "https://github.com/libevent/libevent.git"},
-    {"libuv", "https://github.com/libuv/libuv.git"},
-    {"protobuf", "https://github.com/protocolbuffers/protobuf.git"},
-    {"grpc", "https://github.com/grpc/grpc.git"},
+    {"libevent", "https://github.com/libevent/libevent.git", NULL},
+    {"libuv", "https://github.com/libuv/libuv.git", NULL},
+    {"protobuf", "https://github.com/protocolbuffers/protobuf.git", NULL},
+    {"grpc", "https://github.com/grpc/grpc.git", "include src/core"},
 
     // -----------------------------------------------------------------------
     // 10. MATH & ALGEBRA
     // -----------------------------------------------------------------------
-    {"blas", "https://github.com/Reference-LAPACK/blas.git"}, 
-    {"cglm", "https://github.com/recp/cglm.git"}, 
-    {"libomp", "https://github.com/llvm/llvm-project.git"}, 
-    {"gsl", "https://github.com/ampl/gsl.git"}, 
+    {"blas", "https://github.com/Reference-LAPACK/blas.git", NULL},
+    {"cglm", "https://github.com/recp/cglm.git", NULL},
+    {"libomp", "https://github.com/llvm/llvm-project.git", "openmp cmake"},
+    {"gsl", "https://github.com/ampl/gsl.git", NULL},
     
     // -----------------------------------------------------------------------
     // 11. AUDIO & MULTIMEDIA
     // -----------------------------------------------------------------------
-    {"portaudio", "https://github.com/PortAudio/portaudio.git"},
-    {"stb", "https://github.com/nothings/stb.git"}, 
+    {"portaudio", "https://github.com/PortAudio/portaudio.git", NULL},
+    {"stb", "https://github.com/nothings/stb.git", "*.h"},
 
     // -----------------------------------------------------------------------
     // END OF LIST
     // -----------------------------------------------------------------------
-    {NULL, NULL} // Mandatory terminator
+    {NULL, NULL, NULL} // Mandatory terminator
 };
@@ -5,10 +5,14 @@
  * @brief Structure to define a single entry in the Coda dependency registry.
  * * The 'name' is the package name used in 'coda install <name>'.
  * The 'url' is the git repository URL used for cloning.
+ * The 'sparse_paths' lists, separated by spaces, the files and directories a
+ * project actually needs from a large repository (e.g. "openmp cmake"). Only
+ * those are fetched and checked out. NULL means the whole repository.
  */
 typedef struct {
     const char *name;
     const char *url;
+    const char *sparse_paths;
 } DependencyRegistryItem;
 
 /**
@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+
+#include "remote_cache.h"
+
+// Network operations give up after this long so a dead cache never stalls a build.
+#define REMOTE_CACHE_TIMEOUT_MS 5000
+#define HTTP_HEADER_MAX 8192
+
+/**
+ * @struct RemoteUrl
+ * @brief The pieces of an "http://host:port/prefix" cache URL. IPv6 hosts are
+ * written in brackets ("http://[::1]:7070/"), which are kept in `authority`
+ * (sent as the Host header) but stripped from `host` (passed to getaddrinfo).
+ */
+typedef struct {
+    char authority[256];
+    char host[256];
+    char port[16];
+    char path_prefix[512];
+} RemoteUrl;
+
+/**
+ * @brief Splits a cache URL into host, port and path prefix.
+ * Only plain HTTP is supported; the cache is meant for trusted CI networks.
+ * @return 0 on success, 1 on failure.
+ */
+static int parse_remote_url(const char *base_url, RemoteUrl *url) {
+    const char *scheme = "http://";
+    if (strncmp(base_url, scheme, strlen(scheme)) != 0) {
+        fprintf(stderr, "[WARN] Remote cache URL must start with http://: %s\n", base_url);
+        return 1;
+    }
+    const char *host_start = base_url + strlen(scheme);
+    const char *path_start = strchr(host_start, '/');
+    size_t authority_len = path_start ? (size_t)(path_start - host_start) : strlen(host_start);
+
+    char authority[256];
+    if (authority_len == 0 || authority_len >= sizeof(authority)) {
+        fprintf(stderr, "[WARN] Invalid remote cache URL: %s\n", base_url);
+        return 1;
+    }
+    memcpy(authority, host_start, authority_len);
+    authority[authority_len] = '\0';
+
+    snprintf(url->authority, sizeof(url->authority), "%s", authority);
+
+    // The port follows the last colon, except inside an IPv6 literal's brackets
+    char *host = authority;
+    char *host_end = NULL;
+    if (authority[0] == '[') {
+        host_end = strchr(authority, ']');
+        if (!host_end || (host_end[1] != '\0' && host_end[1] != ':')) {
+            fprintf(stderr, "[WARN] Invalid remote cache URL: %s\n", base_url);
+            return 1;
+        }
+        host++;
+    }
+    char *colon = strrchr(host_end ? host_end : authority, ':');
+    if (colon) {
+        *colon = '\0';
+        snprintf(url->port, sizeof(url->port), "%s", colon + 1);
+    } else {
+        snprintf(url->port, sizeof(url->port), "80");
+    }
+    if (host_end) *host_end = '\0';
+    snprintf(url->host, sizeof(url->host), "%s", host);
+
+    // Normalize the prefix so that "<prefix>/<key>" is always a valid path.
+    snprintf(url->path_prefix, sizeof(url->path_prefix), "%s", path_start ? path_start : "");
+    size_t prefix_len = strlen(url->path_prefix);
+    while (prefix_len > 0 && url->path_prefix[prefix_len - 1] == '/') {
+        url->path_prefix[--prefix_len] = '\0';
+    }
+    return 0;
+}
+
+/**
+ * @brief Opens a TCP connection to the cache, bounded by REMOTE_CACHE_TIMEOUT_MS.
+ * @return A connected socket, or -1 on failure.
+ */
+static int connect_to_cache(const RemoteUrl *url) {
+    struct addrinfo hints, *results = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(url->host, url->port, &hints, &results) != 0) {
+        return -1;
+    }
+
+    int sock = -1;
+    for (struct addrinfo *ai = results; ai != NULL; ai = ai->ai_next) {
+        sock = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (sock < 0) continue;
+
+        int rc = connect(sock, ai->ai_addr, ai->ai_addrlen);
+        if (rc < 0 && errno == EINPROGRESS) {
+            struct pollfd pfd = { .fd = sock, .events = POLLOUT };
+            int so_error = 0;
+            socklen_t so_len = sizeof(so_error);
+            if (poll(&pfd, 1, REMOTE_CACHE_TIMEOUT_MS) == 1 &&
+                getsockopt(sock, SOL_SOCKET, SO_ERROR, &so_error, &so_len) == 0 && so_error == 0) {
+                rc = 0;
+            }
+        }
+        if (rc == 0) break;
+        close(sock);
+        sock = -1;
+    }
+    freeaddrinfo(results);
+    if (sock < 0) return -1;
+
+    // Switch back to blocking I/O with socket-level timeouts for the transfer itself.
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) & ~O_NONBLOCK);
+    struct timeval tv = { .tv_sec = REMOTE_CACHE_TIMEOUT_MS / 1000, .tv_usec = 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    return sock;
+}
+
+static int send_all(int sock, const void *data, size_t len) {
+    const char *bytes = (const char *)data;
+    while (len > 0) {
+        ssize_t n = send(sock, bytes, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 1;
+        }
+        bytes += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Reads the status line and headers of an HTTP response.
+ * Any body bytes read past the header are returned through body_start/body_len.
+ * @return The HTTP status code, or -1 on failure.
+ */
+static int read_response_head(int sock, char *buffer, size_t buffer_size, long long *content_length,
+                              char **body_start, size_t *body_len) {
+    size_t used = 0;
+    char *header_end = NULL;
+    while (!header_end) {
+        if (used + 1 >= buffer_size) return -1;
+        ssize_t n = recv(sock, buffer + used, buffer_size - used - 1, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        used += (size_t)n;
+        buffer[used] = '\0';
+        header_end = strstr(buffer, "\r\n\r\n");
+    }
+
+    int status = -1;
+    if (sscanf(buffer, "HTTP/%*d.%*d %d", &status) != 1) return -1;
+
+    *content_length = -1;
+    for (char *line = strstr(buffer, "\r\n"); line && line < header_end; line = strstr(line + 2, "\r\n")) {
+        if (strncasecmp(line + 2, "Content-Length:", 15) == 0) {
+            *content_length = strtoll(line + 2 + 15, NULL, 10);
+        }
+    }
+
+    *body_start = header_end + 4;
+    *body_len = used - (size_t)(*body_start - buffer);
+    return status;
+}
+
+int remote_cache_fetch(const char *base_url, const char *key, const char *dest_path) {
+    RemoteUrl url;
+    if (parse_remote_url(base_url, &url) != 0) return 1;
+
+    int sock = connect_to_cache(&url);
+    if (sock < 0) {
+        fprintf(stderr, "[WARN] Remote cache %s is unreachable.\n", base_url);
+        return 1;
+    }
+
+    char request[1024];
+    int request_len = snprintf(request, sizeof(request),
+                               "GET %s/%s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n",
+                               url.path_prefix, key, url.authority);
+    char head[HTTP_HEADER_MAX];
+    long long content_length;
+    char *body;
+    size_t body_len;
+    if (send_all(sock, request, (size_t)request_len) != 0 ||
+        read_response_head(sock, head, sizeof(head), &content_length, &body, &body_len) != 200) {
+        close(sock);
+        return 1;
+    }
+
+    // Stream into a temporary file and rename it so readers never see a partial blob.
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.download.%d", dest_path, (int)getpid());
+    FILE *fp = fopen(temp_path, "wb");
+    if (!fp) {
+        close(sock);
+        return 1;
+    }
+
+    long long received = (long long)body_len;
+    int failed = fwrite(body, 1, body_len, fp) != body_len;
+    char chunk[65536];
+    while (!failed && (content_length < 0 || received < content_length)) {
+        ssize_t n = recv(sock, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) failed = 1;
+        if (n <= 0) break;
+        if (fwrite(chunk, 1, (size_t)n, fp) != (size_t)n) failed = 1;
+        received += n;
+    }
+    close(sock);
+    if (fclose(fp) != 0) failed = 1;
+
+    if (failed || (content_length >= 0 && received != content_length) || rename(temp_path, dest_path) != 0) {
+        unlink(temp_path);
+        return 1;
+    }
+    return 0;
+}
+
+int remote_cache_upload(const char *base_url, const char *key, const char *src_path) {
+    RemoteUrl url;
+    if (parse_remote_url(base_url, &url) != 0) return 1;
+
+    FILE *fp = fopen(src_path, "rb");
+    if (!fp) return 1;
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0) {
+        fclose(fp);
+        return 1;
+    }
+
+    int sock = connect_to_cache(&url);
+    if (sock < 0) {
+        fclose(fp);
+        return 1;
+    }
+
+    char request[1024];
+    int request_len = snprintf(request, sizeof(request),
+                               "PUT %s/%s HTTP/1.1\r\nHost: %s\r\nContent-Type: application/octet-stream\r\n"
+                               "Content-Length: %lld\r\nConnection: close\r\n\r\n",
+                               url.path_prefix, key, url.authority, (long long)st.st_size);
+    int failed = send_all(sock, request, (size_t)request_len);
+
+    char chunk[65536];
+    size_t n;
+    while (!failed && (n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        failed = send_all(sock, chunk, n);
+    }
+    fclose(fp);
+
+    char head[HTTP_HEADER_MAX];
+    long long content_length;
+    char *body;
+    size_t body_len;
+    int status = failed ? -1 : read_response_head(sock, head, sizeof(head), &content_length, &body, &body_len);
+    close(sock);
+    return (status == 200 || status == 201) ? 0 : 1;
+}
+
+int remote_cache_upload_async(const char *base_url, const char *key, const char *src_path) {
+    // Double fork: the intermediate child exits at once, so the uploader is
+    // re-parented to init and never becomes a zombie of a long-lived `coda watch`.
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("[WARN] Failed to fork remote cache uploader");
+        return 1;
+    }
+    if (pid == 0) {
+        if (fork() == 0) {
+            int rc = remote_cache_upload(base_url, key, src_path);
+            if (rc != 0) {
+                fprintf(stderr, "[WARN] Remote cache upload of %.12s failed.\n", key);
+            }
+            _exit(rc);
+        }
+        _exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return 0;
+}
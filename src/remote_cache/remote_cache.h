@@ -0,0 +1,34 @@
+#ifndef REMOTE_CACHE_H
+#define REMOTE_CACHE_H
+
+/**
+ * @brief Downloads a cached artifact from a remote HTTP cache.
+ * The blob is requested with `GET <base_url>/<key>` and written atomically to dest_path.
+ * @param base_url The cache URL, e.g. "http://127.0.0.1:7070".
+ * @param key The hex action key of the artifact.
+ * @param dest_path Where to store the downloaded blob.
+ * @return 0 on a cache hit, 1 on a miss or any error.
+ */
+int remote_cache_fetch(const char *base_url, const char *key, const char *dest_path);
+
+/**
+ * @brief Uploads an artifact to a remote HTTP cache with `PUT <base_url>/<key>`.
+ * @param base_url The cache URL.
+ * @param key The hex action key of the artifact.
+ * @param src_path The file to upload.
+ * @return 0 on success, 1 on failure.
+ */
+int remote_cache_upload(const char *base_url, const char *key, const char *src_path);
+
+/**
+ * @brief Uploads an artifact from a detached background process so the build
+ * does not wait on the network.
+ * @param base_url The cache URL.
+ * @param key The hex action key of the artifact.
+ * @param src_path The file to upload. It must not change until the upload is
+ * done, which is why callers pass the immutable local cache entry.
+ * @return 0 if the upload was started, 1 otherwise.
+ */
+int remote_cache_upload_async(const char *base_url, const char *key, const char *src_path);
+
+#endif // REMOTE_CACHE_H
@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "stats_utils.h"
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int summarize_samples(const double *samples, int count, SampleSummary *summary) {
+    memset(summary, 0, sizeof(*summary));
+    if (count < 1) return 1;
+
+    double *sorted = (double *)malloc(sizeof(double) * (size_t)count);
+    if (!sorted) {
+        perror("Failed to allocate memory for samples");
+        return 1;
+    }
+    memcpy(sorted, samples, sizeof(double) * (size_t)count);
+    qsort(sorted, (size_t)count, sizeof(double), compare_doubles);
+
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) sum += sorted[i];
+    summary->count = count;
+    summary->mean = sum / count;
+    summary->min = sorted[0];
+    summary->max = sorted[count - 1];
+    summary->median = (count % 2) ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2.0;
+
+    if (count > 1) {
+        double squares = 0.0;
+        for (int i = 0; i < count; i++) {
+            double delta = sorted[i] - summary->mean;
+            squares += delta * delta;
+        }
+        summary->stddev = sqrt(squares / (count - 1));
+        summary->ci95_half_width = t_critical_95(count - 1) * summary->stddev / sqrt((double)count);
+    }
+    free(sorted);
+    return 0;
+}
+
+double t_critical_95(double degrees_of_freedom) {
+    // Two-sided 95% quantiles for 1..30 degrees of freedom
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    int df = (int)floor(degrees_of_freedom);
+    if (df < 1) return table[0];
+    if (df <= 30) return table[df - 1];
+    if (df <= 40) return 2.021;
+    if (df <= 60) return 2.000;
+    if (df <= 120) return 1.980;
+    return 1.960;
+}
+
+void welch_t_test(const SampleSummary *a, const SampleSummary *b, WelchResult *result) {
+    memset(result, 0, sizeof(*result));
+    if (a->count < 2 || b->count < 2) return;
+
+    double var_a = a->stddev * a->stddev / a->count;
+    double var_b = b->stddev * b->stddev / b->count;
+    double standard_error = sqrt(var_a + var_b);
+    if (standard_error == 0.0) {
+        // Identical, noise-free samples: any difference in means is real
+        result->significant = a->mean != b->mean;
+        result->degrees_of_freedom = a->count + b->count - 2;
+        return;
+    }
+
+    result->t = (a->mean - b->mean) / standard_error;
+    result->degrees_of_freedom = (var_a + var_b) * (var_a + var_b) /
+        (var_a * var_a / (a->count - 1) + var_b * var_b / (b->count - 1));
+    result->significant = fabs(result->t) > t_critical_95(result->degrees_of_freedom);
+}
@@ -0,0 +1,51 @@
+#ifndef STATS_UTILS_H
+#define STATS_UTILS_H
+
+/**
+ * @struct SampleSummary
+ * @brief Descriptive statistics of a set of measurements.
+ */
+typedef struct {
+    int count;
+    double mean;
+    double median;
+    double min;
+    double max;
+    double stddev;           // sample standard deviation (n - 1)
+    double ci95_half_width;  // the mean's 95% confidence interval is mean +/- this value
+} SampleSummary;
+
+/**
+ * @struct WelchResult
+ * @brief The outcome of Welch's unequal-variance t-test between two samples.
+ */
+typedef struct {
+    double t;                // (mean_a - mean_b) / standard error of the difference
+    double degrees_of_freedom; // Welch-Satterthwaite approximation
+    int significant;         // 1 if the means differ at the 95% level (two-sided)
+} WelchResult;
+
+/**
+ * @brief Summarizes a set of measurements.
+ * @param samples The measurements.
+ * @param count The number of measurements; at least 1.
+ * @param summary Receives the statistics.
+ * @return 0 on success, 1 on failure.
+ */
+int summarize_samples(const double *samples, int count, SampleSummary *summary);
+
+/**
+ * @brief Returns the two-sided 95% critical value of Student's t distribution.
+ * @param degrees_of_freedom The degrees of freedom (fractional values are rounded down).
+ */
+double t_critical_95(double degrees_of_freedom);
+
+/**
+ * @brief Runs Welch's t-test on two summarized samples.
+ * @param a The first sample.
+ * @param b The second sample.
+ * @param result Receives the test statistic and verdict.
+ */
+void welch_t_test(const SampleSummary *a, const SampleSummary *b, WelchResult *result);
+
+#endif // STATS_UTILS_H
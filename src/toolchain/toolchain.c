@@ -0,0 +1,349 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <jansson.h>
+
+#include "toolchain.h"
+#include "project_mgr.h"
+#include "core_utils.h"
+#include "hash_utils.h"
+#include "process_runner.h"
+
+// Bump when probes are added or changed, so cached results from older versions are redone
+#define PROBE_VERSION 2
+#define PROBE_TIMEOUT_MS 30000
+#define MAX_MEMOIZED_TOOLCHAINS 8
+
+// Fastest first; the first one that links a test program is used
+static const char *const linker_candidates[] = { "-fuse-ld=mold", "-fuse-ld=lld", NULL };
+// The programs those flags run; a probe is redone when one of them is installed, replaced or removed
+static const char *const linker_programs[] = { "ld.mold", "ld.lld", NULL };
+
+/**
+ * @struct ToolchainSlot
+ * @brief A probed toolchain remembered for the rest of the process.
+ */
+typedef struct {
+    char *compiler;
+    int found;                  // 0 if the compiler could not be probed
+    Toolchain toolchain;
+} ToolchainSlot;
+
+static ToolchainSlot memoized[MAX_MEMOIZED_TOOLCHAINS];
+static int memoized_count = 0;
+
+static const char *family_name(ToolchainFamily family) {
+    switch (family) {
+        case TOOLCHAIN_CLANG: return "clang";
+        case TOOLCHAIN_GCC: return "gcc";
+        default: return "unknown";
+    }
+}
+
+static ToolchainFamily detect_family(const char *version) {
+    if (strstr(version, "clang")) return TOOLCHAIN_CLANG;
+    if (strstr(version, "Free Software Foundation") || strstr(version, "gcc") || strstr(version, "GCC")) {
+        return TOOLCHAIN_GCC;
+    }
+    return TOOLCHAIN_UNKNOWN;
+}
+
+// Finds the binary a compiler name runs (searching PATH like execvp) and resolves symlinks,
+// so that switching e.g. /usr/bin/cc to another compiler changes the key.
+static int resolve_compiler(const char *compiler, char *out) {
+    if (strchr(compiler, '/')) {
+        return realpath(compiler, out) ? 0 : 1;
+    }
+    const char *path_env = getenv("PATH");
+    char *paths = strdup(path_env ? path_env : "/usr/local/bin:/usr/bin:/bin");
+    if (!paths) return 1;
+    int rc = 1;
+    for (char *dir = strtok(paths, ":"); dir && rc != 0; dir = strtok(NULL, ":")) {
+        char candidate[PATH_MAX];
+        snprintf(candidate, sizeof(candidate), "%s/%s", dir[0] ? dir : ".", compiler);
+        if (access(candidate, X_OK) == 0 && realpath(candidate, out)) rc = 0;
+    }
+    free(paths);
+    return rc;
+}
+
+// Describes which candidate linkers are installed, e.g. "ld.mold=/usr/bin/ld.mold:1234:1700000000.5;ld.lld=-;"
+static void describe_linkers(char *out, size_t size) {
+    size_t used = 0;
+    out[0] = '\0';
+    for (int i = 0; linker_programs[i] != NULL && used < size; i++) {
+        char path[PATH_MAX];
+        struct stat st;
+        int n;
+        if (resolve_compiler(linker_programs[i], path) == 0 && stat(path, &st) == 0) {
+            n = snprintf(out + used, size - used, "%s=%s:%lld:%lld.%ld;", linker_programs[i], path,
+                         (long long)st.st_size, (long long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec);
+        } else {
+            n = snprintf(out + used, size - used, "%s=-;", linker_programs[i]);
+        }
+        used += n > 0 ? (size_t)n : 0;
+    }
+}
+
+// Returns "<cache dir>/<hash of compiler name and binary>.json", or 1 if there is no cache directory.
+static int probe_cache_path(const char *compiler, const char *resolved, char *dir, size_t dir_size, char *path,
+                            size_t path_size) {
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    if (xdg && xdg[0] == '/') {
+        snprintf(dir, dir_size, "%s/coda/toolchains", xdg);
+    } else if (home && home[0] != '\0') {
+        snprintf(dir, dir_size, "%s/.cache/coda/toolchains", home);
+    } else {
+        return 1;
+    }
+    // clang and clang++ can be the same binary but behave differently, so the name is part of the key
+    HashContext ctx;
+    char key[HASH_HEX_LEN];
+    hash_init(&ctx);
+    hash_update_string(&ctx, compiler);
+    hash_update_string(&ctx, resolved);
+    hash_final_hex(&ctx, key);
+    snprintf(path, path_size, "%s/%s.json", dir, key);
+    return 0;
+}
+
+static const char *known_linker(const char *flag) {
+    for (int i = 0; flag && linker_candidates[i] != NULL; i++) {
+        if (strcmp(flag, linker_candidates[i]) == 0) return linker_candidates[i];
+    }
+    return NULL;
+}
+
+// Loads a cached probe if it was made for exactly this binary (same size and mtime) and the same linkers.
+static int load_cached_probe(const char *cache_path, const struct stat *st, const char *linkers, Toolchain *toolchain) {
+    json_error_t error;
+    json_t *root = json_load_file(cache_path, 0, &error);
+    if (!root) return 1;
+    json_t *version = json_object_get(root, "version");
+    const char *path = json_string_value(json_object_get(root, "path"));
+    const char *cached_linkers = json_string_value(json_object_get(root, "linkers"));
+    int valid = json_integer_value(json_object_get(root, "probe_version")) == PROBE_VERSION &&
+                cached_linkers && strcmp(cached_linkers, linkers) == 0 &&
+                json_is_string(version) && path && strcmp(path, toolchain->path) == 0 &&
+                json_integer_value(json_object_get(root, "size")) == (json_int_t)st->st_size &&
+                json_integer_value(json_object_get(root, "mtime_sec")) == (json_int_t)st->st_mtim.tv_sec &&
+                json_integer_value(json_object_get(root, "mtime_nsec")) == (json_int_t)st->st_mtim.tv_nsec;
+    if (valid) {
+        const char *target = json_string_value(json_object_get(root, "target"));
+        const char *sysroot = json_string_value(json_object_get(root, "sysroot"));
+        toolchain->version = strdup(json_string_value(version));
+        toolchain->family = detect_family(toolchain->version);
+        snprintf(toolchain->target, sizeof(toolchain->target), "%s", target ? target : "");
+        snprintf(toolchain->sysroot, sizeof(toolchain->sysroot), "%s", sysroot ? sysroot : "");
+        toolchain->supports_pipe = json_is_true(json_object_get(root, "pipe"));
+        toolchain->supports_time_trace = json_is_true(json_object_get(root, "time_trace"));
+        toolchain->supports_pch = json_is_true(json_object_get(root, "pch"));
+        toolchain->fast_linker = known_linker(json_string_value(json_object_get(root, "fast_linker")));
+    }
+    json_decref(root);
+    return valid && toolchain->version ? 0 : 1;
+}
+
+static void save_cached_probe(const char *cache_dir, const char *cache_path, const struct stat *st,
+                              const char *linkers, const Toolchain *toolchain) {
+    json_t *root = json_object();
+    json_object_set_new(root, "probe_version", json_integer(PROBE_VERSION));
+    json_object_set_new(root, "path", json_string(toolchain->path));
+    json_object_set_new(root, "size", json_integer((json_int_t)st->st_size));
+    json_object_set_new(root, "mtime_sec", json_integer((json_int_t)st->st_mtim.tv_sec));
+    json_object_set_new(root, "mtime_nsec", json_integer((json_int_t)st->st_mtim.tv_nsec));
+    json_object_set_new(root, "family", json_string(family_name(toolchain->family)));
+    json_object_set_new(root, "version", json_string(toolchain->version));
+    json_object_set_new(root, "target", json_string(toolchain->target));
+    json_object_set_new(root, "sysroot", json_string(toolchain->sysroot));
+    json_object_set_new(root, "pipe", json_boolean(toolchain->supports_pipe));
+    json_object_set_new(root, "time_trace", json_boolean(toolchain->supports_time_trace));
+    json_object_set_new(root, "pch", json_boolean(toolchain->supports_pch));
+    json_object_set_new(root, "fast_linker", toolchain->fast_linker ? json_string(toolchain->fast_linker) : json_null());
+    json_object_set_new(root, "linkers", json_string(linkers));
+
+    // Parallel builds (e.g. workspace members) may probe at the same time; the rename keeps the file whole
+    char temp_path[PATH_MAX + 128];
+    snprintf(temp_path, sizeof(temp_path), "%s.%d.tmp", cache_path, (int)getpid());
+    if (ensure_directory(cache_dir) != 0 || json_dump_file(root, temp_path, JSON_INDENT(2)) != 0 ||
+        rename(temp_path, cache_path) != 0) {
+        unlink(temp_path);
+        fprintf(stderr, "[WARN] Failed to cache the toolchain probe in %s.\n", cache_dir);
+    }
+    json_decref(root);
+}
+
+// Runs one probe command with its output discarded (or sent to stdout_path). Returns 0 if it succeeded.
+static int run_probe(char **argv, const char *stdout_path) {
+    ProcessSpec spec = { 0 };
+    spec.argv = argv;
+    spec.stdout_path = stdout_path ? stdout_path : "/dev/null";
+    spec.stderr_path = "/dev/null";
+    spec.timeout_ms = PROBE_TIMEOUT_MS;
+    return process_run(&spec, NULL);
+}
+
+// Runs a probe and returns the first line of its output in `out` ("" on failure).
+static void probe_first_line(char **argv, const char *output_path, char *out, size_t size) {
+    out[0] = '\0';
+    if (run_probe(argv, output_path) != 0) return;
+    char *output = read_file_to_string(output_path);
+    if (!output) return;
+    output[strcspn(output, "\r\n")] = '\0';
+    snprintf(out, size, "%s", output);
+    free(output);
+}
+
+static int write_text_file(const char *path, const char *text) {
+    FILE *file = fopen(path, "w");
+    if (!file) return 1;
+    int rc = fputs(text, file) < 0;
+    if (fclose(file) != 0) rc = 1;
+    return rc;
+}
+
+static void remove_probe_dir(const char *dir) {
+    DIR *handle = opendir(dir);
+    if (handle) {
+        struct dirent *entry;
+        while ((entry = readdir(handle)) != NULL) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "%s/%.255s", dir, entry->d_name);
+            unlink(path);
+        }
+        closedir(handle);
+    }
+    rmdir(dir);
+}
+
+/**
+ * @brief Runs the compiler against tiny test inputs in a scratch directory to
+ * find out what it is and which optional flags it accepts.
+ * @return 0 on success, 1 if the compiler cannot be run at all.
+ */
+static int run_probes(const char *compiler, Toolchain *toolchain) {
+    const char *tmp = getenv("TMPDIR");
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s/coda-probe-XXXXXX", tmp && tmp[0] ? tmp : "/tmp");
+    if (!mkdtemp(dir)) {
+        perror("[ERROR] Failed to create a directory for the toolchain probe");
+        return 1;
+    }
+    char out_path[PATH_MAX + 16], source[PATH_MAX + 16], header[PATH_MAX + 16], pch[PATH_MAX + 16];
+    char object[PATH_MAX + 16], program[PATH_MAX + 16];
+    snprintf(out_path, sizeof(out_path), "%s/out.txt", dir);
+    snprintf(source, sizeof(source), "%s/probe.c", dir);
+    snprintf(header, sizeof(header), "%s/probe.h", dir);
+    snprintf(pch, sizeof(pch), "%s/probe.h.gch", dir);
+    snprintf(object, sizeof(object), "%s/probe.o", dir);
+    snprintf(program, sizeof(program), "%s/probe", dir);
+    char *cc = (char *)compiler;
+
+    // 1. Identity: version, target triple and sysroot
+    char *version_argv[] = { cc, "--version", NULL };
+    if (run_probe(version_argv, out_path) != 0 || !(toolchain->version = read_file_to_string(out_path))) {
+        remove_probe_dir(dir);
+        return 1;
+    }
+    toolchain->family = detect_family(toolchain->version);
+    char *target_argv[] = { cc, "-dumpmachine", NULL };
+    probe_first_line(target_argv, out_path, toolchain->target, sizeof(toolchain->target));
+    char *sysroot_argv[] = { cc, "-print-sysroot", NULL };
+    probe_first_line(sysroot_argv, out_path, toolchain->sysroot, sizeof(toolchain->sysroot));
+
+    // 2. Optional compiler features, each tried on a trivial translation unit
+    if (write_text_file(source, "int main(void) { return 0; }\n") == 0 &&
+        write_text_file(header, "int coda_probe(void);\n") == 0) {
+        char *pipe_argv[] = { cc, "-Werror", "-pipe", "-c", source, "-o", object, NULL };
+        toolchain->supports_pipe = run_probe(pipe_argv, NULL) == 0;
+        char *trace_argv[] = { cc, "-Werror", "-ftime-trace", "-c", source, "-o", object, NULL };
+        toolchain->supports_time_trace = run_probe(trace_argv, NULL) == 0;
+        char *pch_argv[] = { cc, "-x", "c-header", header, "-o", pch, NULL };
+        toolchain->supports_pch = run_probe(pch_argv, NULL) == 0 && access(pch, F_OK) == 0;
+
+        // 3. The fastest linker that actually links a program
+        for (int i = 0; linker_candidates[i] != NULL && !toolchain->fast_linker; i++) {
+            char *link_argv[] = { cc, (char *)linker_candidates[i], source, "-o", program, NULL };
+            if (run_probe(link_argv, NULL) == 0) toolchain->fast_linker = linker_candidates[i];
+        }
+    }
+    remove_probe_dir(dir);
+    return 0;
+}
+
+const Toolchain *toolchain_probe(const char *compiler) {
+    for (int i = 0; i < memoized_count; i++) {
+        if (strcmp(memoized[i].compiler, compiler) == 0) return memoized[i].found ? &memoized[i].toolchain : NULL;
+    }
+    if (memoized_count == MAX_MEMOIZED_TOOLCHAINS) return NULL;
+    ToolchainSlot *slot = &memoized[memoized_count];
+    slot->compiler = strdup(compiler);
+    if (!slot->compiler) return NULL;
+    memoized_count++;
+
+    Toolchain toolchain;
+    memset(&toolchain, 0, sizeof(toolchain));
+    struct stat st;
+    if (resolve_compiler(compiler, toolchain.path) != 0 || stat(toolchain.path, &st) != 0) {
+        fprintf(stderr, "[ERROR] Compiler '%s' was not found.\n", compiler);
+        return NULL;
+    }
+
+    // 1. Reuse the cached probe of this exact binary, otherwise probe and cache it
+    char cache_dir[PATH_MAX], cache_path[PATH_MAX + 80], linkers[2 * PATH_MAX + 256];
+    int have_cache = probe_cache_path(compiler, toolchain.path, cache_dir, sizeof(cache_dir), cache_path,
+                                      sizeof(cache_path)) == 0;
+    describe_linkers(linkers, sizeof(linkers));
+    if (!have_cache || load_cached_probe(cache_path, &st, linkers, &toolchain) != 0) {
+        free(toolchain.version);
+        toolchain.version = NULL;
+        printf("[LOG] Probing toolchain '%s'...\n", compiler);
+        if (run_probes(compiler, &toolchain) != 0) {
+            fprintf(stderr, "[ERROR] Compiler '%s' could not be run.\n", compiler);
+            return NULL;
+        }
+        if (have_cache) save_cached_probe(cache_dir, cache_path, &st, linkers, &toolchain);
+    }
+
+    // 2. Remember it for the rest of the process
+    slot->toolchain = toolchain;
+    slot->found = 1;
+    return &slot->toolchain;
+}
+
+void toolchain_version_line(const Toolchain *toolchain, char *out, size_t size) {
+    snprintf(out, size, "%.*s", (int)strcspn(toolchain->version, "\r\n"), toolchain->version);
+}
+
+int print_toolchain_info(const char *config_path, const char *compiler) {
+    ProjectConfig config;
+    int have_config = 0;
+    if (!compiler && access(config_path, F_OK) == 0) {
+        if (parse_config_from_file(config_path, &config) != 0) return 1;
+        have_config = 1;
+        compiler = config.compiler;
+    }
+    if (!compiler) compiler = "clang";
+
+    const Toolchain *toolchain = toolchain_probe(compiler);
+    if (toolchain) {
+        char version[256];
+        toolchain_version_line(toolchain, version, sizeof(version));
+        printf("Compiler:            %s (%s)\n", compiler, toolchain->path);
+        printf("Family:              %s\n", family_name(toolchain->family));
+        printf("Version:             %s\n", version);
+        printf("Target:              %s\n", toolchain->target[0] ? toolchain->target : "(unknown)");
+        printf("Sysroot:             %s\n", toolchain->sysroot[0] ? toolchain->sysroot : "(host)");
+        printf("-pipe:               %s\n", toolchain->supports_pipe ? "yes" : "no");
+        printf("-ftime-trace:        %s\n", toolchain->supports_time_trace ? "yes" : "no");
+        printf("Precompiled headers: %s\n", toolchain->supports_pch ? "yes" : "no");
+        printf("Fastest linker:      %s\n", toolchain->fast_linker ? toolchain->fast_linker : "(default)");
+    }
+    if (have_config) free_config(&config);
+    return toolchain ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#ifndef TOOLCHAIN_H
+#define TOOLCHAIN_H
+
+#include <limits.h>
+#include <stddef.h>
+
+/**
+ * @brief The compiler families Coda knows how to drive.
+ */
+typedef enum {
+    TOOLCHAIN_UNKNOWN,
+    TOOLCHAIN_CLANG,
+    TOOLCHAIN_GCC
+} ToolchainFamily;
+
+/**
+ * @struct Toolchain
+ * @brief What a compiler is and what it supports, as probed by toolchain_probe().
+ */
+typedef struct {
+    char path[PATH_MAX];          // resolved compiler binary
+    ToolchainFamily family;
+    char *version;                // full `--version` output
+    char target[128];             // `-dumpmachine`, e.g. "x86_64-linux-gnu"; "" if unknown
+    char sysroot[PATH_MAX];       // `-print-sysroot`; "" for the host root
+    int supports_pipe;            // -pipe
+    int supports_time_trace;      // -ftime-trace
+    int supports_pch;             // precompiled headers (-x c-header)
+    const char *fast_linker;      // "-fuse-ld=mold" or "-fuse-ld=lld" if that linker works, or NULL
+} Toolchain;
+
+/**
+ * @brief Probes a compiler once and remembers the result. Results are cached per
+ * user (in $XDG_CACHE_HOME/coda/toolchains, or ~/.cache/coda/toolchains) keyed on
+ * the resolved binary's path, size and modification time, so a compiler is only
+ * probed again after it was replaced or upgraded. Repeated calls in one process
+ * return the same object.
+ * @param compiler The configured compiler, e.g. "clang" or "/opt/gcc-14/bin/gcc".
+ * @return The probed toolchain (owned by the module), or NULL if the compiler
+ * cannot be found or run.
+ */
+const Toolchain *toolchain_probe(const char *compiler);
+
+/**
+ * @brief Returns the first line of the toolchain's `--version` output.
+ * @param toolchain The probed toolchain.
+ * @param out Buffer receiving the line.
+ * @param size Size of the buffer.
+ */
+void toolchain_version_line(const Toolchain *toolchain, char *out, size_t size);
+
+/**
+ * @brief Prints the probed properties of a compiler (`coda toolchain`).
+ * @param config_path The coda.json file whose "compiler" is described.
+ * @param compiler Overrides the configured compiler; NULL to use coda.json (or
+ * clang without one).
+ * @return 0 on success, 1 if it cannot be probed.
+ */
+int print_toolchain_info(const char *config_path, const char *compiler);
+
+#endif // TOOLCHAIN_H
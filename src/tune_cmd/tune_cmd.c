@@ -0,0 +1,414 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <jansson.h>
+
+#include "tune_cmd.h"
+#include "build_engine.h"
+#include "project_mgr.h"
+#include "core_utils.h"
+#include "stats_utils.h"
+#include "process_runner.h"
+
+#define DEFAULT_RUNS 10
+#define DEFAULT_WARMUP 2
+// The benchmark command finds the variant's executable in this environment variable
+#define TUNE_BINARY_ENV "CODA_TUNE_BINARY"
+
+// Tried when coda.json does not list its own variants
+static const char *default_variants[] = {
+    "-O2",
+    "-O3",
+    "-O3 -march=native",
+    "-O2 -flto",
+    "-O2 -fno-plt",
+    NULL
+};
+
+/**
+ * @struct TuneVariant
+ * @brief One candidate flag set, its build location and its measurements.
+ */
+typedef struct {
+    char **flags;            // NULL-terminated, appended to the project's compiler_flags
+    char label[512];
+    char build_dir[2048];
+    char output_path[4096];
+    int built;
+    int benchmark_failed;
+    double *samples;         // wall-clock milliseconds per measured run
+    int sample_count;
+    SampleSummary summary;
+} TuneVariant;
+
+static void free_flags(char **flags) {
+    if (!flags) return;
+    for (int i = 0; flags[i] != NULL; i++) free(flags[i]);
+    free(flags);
+}
+
+// Splits "-O3 -march=native" into a NULL-terminated list of flags
+static char **split_flags(const char *text) {
+    char *copy = strdup(text);
+    char **flags = (char **)calloc(strlen(text) / 2 + 2, sizeof(char *));
+    if (!copy || !flags) {
+        free(copy);
+        free(flags);
+        return NULL;
+    }
+    int count = 0;
+    char *save = NULL;
+    for (char *token = strtok_r(copy, " \t", &save); token; token = strtok_r(NULL, " \t", &save)) {
+        flags[count++] = strdup(token);
+    }
+    free(copy);
+    return flags;
+}
+
+// Reads one entry of "variants": either "-O3 -march=native" or ["-O3", "-march=native"]
+static char **parse_variant_flags(json_t *entry) {
+    if (json_is_string(entry)) {
+        return split_flags(json_string_value(entry));
+    }
+    if (!json_is_array(entry)) return NULL;
+    char **flags = (char **)calloc(json_array_size(entry) + 1, sizeof(char *));
+    if (!flags) return NULL;
+    for (size_t i = 0; i < json_array_size(entry); i++) {
+        const char *flag = json_string_value(json_array_get(entry, i));
+        if (!flag) {
+            free_flags(flags);
+            return NULL;
+        }
+        flags[i] = strdup(flag);
+    }
+    return flags;
+}
+
+// Fills in the label and the per-variant build directory and output path
+static void describe_variant(TuneVariant *variant, int index, const ProjectConfig *config) {
+    variant->label[0] = '\0';
+    for (int i = 0; variant->flags[i] != NULL; i++) {
+        size_t used = strlen(variant->label);
+        snprintf(variant->label + used, sizeof(variant->label) - used, "%s%s", i ? " " : "", variant->flags[i]);
+    }
+    if (variant->label[0] == '\0') snprintf(variant->label, sizeof(variant->label), "(baseline)");
+
+    const char *slash = strrchr(config->output_path, '/');
+    const char *output_name = slash ? slash + 1 : config->output_path;
+    snprintf(variant->build_dir, sizeof(variant->build_dir), "%s/tune/%d", config->build_dir, index);
+    snprintf(variant->output_path, sizeof(variant->output_path), "%s/%s", variant->build_dir, output_name);
+}
+
+/**
+ * @brief Reads the "tune" section of coda.json. The project's own flags always
+ * come first as the baseline; every variant adds its flags on top of them.
+ * @return 0 on success, 1 on failure.
+ */
+static int load_tune_settings(const char *config_path, const ProjectConfig *config, char **benchmark,
+                              int *runs, int *warmup, TuneVariant **variants, int *variant_count) {
+    json_error_t error;
+    json_t *root = json_load_file(config_path, 0, &error);
+    if (!root) {
+        fprintf(stderr, "Error parsing JSON file '%s': on line %d: %s\n", config_path, error.line, error.text);
+        return 1;
+    }
+    json_t *tune = json_object_get(root, "tune");
+    json_t *benchmark_json = json_object_get(tune, "benchmark");
+    json_t *variants_json = json_object_get(tune, "variants");
+    *benchmark = json_is_string(benchmark_json) ? strdup(json_string_value(benchmark_json)) : NULL;
+    if (json_is_integer(json_object_get(tune, "runs"))) *runs = (int)json_integer_value(json_object_get(tune, "runs"));
+    if (json_is_integer(json_object_get(tune, "warmup"))) *warmup = (int)json_integer_value(json_object_get(tune, "warmup"));
+
+    int listed = 0;
+    if (json_is_array(variants_json)) {
+        listed = (int)json_array_size(variants_json);
+    } else {
+        while (default_variants[listed]) listed++;
+    }
+
+    TuneVariant *list = (TuneVariant *)calloc((size_t)listed + 1, sizeof(TuneVariant));
+    if (!list) {
+        json_decref(root);
+        return 1;
+    }
+    int failed = 0;
+    list[0].flags = (char **)calloc(1, sizeof(char *));
+    failed = list[0].flags == NULL;
+    for (int i = 0; i < listed && !failed; i++) {
+        list[i + 1].flags = json_is_array(variants_json) ? parse_variant_flags(json_array_get(variants_json, (size_t)i))
+                                                         : split_flags(default_variants[i]);
+        if (!list[i + 1].flags) {
+            fprintf(stderr, "Error: Entry %d of 'tune.variants' must be a string or an array of strings.\n", i);
+            failed = 1;
+        }
+    }
+    json_decref(root);
+
+    *variants = list;
+    *variant_count = listed + 1;
+    for (int i = 0; i < *variant_count && !failed; i++) describe_variant(&list[i], i, config);
+    return failed;
+}
+
+// Builds one variant in a child process, logging to <variant build dir>/build.log
+static pid_t start_variant_build(const char *config_path, const TuneVariant *variant) {
+    char log_path[4096 + 16];
+    snprintf(log_path, sizeof(log_path), "%s/build.log", variant->build_dir);
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("Failed to fork build process");
+        return -1;
+    }
+    if (pid == 0) {
+        int fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        BuildOptions options = { 0 };
+        options.output_path = variant->output_path;
+        options.build_dir = variant->build_dir;
+        options.extra_compiler_flags = (const char **)variant->flags;
+        int rc = build_project_with_options(config_path, &options);
+        fflush(NULL);
+        _exit(rc == 0 ? 0 : 1);
+    }
+    return pid;
+}
+
+/**
+ * @brief Builds all variants, running at most one build per online CPU at a time.
+ * @return The number of variants that built successfully.
+ */
+static int build_variants(const char *config_path, TuneVariant *variants, int variant_count) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_parallel = cpus > 0 ? (int)cpus : 1;
+    int *variant_of_job = (int *)calloc((size_t)variant_count, sizeof(int));
+    if (!variant_of_job) return 0;
+
+    ProcessRunner runner;
+    process_runner_init(&runner);
+    int next = 0, running = 0, built = 0;
+    while (next < variant_count || running > 0) {
+        while (next < variant_count && running < max_parallel) {
+            pid_t pid = ensure_directory(variants[next].build_dir) == 0 ? start_variant_build(config_path, &variants[next]) : -1;
+            int job = pid > 0 ? process_runner_adopt(&runner, pid, 0) : -1;
+            if (job >= 0) {
+                variant_of_job[job] = next;
+                running++;
+            } else {
+                fprintf(stderr, "[ERROR] Could not start the build of variant '%s'.\n", variants[next].label);
+            }
+            next++;
+        }
+        if (running == 0) break;
+
+        int job = process_runner_wait_any(&runner);
+        if (job < 0) break;
+        running--;
+        int i = variant_of_job[job];
+        variants[i].built = process_job_succeeded(&runner.jobs[job]);
+        if (variants[i].built) {
+            built++;
+            printf("[LOG] Built variant '%s'.\n", variants[i].label);
+        } else {
+            fprintf(stderr, "[WARN] Variant '%s' failed to build; see %s/build.log.\n",
+                    variants[i].label, variants[i].build_dir);
+        }
+    }
+    process_runner_free(&runner);
+    free(variant_of_job);
+    return built;
+}
+
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) * 1000.0 + (double)(end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/**
+ * @brief Runs the benchmark once against a variant's executable. Without a
+ * benchmark command the executable itself is run.
+ * @return 0 if it exited with status 0, 1 otherwise.
+ */
+static int run_benchmark_once(const char *benchmark, const char *binary, double *milliseconds) {
+    char binary_env[4096 + 32];
+    snprintf(binary_env, sizeof(binary_env), "%s=%s", TUNE_BINARY_ENV, binary);
+    const char *extra_env[] = { binary_env, NULL };
+    char *shell_argv[] = { "/bin/sh", "-c", (char *)benchmark, NULL };
+    char *binary_argv[] = { (char *)binary, NULL };
+
+    ProcessSpec spec = { 0 };
+    spec.argv = benchmark ? shell_argv : binary_argv;
+    spec.stdout_path = "/dev/null";
+    spec.extra_env = extra_env;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int rc = process_run(&spec, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *milliseconds = elapsed_ms(&start, &end);
+    return rc;
+}
+
+/**
+ * @brief Runs the benchmark round-robin across all built variants, so slow
+ * drift on the machine (thermal throttling, background load) affects every
+ * variant alike instead of penalizing whichever runs last.
+ */
+static void measure_variants(const char *benchmark, TuneVariant *variants, int variant_count, int runs, int warmup) {
+    for (int i = 0; i < variant_count; i++) {
+        variants[i].samples = (double *)calloc((size_t)runs, sizeof(double));
+        if (!variants[i].samples) variants[i].benchmark_failed = 1;
+    }
+    for (int round = -warmup; round < runs; round++) {
+        printf("[LOG] %s round %d/%d...\n", round < 0 ? "Warmup" : "Benchmark",
+               round < 0 ? round + warmup + 1 : round + 1, round < 0 ? warmup : runs);
+        for (int i = 0; i < variant_count; i++) {
+            TuneVariant *variant = &variants[i];
+            if (!variant->built || variant->benchmark_failed) continue;
+            double milliseconds = 0.0;
+            if (run_benchmark_once(benchmark, variant->output_path, &milliseconds) != 0) {
+                fprintf(stderr, "[WARN] The benchmark failed for variant '%s'; dropping it.\n", variant->label);
+                variant->benchmark_failed = 1;
+                continue;
+            }
+            if (round >= 0) variant->samples[variant->sample_count++] = milliseconds;
+        }
+    }
+    for (int i = 0; i < variant_count; i++) {
+        if (variants[i].built && !variants[i].benchmark_failed) {
+            summarize_samples(variants[i].samples, variants[i].sample_count, &variants[i].summary);
+        }
+    }
+}
+
+static int is_measured(const TuneVariant *variant) {
+    return variant->built && !variant->benchmark_failed && variant->sample_count > 0;
+}
+
+// Prints the results fastest first and returns the index of the fastest variant, or -1.
+static int report_results(TuneVariant *variants, int variant_count) {
+    int *order = (int *)malloc(sizeof(int) * (size_t)variant_count);
+    if (!order) return -1;
+    int measured = 0;
+    for (int i = 0; i < variant_count; i++) {
+        if (is_measured(&variants[i])) order[measured++] = i;
+    }
+    // Insertion sort by mean; there are only a handful of variants
+    for (int i = 1; i < measured; i++) {
+        int current = order[i], j = i - 1;
+        while (j >= 0 && variants[order[j]].summary.mean > variants[current].summary.mean) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = current;
+    }
+    if (measured == 0) {
+        free(order);
+        return -1;
+    }
+
+    const TuneVariant *baseline = is_measured(&variants[0]) ? &variants[0] : NULL;
+    printf("\n%-32s %12s %12s %10s %12s\n", "Variant", "Mean (ms)", "95% CI", "Stddev", "vs baseline");
+    for (int k = 0; k < measured; k++) {
+        const TuneVariant *variant = &variants[order[k]];
+        char relative[32] = "-";
+        if (baseline && variant != baseline && baseline->summary.mean > 0.0) {
+            WelchResult test;
+            welch_t_test(&variant->summary, &baseline->summary, &test);
+            snprintf(relative, sizeof(relative), "%+.1f%%%s",
+                     (variant->summary.mean / baseline->summary.mean - 1.0) * 100.0, test.significant ? "" : " (ns)");
+        }
+        char interval[32];
+        snprintf(interval, sizeof(interval), "+/-%.3f", variant->summary.ci95_half_width);
+        printf("%-32s %12.3f %12s %10.3f %12s\n", variant->label, variant->summary.mean, interval,
+               variant->summary.stddev, relative);
+    }
+    printf("(ns) = not significantly different from the baseline (Welch's t-test, 95%%).\n\n");
+
+    int best = order[0];
+    if (measured > 1) {
+        WelchResult test;
+        welch_t_test(&variants[best].summary, &variants[order[1]].summary, &test);
+        if (test.significant) {
+            printf("Best flag set: %s (significantly faster than the runner-up '%s').\n",
+                   variants[best].label, variants[order[1]].label);
+        } else {
+            printf("Best flag set: %s, but it is statistically indistinguishable from '%s'; consider more runs.\n",
+                   variants[best].label, variants[order[1]].label);
+        }
+    } else {
+        printf("Best flag set: %s (the only variant measured).\n", variants[best].label);
+    }
+    free(order);
+    return best;
+}
+
+int tune_project(const char *config_path, const TuneOptions *options) {
+    ProjectConfig config;
+    if (parse_config_from_file(config_path, &config) != 0) {
+        fprintf(stderr, "[ERROR] Failed to parse configuration from %s.\n", config_path);
+        return 1;
+    }
+
+    char *benchmark = NULL;
+    int runs = DEFAULT_RUNS, warmup = DEFAULT_WARMUP;
+    TuneVariant *variants = NULL;
+    int variant_count = 0;
+    if (load_tune_settings(config_path, &config, &benchmark, &runs, &warmup, &variants, &variant_count) != 0) {
+        free(benchmark);
+        for (int i = 0; variants && i < variant_count; i++) free_flags(variants[i].flags);
+        free(variants);
+        free_config(&config);
+        return 1;
+    }
+    if (options->runs > 0) runs = options->runs;
+    if (options->warmup >= 0) warmup = options->warmup;
+    if (runs < 2) runs = 2; // a confidence interval needs at least two samples
+    if (warmup < 0) warmup = 0;
+
+    printf("Tuning %s: %d variant(s), %d warmup + %d measured run(s) each.\n", config.project_name,
+           variant_count, warmup, runs);
+    printf("Benchmark: %s\n", benchmark ? benchmark : "(the executable itself)");
+
+    int rc = 1;
+    if (build_variants(config_path, variants, variant_count) == 0) {
+        fprintf(stderr, "[ERROR] No variant could be built.\n");
+    } else {
+        measure_variants(benchmark, variants, variant_count, runs, warmup);
+        int best = report_results(variants, variant_count);
+        if (best < 0) {
+            fprintf(stderr, "[ERROR] The benchmark did not succeed for any variant.\n");
+        } else if (options->write_profile) {
+            if (best != 0 && is_measured(&variants[0])) {
+                WelchResult test;
+                welch_t_test(&variants[best].summary, &variants[0].summary, &test);
+                if (!test.significant) {
+                    fprintf(stderr, "[WARN] '%s' is not significantly faster than the baseline.\n", variants[best].label);
+                }
+            }
+            rc = save_config_profile(config_path, options->write_profile, (const char *const *)variants[best].flags);
+            if (rc == 0) {
+                printf("Saved as profile '%s'. Build with: coda build --profile %s\n",
+                       options->write_profile, options->write_profile);
+            }
+        } else {
+            rc = 0;
+        }
+    }
+
+    for (int i = 0; i < variant_count; i++) {
+        free_flags(variants[i].flags);
+        free(variants[i].samples);
+    }
+    free(variants);
+    free(benchmark);
+    free_config(&config);
+    return rc;
+}
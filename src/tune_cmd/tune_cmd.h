@@ -0,0 +1,26 @@
+#ifndef TUNE_CMD_H
+#define TUNE_CMD_H
+
+/**
+ * @struct TuneOptions
+ * @brief Command-line switches for `coda tune`. Zero values (-1 for warmup,
+ * where 0 is meaningful) fall back to the "tune" section of coda.json, then
+ * to the built-in defaults.
+ */
+typedef struct {
+    int runs;                  // measured runs per variant
+    int warmup;                // unmeasured runs per variant before measuring; -1 when not given
+    const char *write_profile; // when set, the winning flags are saved under "profiles" with this name
+} TuneOptions;
+
+/**
+ * @brief Builds every compiler-flag variant from the "tune" section of coda.json
+ * in parallel, runs the benchmark command against each one and reports the
+ * fastest flag set with 95% confidence intervals.
+ * @param config_path The path to the coda.json file.
+ * @param options The tuning options.
+ * @return 0 on success, 1 on failure.
+ */
+int tune_project(const char *config_path, const TuneOptions *options);
+
+#endif // TUNE_CMD_H
@@ -0,0 +1,745 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "unity_analyzer.h"
+#include "core_utils.h"
+
+#define MAX_IDENTIFIER_LEN 128
+
+/**
+ * @brief The kinds of file-local definitions that clash once files are concatenated.
+ */
+typedef enum {
+    SYMBOL_STATIC,
+    SYMBOL_TYPEDEF,
+    SYMBOL_TAG,
+    SYMBOL_ENUMERATOR,
+    SYMBOL_MACRO,
+    SYMBOL_FUNCTION_DEFINITION, // any function body, static or not; used for indexing, never a collision
+    SYMBOL_MEMBER               // a struct/union member name; only kept to decide whether a rename is safe
+} SymbolKind;
+
+static const char *symbol_kind_names[] = {
+    "static symbol", "typedef", "struct/union/enum tag", "enumerator", "macro", "function", "member"
+};
+
+/**
+ * @struct LocalSymbol
+ * @brief One file-local definition found by the scanner.
+ */
+typedef struct {
+    char name[MAX_IDENTIFIER_LEN];
+    SymbolKind kind;
+    int file_index;
+    char *macro_body; // normalized replacement list for macros, NULL otherwise
+} LocalSymbol;
+
+typedef struct {
+    LocalSymbol *items;
+    size_t count;
+    size_t capacity;
+} SymbolTable;
+
+/**
+ * @struct Scanner
+ * @brief A lightweight C tokenizer over one source file. It only understands
+ * comments, literals, preprocessor lines, identifiers and punctuation, which is
+ * enough to find file-scope declarations without a real parser.
+ */
+typedef struct {
+    const char *pos;
+    int at_line_start;
+} Scanner;
+
+typedef enum { TOKEN_END, TOKEN_IDENT, TOKEN_PUNCT, TOKEN_LITERAL, TOKEN_DIRECTIVE } TokenType;
+
+typedef struct {
+    TokenType type;
+    char text[MAX_IDENTIFIER_LEN];
+    const char *directive;   // start of the directive text (after '#') for TOKEN_DIRECTIVE
+    size_t directive_len;
+} Token;
+
+// Words that can precede a declarator but are never the declared name.
+static const char *reserved_words[] = {
+    "auto", "break", "case", "char", "const", "continue", "default", "do", "double", "else",
+    "enum", "extern", "float", "for", "goto", "if", "inline", "int", "long", "register",
+    "restrict", "return", "short", "signed", "sizeof", "static", "struct", "switch", "typedef",
+    "union", "unsigned", "void", "volatile", "while", "_Bool", "_Complex", "_Noreturn",
+    "_Thread_local", "_Atomic", "_Alignas", "__inline", "__inline__", "__restrict",
+    "__restrict__", "__extension__", "__attribute__", "__declspec", "__asm__", "asm",
+    "__typeof__", "typeof", "_Static_assert", "static_assert", NULL
+};
+
+// Reserved words followed by a parenthesized argument that is not a parameter list.
+static const char *parenthesized_words[] = {
+    "__attribute__", "__declspec", "__asm__", "asm", "_Alignas", "__typeof__", "typeof",
+    "_Static_assert", "static_assert", "sizeof", NULL
+};
+
+static int word_in_list(const char *word, const char **list) {
+    for (int i = 0; list[i] != NULL; i++) {
+        if (strcmp(word, list[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static void add_symbol(SymbolTable *table, const char *name, SymbolKind kind, int file_index, const char *macro_body) {
+    if (name[0] == '\0') return;
+
+    // A file may declare the same name more than once (prototype + definition)
+    for (size_t i = table->count; i > 0; i--) {
+        LocalSymbol *existing = &table->items[i - 1];
+        if (existing->file_index != file_index) break;
+        if (existing->kind == kind && strcmp(existing->name, name) == 0) {
+            if (kind == SYMBOL_MACRO) {
+                free(existing->macro_body);
+                existing->macro_body = strdup(macro_body ? macro_body : "");
+            }
+            return;
+        }
+    }
+
+    if (table->count == table->capacity) {
+        size_t new_capacity = table->capacity ? table->capacity * 2 : 64;
+        LocalSymbol *grown = (LocalSymbol *)realloc(table->items, new_capacity * sizeof(LocalSymbol));
+        if (!grown) return;
+        table->items = grown;
+        table->capacity = new_capacity;
+    }
+    LocalSymbol *symbol = &table->items[table->count++];
+    snprintf(symbol->name, sizeof(symbol->name), "%s", name);
+    symbol->kind = kind;
+    symbol->file_index = file_index;
+    symbol->macro_body = (kind == SYMBOL_MACRO) ? strdup(macro_body ? macro_body : "") : NULL;
+}
+
+// A file that #undefs its own macro no longer leaks it into later files.
+static void remove_macro(SymbolTable *table, const char *name, int file_index) {
+    for (size_t i = table->count; i > 0; i--) {
+        LocalSymbol *existing = &table->items[i - 1];
+        if (existing->file_index != file_index) break;
+        if (existing->kind == SYMBOL_MACRO && strcmp(existing->name, name) == 0) {
+            free(existing->macro_body);
+            memmove(existing, existing + 1, (table->count - i) * sizeof(LocalSymbol));
+            table->count--;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Reads the next token, skipping whitespace, comments and literal contents.
+ */
+static Token next_token(Scanner *scanner) {
+    Token token;
+    memset(&token, 0, sizeof(token));
+    const char *p = scanner->pos;
+
+    while (*p) {
+        if (*p == '\n') {
+            scanner->at_line_start = 1;
+            p++;
+        } else if (isspace((unsigned char)*p) || (*p == '\\' && p[1] == '\n')) {
+            p += (*p == '\\') ? 2 : 1;
+        } else if (p[0] == '/' && p[1] == '/') {
+            while (*p && *p != '\n') p++;
+        } else if (p[0] == '/' && p[1] == '*') {
+            p += 2;
+            while (*p && !(p[0] == '*' && p[1] == '/')) p++;
+            if (*p) p += 2;
+        } else {
+            break;
+        }
+    }
+
+    if (*p == '\0') {
+        token.type = TOKEN_END;
+    } else if (*p == '#' && scanner->at_line_start) {
+        // Preprocessor directive: capture up to the end of the logical line
+        p++;
+        token.type = TOKEN_DIRECTIVE;
+        token.directive = p;
+        while (*p && *p != '\n') {
+            if (p[0] == '\\' && p[1] == '\n') p++;
+            else if (p[0] == '/' && p[1] == '*') {
+                // Block comments may span lines inside a directive
+                p += 2;
+                while (*p && !(p[0] == '*' && p[1] == '/')) p++;
+                if (*p) p++;
+            }
+            if (*p) p++;
+        }
+        token.directive_len = (size_t)(p - token.directive);
+    } else if (isalpha((unsigned char)*p) || *p == '_') {
+        size_t len = 0;
+        token.type = TOKEN_IDENT;
+        while (isalnum((unsigned char)*p) || *p == '_') {
+            if (len + 1 < sizeof(token.text)) token.text[len++] = *p;
+            p++;
+        }
+        token.text[len] = '\0';
+    } else if (*p == '"' || *p == '\'') {
+        char quote = *p++;
+        token.type = TOKEN_LITERAL;
+        while (*p && *p != quote && *p != '\n') {
+            if (*p == '\\' && p[1]) p++;
+            p++;
+        }
+        if (*p == quote) p++;
+    } else if (isdigit((unsigned char)*p)) {
+        token.type = TOKEN_LITERAL;
+        while (isalnum((unsigned char)*p) || *p == '.' || *p == '_') p++;
+    } else {
+        token.type = TOKEN_PUNCT;
+        token.text[0] = *p++;
+    }
+
+    if (token.type != TOKEN_END) scanner->at_line_start = (token.type == TOKEN_DIRECTIVE);
+    scanner->pos = p;
+    return token;
+}
+
+/**
+ * @brief Records #define and #undef directives. The macro body is normalized
+ * (whitespace runs collapsed) so that identical redefinitions do not count as
+ * collisions, matching the C rules for benign redefinition.
+ */
+static void scan_directive(SymbolTable *table, const Token *token, int file_index) {
+    char *text = (char *)malloc(token->directive_len + 1);
+    if (!text) return;
+    memcpy(text, token->directive, token->directive_len);
+    text[token->directive_len] = '\0';
+
+    char *p = text;
+    while (isspace((unsigned char)*p)) p++;
+    int is_define = strncmp(p, "define", 6) == 0 && isspace((unsigned char)p[6]);
+    int is_undef = strncmp(p, "undef", 5) == 0 && isspace((unsigned char)p[5]);
+    if (!is_define && !is_undef) {
+        free(text);
+        return;
+    }
+    p += is_define ? 6 : 5;
+    while (isspace((unsigned char)*p)) p++;
+
+    char name[MAX_IDENTIFIER_LEN];
+    size_t len = 0;
+    while ((isalnum((unsigned char)*p) || *p == '_') && len + 1 < sizeof(name)) name[len++] = *p++;
+    name[len] = '\0';
+
+    if (is_undef) {
+        remove_macro(table, name, file_index);
+        free(text);
+        return;
+    }
+
+    // Normalize the remainder (parameter list + replacement list)
+    char *body = (char *)malloc(strlen(p) + 1);
+    if (body) {
+        size_t out = 0;
+        int pending_space = 0;
+        for (; *p; p++) {
+            if (*p == '\\' && p[1] == '\n') continue;
+            if (isspace((unsigned char)*p)) {
+                pending_space = out > 0;
+                continue;
+            }
+            if (pending_space) body[out++] = ' ';
+            pending_space = 0;
+            body[out++] = *p;
+        }
+        body[out] = '\0';
+        add_symbol(table, name, SYMBOL_MACRO, file_index, body);
+        free(body);
+    }
+    free(text);
+}
+
+/**
+ * @brief Skips a balanced {...} block whose opening brace was just consumed.
+ * When collect_enumerators is set, identifiers that start an enumerator
+ * (after '{' or ',') are recorded as file-scope names.
+ */
+static void skip_braces(Scanner *scanner, SymbolTable *table, int file_index, int collect_enumerators) {
+    int depth = 1;
+    int expect_enumerator = collect_enumerators;
+    while (depth > 0) {
+        Token token = next_token(scanner);
+        if (token.type == TOKEN_END) return;
+        if (token.type == TOKEN_DIRECTIVE) {
+            scan_directive(table, &token, file_index);
+            continue;
+        }
+        if (token.type == TOKEN_PUNCT && token.text[0] == '{') depth++;
+        else if (token.type == TOKEN_PUNCT && token.text[0] == '}') depth--;
+        else if (collect_enumerators && depth == 1) {
+            if (token.type == TOKEN_IDENT && expect_enumerator) {
+                add_symbol(table, token.text, SYMBOL_ENUMERATOR, file_index, NULL);
+                expect_enumerator = 0;
+            } else if (token.type == TOKEN_PUNCT && token.text[0] == ',') {
+                expect_enumerator = 1;
+            }
+        }
+    }
+}
+
+// Skips a balanced (...) group whose opening parenthesis was just consumed.
+// Returns the first non-reserved identifier inside it (for function-pointer declarators).
+static void skip_parens(Scanner *scanner, char *first_ident, size_t first_ident_size) {
+    int depth = 1;
+    if (first_ident) first_ident[0] = '\0';
+    while (depth > 0) {
+        Token token = next_token(scanner);
+        if (token.type == TOKEN_END) return;
+        if (token.type == TOKEN_PUNCT && token.text[0] == '(') depth++;
+        else if (token.type == TOKEN_PUNCT && token.text[0] == ')') depth--;
+        else if (token.type == TOKEN_IDENT && first_ident && first_ident[0] == '\0' &&
+                 !word_in_list(token.text, reserved_words)) {
+            snprintf(first_ident, first_ident_size, "%s", token.text);
+        }
+    }
+}
+
+/**
+ * @brief Walks one file's file-scope declarations and records its local definitions.
+ * Only static, typedef, tag and enumerator names are recorded: non-static
+ * functions and globals are meant to be shared between files in Coda projects.
+ */
+static void scan_file(const char *content, SymbolTable *table, int file_index) {
+    Scanner scanner = { content, 1 };
+    int is_static = 0, is_typedef = 0;
+    int named = 0;             // the current declarator already has a name
+    int is_function = 0;       // the current declarator has a parameter list
+    int expect_tag = 0;        // the previous token was struct/union/enum
+    int tag_is_enum = 0;
+    char pending_tag[MAX_IDENTIFIER_LEN] = "";
+    char last_ident[MAX_IDENTIFIER_LEN] = "";
+    char prev_word[MAX_IDENTIFIER_LEN] = "";
+
+    for (;;) {
+        Token token = next_token(&scanner);
+        if (token.type == TOKEN_END) break;
+
+        if (token.type == TOKEN_DIRECTIVE) {
+            scan_directive(table, &token, file_index);
+            continue;
+        }
+
+        if (token.type == TOKEN_IDENT) {
+            if (expect_tag) {
+                snprintf(pending_tag, sizeof(pending_tag), "%s", token.text);
+                expect_tag = 0;
+            } else if (strcmp(token.text, "static") == 0) {
+                is_static = 1;
+            } else if (strcmp(token.text, "typedef") == 0) {
+                is_typedef = 1;
+            } else if (strcmp(token.text, "struct") == 0 || strcmp(token.text, "union") == 0 ||
+                       strcmp(token.text, "enum") == 0) {
+                expect_tag = 1;
+                tag_is_enum = strcmp(token.text, "enum") == 0;
+                pending_tag[0] = '\0';
+            } else if (!word_in_list(token.text, reserved_words)) {
+                snprintf(last_ident, sizeof(last_ident), "%s", token.text);
+            }
+            snprintf(prev_word, sizeof(prev_word), "%s", token.text);
+            continue;
+        }
+
+        if (token.type != TOKEN_PUNCT) {
+            prev_word[0] = '\0';
+            continue;
+        }
+
+        char c = token.text[0];
+        int after_reserved_paren_word = word_in_list(prev_word, parenthesized_words);
+        prev_word[0] = '\0';
+        expect_tag = 0;
+
+        if (c == '{') {
+            if (is_function) {
+                // Function body: the declaration ends here
+                add_symbol(table, last_ident, SYMBOL_FUNCTION_DEFINITION, file_index, NULL);
+                skip_braces(&scanner, table, file_index, 0);
+                is_static = is_typedef = named = is_function = 0;
+                last_ident[0] = pending_tag[0] = '\0';
+            } else if (named) {
+                // Brace initializer
+                skip_braces(&scanner, table, file_index, 0);
+            } else {
+                // struct/union/enum body; a declarator may still follow
+                if (pending_tag[0] != '\0') {
+                    add_symbol(table, pending_tag, SYMBOL_TAG, file_index, NULL);
+                }
+                skip_braces(&scanner, table, file_index, tag_is_enum);
+                pending_tag[0] = '\0';
+                last_ident[0] = '\0';
+            }
+        } else if (c == '(') {
+            char inner[MAX_IDENTIFIER_LEN];
+            skip_parens(&scanner, inner, sizeof(inner));
+            if (after_reserved_paren_word || named) {
+                continue;
+            }
+            if (last_ident[0] != '\0') {
+                is_function = 1;
+            } else {
+                // Function-pointer declarator such as "static int (*handler)(int)"
+                snprintf(last_ident, sizeof(last_ident), "%s", inner);
+            }
+            if (is_static || is_typedef) {
+                add_symbol(table, last_ident, is_typedef ? SYMBOL_TYPEDEF : SYMBOL_STATIC, file_index, NULL);
+            }
+            named = 1;
+        } else if (c == '=' || c == '[' || c == ',' || c == ';') {
+            if (!named && last_ident[0] != '\0' && (is_static || is_typedef)) {
+                add_symbol(table, last_ident, is_typedef ? SYMBOL_TYPEDEF : SYMBOL_STATIC, file_index, NULL);
+            }
+            named = (c == '=' || c == '[');
+            if (c == '=') {
+                // Skip the initializer up to the next declarator or the end of the declaration
+                for (;;) {
+                    Token init = next_token(&scanner);
+                    if (init.type == TOKEN_END) return;
+                    if (init.type == TOKEN_PUNCT && init.text[0] == '{') skip_braces(&scanner, table, file_index, 0);
+                    else if (init.type == TOKEN_PUNCT && init.text[0] == '(') skip_parens(&scanner, NULL, 0);
+                    else if (init.type == TOKEN_PUNCT && (init.text[0] == ',' || init.text[0] == ';')) {
+                        c = init.text[0];
+                        break;
+                    }
+                }
+            }
+            if (c == ',') {
+                named = is_function = 0;
+                last_ident[0] = '\0';
+            } else if (c == ';') {
+                is_static = is_typedef = named = is_function = 0;
+                last_ident[0] = pending_tag[0] = '\0';
+            }
+        } else if (c == '}') {
+            // Stray closing brace (e.g. from an `extern "C"` wrapper in shared code); reset state
+            is_static = is_typedef = named = is_function = 0;
+            last_ident[0] = pending_tag[0] = '\0';
+        }
+    }
+}
+
+/**
+ * @brief Records the member declarators of a struct/union body whose opening
+ * brace was just consumed, including those of nested bodies.
+ */
+static void scan_member_declarations(Scanner *scanner, SymbolTable *members, int file_index) {
+    int named = 0;     // the current member declarator already has a name
+    int expect_tag = 0;
+    int body_is_enum = 0;
+    char last_ident[MAX_IDENTIFIER_LEN] = "";
+    char prev_word[MAX_IDENTIFIER_LEN] = "";
+    for (;;) {
+        Token token = next_token(scanner);
+        if (token.type == TOKEN_END) return;
+        if (token.type == TOKEN_IDENT) {
+            if (strcmp(token.text, "struct") == 0 || strcmp(token.text, "union") == 0 ||
+                strcmp(token.text, "enum") == 0) {
+                body_is_enum = strcmp(token.text, "enum") == 0;
+                expect_tag = 1;
+            } else if (expect_tag) {
+                expect_tag = 0; // the tag names a type, not a member
+            } else if (!named && !word_in_list(token.text, reserved_words)) {
+                snprintf(last_ident, sizeof(last_ident), "%s", token.text);
+            }
+            snprintf(prev_word, sizeof(prev_word), "%s", token.text);
+            continue;
+        }
+        if (token.type != TOKEN_PUNCT) continue;
+
+        char c = token.text[0];
+        int after_reserved_paren_word = word_in_list(prev_word, parenthesized_words);
+        prev_word[0] = '\0';
+        expect_tag = 0;
+        if (c == '}') {
+            return;
+        } else if (c == '{') {
+            // A nested body; its declarator (if any) follows the closing brace
+            if (body_is_enum) skip_braces(scanner, members, file_index, 0);
+            else scan_member_declarations(scanner, members, file_index);
+            body_is_enum = 0;
+            last_ident[0] = '\0';
+        } else if (c == '(') {
+            char inner[MAX_IDENTIFIER_LEN];
+            skip_parens(scanner, inner, sizeof(inner));
+            if (after_reserved_paren_word || named) continue;
+            // Function-pointer member such as "int (*handler)(int)"
+            add_symbol(members, inner, SYMBOL_MEMBER, file_index, NULL);
+            named = 1;
+        } else if (c == ';' || c == ',' || c == ':' || c == '[') {
+            if (!named) add_symbol(members, last_ident, SYMBOL_MEMBER, file_index, NULL);
+            named = (c == ':' || c == '[');
+            last_ident[0] = '\0';
+        }
+    }
+}
+
+/**
+ * @brief Records every name a file uses as a struct/union member: the names
+ * declared in struct/union bodies and those accessed with `.` or `->`
+ * (designated initializers included), also inside macro definitions. A rename
+ * is a token-level #define, so it would rewrite these uses as well.
+ */
+static void scan_member_names(const char *content, SymbolTable *members, int file_index) {
+    Scanner scanner = { content, 1 };
+    int after_access = 0; // the previous token was '.' or "->"
+    int expect_body = 0;  // 1 after struct/union, 2 once its tag was read
+    char previous = '\0';
+    for (;;) {
+        Token token = next_token(&scanner);
+        if (token.type == TOKEN_END) break;
+        if (token.type == TOKEN_DIRECTIVE) {
+            char *text = (char *)malloc(token.directive_len + 1);
+            if (!text) continue;
+            memcpy(text, token.directive, token.directive_len);
+            text[token.directive_len] = '\0';
+            scan_member_names(text, members, file_index);
+            free(text);
+            continue;
+        }
+        if (token.type == TOKEN_IDENT) {
+            if (after_access) add_symbol(members, token.text, SYMBOL_MEMBER, file_index, NULL);
+            if (strcmp(token.text, "struct") == 0 || strcmp(token.text, "union") == 0) expect_body = 1;
+            else expect_body = expect_body == 1 ? 2 : 0;
+            after_access = 0;
+            previous = '\0';
+            continue;
+        }
+        char c = token.type == TOKEN_PUNCT ? token.text[0] : '\0';
+        if (c == '{' && expect_body) scan_member_declarations(&scanner, members, file_index);
+        after_access = c == '.' || (c == '>' && previous == '-');
+        expect_body = 0;
+        previous = c;
+    }
+}
+
+// Returns 1 if any of the first `file_count` files uses `name` as a member
+static int is_member_name(const SymbolTable *members, const char *name, int file_count) {
+    for (size_t i = 0; i < members->count; i++) {
+        const LocalSymbol *member = &members->items[i];
+        if (member->kind == SYMBOL_MEMBER && member->file_index < file_count && strcmp(member->name, name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int compare_symbols(const void *a, const void *b) {
+    const LocalSymbol *left = (const LocalSymbol *)a;
+    const LocalSymbol *right = (const LocalSymbol *)b;
+    int by_name = strcmp(left->name, right->name);
+    if (by_name != 0) return by_name;
+    return left->file_index - right->file_index;
+}
+
+/**
+ * @brief Decides whether two definitions of the same name in different files clash.
+ * Identical macro redefinitions are allowed by the C standard, everything else
+ * is a redefinition error (or a silent macro rewrite) inside one translation unit.
+ */
+static int symbols_collide(const LocalSymbol *a, const LocalSymbol *b) {
+    if (a->kind == SYMBOL_FUNCTION_DEFINITION || b->kind == SYMBOL_FUNCTION_DEFINITION) {
+        return 0;
+    }
+    if (a->kind == SYMBOL_MACRO && b->kind == SYMBOL_MACRO) {
+        return strcmp(a->macro_body, b->macro_body) != 0;
+    }
+    // Tags live in their own namespace; they only clash with other tags.
+    if ((a->kind == SYMBOL_TAG) != (b->kind == SYMBOL_TAG)) {
+        return 0;
+    }
+    return 1;
+}
+
+static void free_symbol_table(SymbolTable *table) {
+    for (size_t i = 0; i < table->count; i++) free(table->items[i].macro_body);
+    free(table->items);
+    table->items = NULL;
+    table->count = table->capacity = 0;
+}
+
+// Scans every source file into one table, and their member names into `members`
+// unless it is NULL. Returns 0 on success, 1 if a file could not be read.
+static int scan_all_files(const char **src_files, int file_count, SymbolTable *table, SymbolTable *members) {
+    for (int i = 0; i < file_count; i++) {
+        char *content = read_file_to_string(src_files[i]);
+        if (!content) {
+            fprintf(stderr, "[ERROR] Failed to read file: %s\n", src_files[i]);
+            free_symbol_table(table);
+            if (members) free_symbol_table(members);
+            return 1;
+        }
+        scan_file(content, table, i);
+        if (members) scan_member_names(content, members, i);
+        free(content);
+    }
+    return 0;
+}
+
+// Records that `file_index` must rename (or, for its own macro, hide) `name`. Returns 0 on success.
+static int add_rename(UnityPlan *plan, const char *name, int file_index, int is_macro) {
+    for (int i = 0; i < plan->rename_count; i++) {
+        UnityRename *existing = &plan->renames[i];
+        if (existing->file_index == file_index && strcmp(existing->name, name) == 0) {
+            existing->is_macro |= is_macro;
+            return 0;
+        }
+    }
+    UnityRename *grown = (UnityRename *)realloc(plan->renames, sizeof(UnityRename) * ((size_t)plan->rename_count + 1));
+    if (!grown) return 1;
+    plan->renames = grown;
+    UnityRename *rename = &plan->renames[plan->rename_count++];
+    snprintf(rename->name, sizeof(rename->name), "%s", name);
+    rename->file_index = file_index;
+    rename->is_macro = is_macro;
+    return 0;
+}
+
+int analyze_unity_safety(const char **src_files, UnityPlan *plan) {
+    memset(plan, 0, sizeof(*plan));
+    int file_count = 0;
+    while (src_files && src_files[file_count] != NULL) file_count++;
+
+    plan->file_count = file_count;
+
+    // 1. Collect the file-local definitions and the member names of every file
+    SymbolTable table = { NULL, 0, 0 };
+    SymbolTable members = { NULL, 0, 0 };
+    if (scan_all_files(src_files, file_count, &table, &members) != 0) {
+        free_unity_plan(plan);
+        return 1;
+    }
+
+    // 2. Find clashing names between files. Symbols are sorted by file within a
+    //    name, so `right` always belongs to the later file, which gets the rename.
+    qsort(table.items, table.count, sizeof(LocalSymbol), compare_symbols);
+    int failed = 0;
+    for (size_t start = 0; start < table.count;) {
+        size_t end = start + 1;
+        while (end < table.count && strcmp(table.items[end].name, table.items[start].name) == 0) end++;
+
+        for (size_t a = start; a < end; a++) {
+            for (size_t b = a + 1; b < end; b++) {
+                const LocalSymbol *left = &table.items[a];
+                const LocalSymbol *right = &table.items[b];
+                if (left->file_index == right->file_index || !symbols_collide(left, right)) continue;
+                plan->collision_count++;
+
+                // Renaming a name that is also a member would rewrite `s.name` as well; the
+                // compiler decides (two uninitialized statics are legal tentative definitions)
+                if (right->kind != SYMBOL_MACRO && is_member_name(&members, right->name, right->file_index + 1)) {
+                    fprintf(stderr, "[WARN] Unity collision: %s '%s' in %s clashes with %s '%s' in %s and cannot be "
+                            "renamed, because it is also used as a struct/union member.\n",
+                            symbol_kind_names[left->kind], left->name, src_files[left->file_index],
+                            symbol_kind_names[right->kind], right->name, src_files[right->file_index]);
+                    plan->unresolved_count++;
+                    continue;
+                }
+                printf("[LOG] Unity collision: %s '%s' in %s clashes with %s '%s' in %s; renaming it in %s.\n",
+                       symbol_kind_names[left->kind], left->name, src_files[left->file_index],
+                       symbol_kind_names[right->kind], right->name, src_files[right->file_index],
+                       src_files[right->file_index]);
+                if (add_rename(plan, right->name, right->file_index, right->kind == SYMBOL_MACRO) != 0) failed = 1;
+            }
+        }
+        start = end;
+    }
+
+    free_symbol_table(&table);
+    free_symbol_table(&members);
+    if (failed) {
+        perror("[ERROR] Failed to allocate memory for unity analysis");
+        free_unity_plan(plan);
+        return 1;
+    }
+    return 0;
+}
+
+// Only headers are repeated: system headers and "*.h" files have include guards,
+// while other quoted files (X-macro tables, *.inc) may be meant to expand twice.
+static int is_guarded_include(const char *p, const char *end) {
+    while (p < end && isspace((unsigned char)*p)) p++;
+    if (p < end && *p == '<') return 1;
+    if (p >= end || *p != '"') return 0;
+    const char *close = memchr(p + 1, '"', (size_t)(end - p - 1));
+    return close && close - p > 2 && strncmp(close - 2, ".h", 2) == 0;
+}
+
+char *list_unconditional_includes(const char *content) {
+    size_t size = 1, len = 0;
+    char *includes = (char *)malloc(size);
+    if (!includes) return NULL;
+    includes[0] = '\0';
+
+    Scanner scanner = { content, 1 };
+    int depth = 0; // nesting of #if/#ifdef/#ifndef blocks
+    for (;;) {
+        Token token = next_token(&scanner);
+        if (token.type == TOKEN_END) break;
+        if (token.type != TOKEN_DIRECTIVE) continue;
+        const char *p = token.directive;
+        const char *end = token.directive + token.directive_len;
+        while (p < end && isspace((unsigned char)*p)) p++;
+        if (strncmp(p, "if", 2) == 0) {
+            depth++;
+        } else if (strncmp(p, "endif", 5) == 0) {
+            if (depth > 0) depth--;
+        } else if (depth == 0 && strncmp(p, "include", 7) == 0 && is_guarded_include(p + 7, end)) {
+            size_t line_len = (size_t)(end - token.directive);
+            char *grown = (char *)realloc(includes, size + line_len + 2);
+            if (!grown) {
+                free(includes);
+                return NULL;
+            }
+            includes = grown;
+            size += line_len + 2;
+            includes[len++] = '#';
+            memcpy(includes + len, token.directive, line_len);
+            len += line_len;
+            includes[len++] = '\n';
+            includes[len] = '\0';
+        }
+    }
+    return includes;
+}
+
+int index_function_definitions(const char **src_files, FunctionDefinition **definitions, int *count) {
+    *definitions = NULL;
+    *count = 0;
+    int file_count = 0;
+    while (src_files && src_files[file_count] != NULL) file_count++;
+
+    SymbolTable table = { NULL, 0, 0 };
+    if (scan_all_files(src_files, file_count, &table, NULL) != 0) {
+        return 1;
+    }
+
+    FunctionDefinition *result = (FunctionDefinition *)calloc(table.count + 1, sizeof(FunctionDefinition));
+    if (!result) {
+        free_symbol_table(&table);
+        return 1;
+    }
+    int found = 0;
+    for (size_t i = 0; i < table.count; i++) {
+        if (table.items[i].kind != SYMBOL_FUNCTION_DEFINITION) continue;
+        snprintf(result[found].name, sizeof(result[found].name), "%s", table.items[i].name);
+        result[found].file_index = table.items[i].file_index;
+        found++;
+    }
+    free_symbol_table(&table);
+    *definitions = result;
+    *count = found;
+    return 0;
+}
+
+void free_unity_plan(UnityPlan *plan) {
+    if (!plan) return;
+    free(plan->renames);
+    memset(plan, 0, sizeof(*plan));
+}
@@ -0,0 +1,83 @@
+#ifndef UNITY_ANALYZER_H
+#define UNITY_ANALYZER_H
+
+// The name a colliding file-local definition gets inside the unity file: "<name>__coda_unity_<file index>"
+#define UNITY_RENAME_MARKER "__coda_unity_"
+
+/**
+ * @struct UnityRename
+ * @brief A name that one source file must not share with the files before it.
+ * Around that file the name is saved with `#pragma push_macro` and #undef'd;
+ * unless the file defines it as a macro, it is also #define'd to the file's own
+ * spelling, so the file's static, typedef, tag or enumerator gets a unique name.
+ */
+typedef struct {
+    char name[128];
+    int file_index;       // the later file of the colliding pair
+    int is_macro;         // the file defines the name as a macro, so it is only hidden, not renamed
+} UnityRename;
+
+/**
+ * @struct UnityPlan
+ * @brief How the source files are made safe to concatenate into one
+ * translation unit: every collision is resolved by renaming the name in the
+ * later of the two files, so later files still see everything the earlier ones
+ * declare. A name that the later file or an earlier one also uses as a
+ * struct/union member is never renamed, since the rename would reach the
+ * member too; such collisions are only reported.
+ */
+typedef struct {
+    int file_count;
+    int collision_count;  // number of colliding (file, file, name) triples found
+    int unresolved_count; // collisions left as they are: the name is also a struct/union member
+    UnityRename *renames;
+    int rename_count;
+} UnityPlan;
+
+/**
+ * @struct FunctionDefinition
+ * @brief A function body found in one of the project's source files.
+ */
+typedef struct {
+    char name[128];
+    int file_index;       // index into the source file list that was scanned
+} FunctionDefinition;
+
+/**
+ * @brief Scans the source files for file-local definitions (static functions and
+ * variables, typedefs, struct/union/enum tags, enumerators and macros), reports
+ * collisions that would break a single unity translation unit and lists the
+ * renames that resolve them (see UnityPlan for the ones it leaves alone).
+ * @param src_files NULL-terminated list of source files, in build order.
+ * @param plan The plan to populate. Free it with free_unity_plan().
+ * @return 0 on success, 1 on failure (e.g. a file could not be read).
+ */
+int analyze_unity_safety(const char **src_files, UnityPlan *plan);
+
+/**
+ * @brief Frees the memory owned by a UnityPlan.
+ * @param plan The plan to free.
+ */
+void free_unity_plan(UnityPlan *plan);
+
+/**
+ * @brief Lists the #include directives of system headers and "*.h" files of a
+ * source file that are not inside an #if block, one per line. The unity file repeats them before a file whose names
+ * are renamed, so headers it includes first are parsed before the renames
+ * apply (their include guards make the file's own #include a no-op).
+ * @param content The source file's content.
+ * @return An allocated string (possibly empty), or NULL on failure. The caller frees it.
+ */
+char *list_unconditional_includes(const char *content);
+
+/**
+ * @brief Lists every function defined in the source files, so that costs
+ * reported against the unity file can be traced back to the original file.
+ * @param src_files NULL-terminated list of source files.
+ * @param definitions Receives an array owned by the caller (free with free()).
+ * @param count Receives the number of entries.
+ * @return 0 on success, 1 on failure.
+ */
+int index_function_definitions(const char **src_files, FunctionDefinition **definitions, int *count);
+
+#endif // UNITY_ANALYZER_H
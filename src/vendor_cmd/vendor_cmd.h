@@ -0,0 +1,31 @@
+#ifndef VENDOR_CMD_H
+#define VENDOR_CMD_H
+
+// Default bundle written by `coda vendor pack` and read by `coda vendor unpack`.
+#define VENDOR_DEFAULT_BUNDLE "coda-vendor.bundle"
+
+/**
+ * @brief Writes every dependency in modules/ (including its .git directory, so the
+ * checked-out commit is kept) into one bundle file: the files are grouped into
+ * independently deflated chunks, followed by an index with the path, mode, size
+ * and SHA-256 of every file and the commit of every dependency.
+ * @param config_path The path to the coda.json file that lists the dependencies.
+ * @param bundle_path The bundle to write.
+ * @return 0 on success, 1 on failure.
+ */
+int vendor_pack(const char *config_path, const char *bundle_path);
+
+/**
+ * @brief Restores modules/ from a bundle. Chunks are inflated by up to `jobs`
+ * worker processes at once, each streaming its files straight to disk and
+ * checking them against the recorded hashes. Dependencies are only moved into
+ * modules/ once every file has been verified.
+ * @param config_path The path to the coda.json file; dependencies it lists that are
+ * missing from the bundle are reported.
+ * @param bundle_path The bundle to read.
+ * @param jobs Maximum number of concurrent workers; 0 for the number of CPUs.
+ * @return 0 on success, 1 on failure.
+ */
+int vendor_unpack(const char *config_path, const char *bundle_path, int jobs);
+
+#endif // VENDOR_CMD_H
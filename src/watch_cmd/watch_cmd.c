@@ -2,86 +2,490 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <sys/inotify.h>
-#include <limits.h>
 #include <errno.h>
 #include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 
 #include "watch_cmd.h"
 #include "build_engine.h"
+#include "fs_monitor.h"
+#include "project_mgr.h"
+#include "hot_reload.h"
+#include "workspace.h"
+#include "process_runner.h"
+#include "build_state.h"
+#include "watch_metrics.h"
+#include "build_isolation.h"
 
-#define EVENT_BUF_LEN (1024 * (sizeof(struct inotify_event) + NAME_MAX + 1))
-static char event_buffer[EVENT_BUF_LEN];
-static int inotify_fd;
-static int watch_descriptor;
+#define WATCH_DIR "src"
+// Bursts of events (editors writing several files, `git checkout`) are coalesced into one build
+#define DEBOUNCE_MS 100
+// How long a cancelled build gets to exit after SIGTERM before it is killed
+#define CANCEL_GRACE_MS 3000
+
+static FsMonitor monitor;
+static const WatchOptions *watch_options;
+static WatchMetrics metrics;
+static char state_build_dir[4096]; // where builds save coda-state.json; "" in workspace mode
+static char hot_library_path[4096 + 32]; // --hot: HOT_LIBRARY_FILE_NAME in the build directory
+
+// Workspace mode (coda-workspace.json in the current directory): one flag per member
+static Workspace workspace;
+static int workspace_mode;
+static unsigned char *pending_members;  // members with changes not yet built
+static unsigned char *building_members; // members selected for the running build
+
+/**
+ * @struct WatchState
+ * @brief Tracks the background build and the changes that arrived meanwhile.
+ */
+typedef struct {
+    pid_t build_pid;          // 0 when no build is running
+    int build_cancelled;      // the running build was told to stop because it is stale
+    int change_pending;       // sources changed since the last build started
+    long long debounce_until; // monotonic ms at which a pending change may start a build
+    pid_t app_pid;            // --run: the running executable; --hot: the hot-reload host; 0 if none
+    long long first_change_ms;  // monotonic ms of the first change no build has picked up yet; 0 if none
+    long long build_trigger_ms; // first change covered by the running build; 0 for the initial build
+    long long build_started_ms; // monotonic ms at which the running build started
+    unsigned long build_serial; // numbers the builds started so far; the running build's id
+} WatchState;
+
+// The id a build saves in its state (BUILD_ID_ENV), unique to this watch process and build
+static void format_build_id(const WatchState *state, char *id, size_t size) {
+    snprintf(id, size, "%ld-%lu", (long)getpid(), state->build_serial);
+}
+
+static long long monotonic_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Runs build_project() in a child process so the event loop keeps
+ * ingesting changes while the compiler runs. The child leads its own process
+ * group, so cancelling it also stops the compilers it started.
+ * @return The child's pid, or -1 on failure.
+ */
+static pid_t start_build(WatchState *state, const char *config_path) {
+    if (workspace_mode) {
+        // Rebuild the changed members and everything that depends on them
+        memcpy(building_members, pending_members, (size_t)workspace.member_count);
+        memset(pending_members, 0, (size_t)workspace.member_count);
+        select_workspace_dependents(&workspace, building_members);
+    }
+    char build_id[64];
+    state->build_serial++;
+    format_build_id(state, build_id, sizeof(build_id));
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("Failed to fork build process");
+        return -1;
+    }
+    if (pid == 0) {
+        setpgid(0, 0);
+        fs_monitor_restore_signal_mask(&monitor);
+        setenv(BUILD_ID_ENV, build_id, 1);
+        int rc;
+        if (workspace_mode) {
+            rc = build_workspace(&workspace, building_members, NULL);
+        } else if (watch_options->hot_reload) {
+            // Hot-reload builds produce a shared object for the host to dlopen()
+            const char *hot_flags[] = { "-shared", "-fPIC", NULL };
+            BuildOptions build_options = { 0 };
+            build_options.output_path = hot_library_path;
+            build_options.extra_compiler_flags = hot_flags;
+            rc = build_project_with_options(config_path, &build_options);
+        } else {
+            rc = build_project(config_path);
+        }
+        fflush(NULL);
+        _exit(rc == 0 ? 0 : 1);
+    }
+    setpgid(pid, pid); // also set from the parent so a cancel can never miss the group
+    if (fs_monitor_track_child(&monitor, pid) != 0) {
+        kill(-pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        return -1;
+    }
+    state->build_trigger_ms = state->first_change_ms;
+    state->first_change_ms = 0;
+    state->build_started_ms = monotonic_ms();
+    metrics.pending_changes = 0;
+    metrics.build_running = 1;
+    watch_metrics_write(&metrics);
+    return pid;
+}
+
+// Records a source change; in workspace mode also marks the member that owns the file
+static void note_change(WatchState *state, const char *path) {
+    long long now = monotonic_ms();
+    state->change_pending = 1;
+    state->debounce_until = now + DEBOUNCE_MS;
+    if (state->first_change_ms == 0) state->first_change_ms = now;
+    metrics.change_events++;
+    metrics.pending_changes++;
+    if (workspace_mode) {
+        int member = find_workspace_member(&workspace, path);
+        if (member >= 0) pending_members[member] = 1;
+    }
+}
+
+static void cancel_build(WatchState *state) {
+    if (state->build_pid > 0 && !state->build_cancelled) {
+        kill(-state->build_pid, SIGTERM);
+        state->build_cancelled = 1;
+    }
+}
+
+/**
+ * @brief Copies the compile timings and cache result of the build that just ended
+ * from its coda-state.json. A state saved by another build (this one failed
+ * before saving one) is ignored.
+ */
+static void read_build_state_metrics(const WatchState *state, WatchBuildSample *sample) {
+    if (state_build_dir[0] == '\0') return;
+    json_t *saved = build_state_load(state_build_dir, 0);
+    if (!saved) return;
+    char build_id[64];
+    format_build_id(state, build_id, sizeof(build_id));
+    const char *saved_id = json_string_value(json_object_get(saved, "build_id"));
+    if (saved_id && strcmp(saved_id, build_id) == 0) {
+        const char *cache = json_string_value(json_object_get(saved, "cache"));
+        if (cache && strcmp(cache, "hit") == 0) sample->cache_result = "hit";
+        if (cache && strcmp(cache, "miss") == 0) sample->cache_result = "miss";
+        json_t *timings = json_object_get(saved, "timings");
+        if (json_is_number(json_object_get(timings, "compile_seconds"))) {
+            sample->compile_seconds = json_number_value(json_object_get(timings, "compile_seconds"));
+        }
+        if (json_is_number(json_object_get(timings, "link_seconds"))) {
+            sample->link_seconds = json_number_value(json_object_get(timings, "link_seconds"));
+        }
+        if (json_is_number(json_object_get(timings, "cpu_stall_seconds"))) {
+            sample->cpu_stall_seconds = json_number_value(json_object_get(timings, "cpu_stall_seconds"));
+            sample->memory_stall_seconds = json_number_value(json_object_get(timings, "memory_stall_seconds"));
+            sample->io_stall_seconds = json_number_value(json_object_get(timings, "io_stall_seconds"));
+        }
+    }
+    json_decref(saved);
+}
+
+// Adds the build that just exited to the metrics and republishes them
+static void record_build_metrics(WatchState *state, const FsEvent *event, int succeeded) {
+    long long now = monotonic_ms();
+    WatchBuildSample sample = { WATCH_BUILD_SUCCEEDED, -1, -1, -1, -1, NULL, -1, -1, -1, -1 };
+    sample.outcome = state->build_cancelled ? WATCH_BUILD_CANCELLED : succeeded ? WATCH_BUILD_SUCCEEDED : WATCH_BUILD_FAILED;
+    // ru_maxrss also covers the compilers the build waited for; Linux reports it in KiB
+    sample.peak_rss_bytes = (long long)event->child_usage.ru_maxrss * 1024;
+    if (state->build_trigger_ms > 0) {
+        sample.debounce_seconds = (double)(state->build_started_ms - state->build_trigger_ms) / 1000.0;
+        if (sample.outcome == WATCH_BUILD_SUCCEEDED) {
+            sample.edit_to_binary_seconds = (double)(now - state->build_trigger_ms) / 1000.0;
+        }
+    }
+    if (sample.outcome == WATCH_BUILD_CANCELLED) {
+        // The changes the cancelled build covered are still waiting, so the next build's latency starts from them
+        if (state->build_trigger_ms > 0 && (state->first_change_ms == 0 || state->build_trigger_ms < state->first_change_ms)) {
+            state->first_change_ms = state->build_trigger_ms;
+        }
+    } else {
+        read_build_state_metrics(state, &sample);
+    }
+    watch_metrics_record_build(&metrics, &sample);
+    metrics.build_running = 0;
+    watch_metrics_write(&metrics);
+}
+
+// Records the exit of whichever tracked child ended. Returns 1 if it was the build.
+static int note_child_exit(WatchState *state, const FsEvent *event) {
+    if (event->child_pid == state->build_pid) {
+        state->build_pid = 0;
+        // Members of a cancelled or failed build are retried with the next one
+        int succeeded = WIFEXITED(event->child_status) && WEXITSTATUS(event->child_status) == 0;
+        for (int i = 0; workspace_mode && !succeeded && i < workspace.member_count; i++) {
+            pending_members[i] |= building_members[i];
+        }
+        record_build_metrics(state, event, succeeded);
+        return 1;
+    }
+    if (event->child_pid == state->app_pid) {
+        state->app_pid = 0;
+        if (WIFEXITED(event->child_status)) {
+            printf("Application exited with status %d.\n", WEXITSTATUS(event->child_status));
+        } else if (WIFSIGNALED(event->child_status) && WTERMSIG(event->child_status) != SIGTERM) {
+            printf("Application was killed by signal %d.\n", WTERMSIG(event->child_status));
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Stops a tracked child (the build's whole process group, or the
+ * application), escalating to SIGKILL if it does not exit within
+ * CANCEL_GRACE_MS. Other events that arrive meanwhile are still recorded.
+ * The child is always reaped through the monitor, which then stops watching
+ * its pidfd; reaping it directly would leave that pidfd readable forever.
+ */
+static void stop_child(WatchState *state, pid_t *pid_slot, int whole_group) {
+    if (*pid_slot <= 0) return;
+    pid_t target = whole_group ? -*pid_slot : *pid_slot;
+    kill(target, SIGTERM);
+    if (pid_slot == &state->build_pid) state->build_cancelled = 1;
+
+    long long deadline = monotonic_ms() + CANCEL_GRACE_MS;
+    int killed = 0;
+    while (*pid_slot > 0) {
+        long long remaining = killed ? -1 : deadline - monotonic_ms();
+        if (!killed && remaining <= 0) {
+            kill(target, SIGKILL);
+            killed = 1;
+            continue; // wait without a timeout for the exit the kill guarantees
+        }
+        FsEvent event;
+        int rc = fs_monitor_next_event(&monitor, (int)remaining, &event);
+        if (rc < 0) break;
+        if (rc == 1 && event.type == FS_EVENT_CHILD_EXIT) {
+            note_child_exit(state, &event);
+        } else if (rc == 1 && event.type == FS_EVENT_CHANGE) {
+            note_change(state, event.path);
+        }
+    }
+}
+
+// Starts a program in a child process tracked by the monitor. Returns its pid, or -1 on failure.
+static pid_t spawn_tracked(char **argv) {
+    ProcessSpec spec = { 0 };
+    spec.argv = argv;
+    pid_t pid = process_spawn(&spec);
+    if (pid > 0 && fs_monitor_track_child(&monitor, pid) != 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        return -1;
+    }
+    return pid;
+}
 
 /**
- * @brief Signal handler to gracefully stop the watch process on Ctrl+C.
+ * @brief After a successful build: restarts the executable (--run), or starts the
+ * hot-reload host / tells it to swap in the new library (--hot).
  */
-static void signal_handler(int signum) {
-    if (signum == SIGINT) {
-        printf("\nReceived SIGINT signal. Stopping watch...\n");
-        if (watch_descriptor > 0) {
-            inotify_rm_watch(inotify_fd, watch_descriptor);
+static void handle_build_success(WatchState *state, const char *config_path) {
+    if (watch_options->hot_reload) {
+        if (state->app_pid > 0) {
+            printf("Reloading %s in the running host...\n", hot_library_path);
+            kill(state->app_pid, SIGUSR1);
+            return;
         }
-        if (inotify_fd > 0) {
-            close(inotify_fd);
+        // The host is Coda itself, re-executed with the hidden 'hot-host' command
+        char *argv[] = { "/proc/self/exe", "hot-host", hot_library_path, NULL };
+        state->app_pid = spawn_tracked(argv);
+        if (state->app_pid < 0) state->app_pid = 0;
+        return;
+    }
+
+    if (!watch_options->run_after_build) return;
+
+    ProjectConfig config;
+    if (parse_config_from_file(config_path, &config) != 0) {
+        return;
+    }
+    if (state->app_pid > 0) {
+        printf("Stopping previous instance of %s...\n", config.output_path);
+        stop_child(state, &state->app_pid, 0);
+    }
+
+    int arg_count = 0;
+    while (watch_options->run_args && watch_options->run_args[arg_count]) arg_count++;
+    char **argv = (char **)calloc((size_t)arg_count + 2, sizeof(char *));
+    if (argv) {
+        // execvp() only searches PATH for bare names, so make relative paths explicit
+        char program[4096];
+        snprintf(program, sizeof(program), "%s%s", strchr(config.output_path, '/') ? "" : "./", config.output_path);
+        argv[0] = program;
+        for (int i = 0; i < arg_count; i++) argv[i + 1] = watch_options->run_args[i];
+        printf("Starting %s...\n", program);
+        state->app_pid = spawn_tracked(argv);
+        if (state->app_pid < 0) state->app_pid = 0;
+        free(argv);
+    }
+    free_config(&config);
+}
+
+/**
+ * @brief Runs the initial build to completion. Changes that arrive meanwhile are
+ * remembered and trigger a rebuild once watching starts.
+ * @return 0 if the build succeeded, 1 if it failed, -1 if a signal asked us to stop.
+ */
+static int run_initial_build(WatchState *state, const char *config_path) {
+    state->build_pid = start_build(state, config_path);
+    if (state->build_pid < 0) return 1;
+
+    while (state->build_pid > 0) {
+        FsEvent event;
+        int rc = fs_monitor_next_event(&monitor, -1, &event);
+        if (rc < 0) return 1;
+        if (event.type == FS_EVENT_CHANGE) {
+            note_change(state, event.path);
+        } else if (event.type == FS_EVENT_SIGNAL) {
+            stop_child(state, &state->build_pid, 1);
+            return -1;
+        } else if (event.type == FS_EVENT_CHILD_EXIT && note_child_exit(state, &event)) {
+            return (WIFEXITED(event.child_status) && WEXITSTATUS(event.child_status) == 0) ? 0 : 1;
         }
-        exit(0);
     }
+    return 1;
 }
 
 /**
- * @brief The main event loop that listens for filesystem events.
+ * @brief The main event loop: one epoll wait multiplexes file changes, build
+ * completion and shutdown signals. A change during a build cancels the stale
+ * build; a new build starts once changes have been quiet for DEBOUNCE_MS.
  */
-static void run_event_loop(const char *dir_to_watch, const char *config_path) {
-    int length, i = 0;
+static void run_event_loop(WatchState *state, const char *dir_to_watch, const char *config_path) {
     printf("Monitoring directory '%s'. Press Ctrl+C to stop.\n", dir_to_watch);
     while (1) {
-        length = read(inotify_fd, event_buffer, EVENT_BUF_LEN);
-        if (length < 0) {
-            perror("Error reading inotify events");
+        int timeout_ms = -1;
+        if (state->change_pending && state->build_pid == 0) {
+            long long remaining = state->debounce_until - monotonic_ms();
+            timeout_ms = remaining > 0 ? (int)remaining : 0;
+        }
+
+        FsEvent event;
+        int rc = fs_monitor_next_event(&monitor, timeout_ms, &event);
+        if (rc < 0) {
             break;
         }
-        i = 0;
-        while (i < length) {
-            struct inotify_event *event = (struct inotify_event *) &event_buffer[i];
-            if (event->mask & (IN_MODIFY | IN_CREATE | IN_DELETE)) {
-                if (strncmp(event->name, ".", 1) == 0) {
-                    i += sizeof(struct inotify_event) + event->len;
-                    continue;
-                }
-                printf("Change detected in '%s'. Initiating build...\n", event->name);
-                if (build_project(config_path) != 0) {
-                    fprintf(stderr, "Build failed. Resuming watch...\n");
-                }
+        if (rc == 0) {
+            // Debounce window elapsed without further changes
+            printf("Initiating build...\n");
+            state->change_pending = 0;
+            state->build_pid = start_build(state, config_path);
+            if (state->build_pid < 0) {
+                state->build_pid = 0;
+                fprintf(stderr, "Build failed. Resuming watch...\n");
             }
-            i += sizeof(struct inotify_event) + event->len;
+            continue;
+        }
+
+        if (event.type == FS_EVENT_CHANGE) {
+            printf("Change detected in '%s'.\n", event.path);
+            note_change(state, event.path);
+            if (state->build_pid > 0 && !state->build_cancelled) {
+                printf("Cancelling stale build...\n");
+                cancel_build(state);
+            }
+        } else if (event.type == FS_EVENT_CHILD_EXIT && note_child_exit(state, &event)) {
+            int succeeded = WIFEXITED(event.child_status) && WEXITSTATUS(event.child_status) == 0;
+            if (state->build_cancelled) {
+                printf("Build cancelled.\n");
+            } else if (succeeded) {
+                printf("Build finished. Resuming watch...\n");
+                handle_build_success(state, config_path);
+            } else {
+                fprintf(stderr, "Build failed. Resuming watch...\n");
+            }
+            state->build_cancelled = 0;
+        } else if (event.type == FS_EVENT_SIGNAL) {
+            printf("\nReceived %s signal. Stopping watch...\n", event.signal_number == SIGINT ? "SIGINT" : "SIGTERM");
+            stop_child(state, &state->build_pid, 1);
+            stop_child(state, &state->app_pid, 0);
+            break;
         }
     }
 }
 
 int watch_project(const char *config_path) {
-    signal(SIGINT, signal_handler);
-    printf("Performing initial build...\n");
-    if (build_project(config_path) != 0) {
-        fprintf(stderr, "Initial build failed. Cannot start watch mode.\n");
+    return watch_project_with_options(config_path, NULL);
+}
+
+/**
+ * @brief Loads coda-workspace.json and watches the source directory of every
+ * member. All members start out pending so the initial build covers them.
+ * @return 0 on success, 1 on failure.
+ */
+static int watch_workspace_members() {
+    if (watch_options->run_after_build || watch_options->hot_reload) {
+        fprintf(stderr, "Error: --run and --hot are not supported at a workspace root; watch a member instead.\n");
         return 1;
     }
-    printf("Initial build completed. Starting watch...\n");
-    inotify_fd = inotify_init();
-    if (inotify_fd < 0) {
-        perror("inotify_init failed");
+    if (load_workspace(WORKSPACE_FILE, &workspace) != 0) {
         return 1;
     }
-    watch_descriptor = inotify_add_watch(inotify_fd, "src", IN_MODIFY | IN_CREATE | IN_DELETE);
-    if (watch_descriptor < 0) {
-        perror("inotify_add_watch failed");
-        close(inotify_fd);
+    workspace_mode = 1;
+    pending_members = (unsigned char *)malloc((size_t)workspace.member_count);
+    building_members = (unsigned char *)calloc((size_t)workspace.member_count, 1);
+    if (!pending_members || !building_members) {
         return 1;
     }
-    run_event_loop("src", config_path);
-    inotify_rm_watch(inotify_fd, watch_descriptor);
-    close(inotify_fd);
+    memset(pending_members, 1, (size_t)workspace.member_count);
+    for (int i = 0; i < workspace.member_count; i++) {
+        char dir[4096];
+        snprintf(dir, sizeof(dir), "%s/%s", workspace.members[i].path, WATCH_DIR);
+        if (fs_monitor_add_directory(&monitor, dir) != 0) {
+            return 1;
+        }
+    }
     return 0;
-}
\ No newline at end of file
+}
+
+static void release_watch_state() {
+    fs_monitor_close(&monitor);
+    if (workspace_mode) {
+        free(pending_members);
+        free(building_members);
+        free_workspace(&workspace);
+        workspace_mode = 0;
+    }
+}
+
+int watch_project_with_options(const char *config_path, const WatchOptions *options) {
+    static const WatchOptions default_options = { 0, 0, NULL, NULL };
+    watch_options = options ? options : &default_options;
+    WatchState state = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    // Start watching before the initial build so no change is missed while it runs
+    if (fs_monitor_init(&monitor) != 0) {
+        return 1;
+    }
+    int watching = access(WORKSPACE_FILE, F_OK) == 0 ? watch_workspace_members()
+                                                     : fs_monitor_add_directory(&monitor, WATCH_DIR);
+    if (watching != 0) {
+        release_watch_state();
+        return 1;
+    }
+    state_build_dir[0] = '\0';
+    ProjectConfig config;
+    if (!workspace_mode && parse_config_from_file(config_path, &config) == 0) {
+        snprintf(state_build_dir, sizeof(state_build_dir), "%s", config.build_dir);
+        // Builds run in forked children that join the isolation cgroup; watch itself steps aside
+        build_isolation_prepare_supervisor(&config.isolation);
+        free_config(&config);
+    }
+    const char *build_dir = state_build_dir[0] != '\0' ? state_build_dir : "build";
+    snprintf(hot_library_path, sizeof(hot_library_path), "%s/%s", build_dir, HOT_LIBRARY_FILE_NAME);
+    char metrics_path[4096 + 32];
+    snprintf(metrics_path, sizeof(metrics_path), "%s/%s", build_dir, WATCH_METRICS_FILE_NAME);
+    watch_metrics_init(&metrics, watch_options->metrics_path ? watch_options->metrics_path : metrics_path);
+    printf("Publishing watch metrics to %s.\n", metrics.path);
+
+    printf("Performing initial build...\n");
+    int initial = run_initial_build(&state, config_path);
+    if (initial != 0) {
+        if (initial > 0) fprintf(stderr, "Initial build failed. Cannot start watch mode.\n");
+        release_watch_state();
+        return initial > 0 ? 1 : 0;
+    }
+    printf("Initial build completed. Starting watch...\n");
+    handle_build_success(&state, config_path);
+
+    run_event_loop(&state, workspace_mode ? "<member>/" WATCH_DIR : WATCH_DIR, config_path);
+    watch_metrics_write(&metrics);
+    watch_metrics_print_summary(&metrics);
+    release_watch_state();
+    return 0;
+}
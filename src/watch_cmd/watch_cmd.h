@@ -1,6 +1,17 @@
 #ifndef WATCH_CMD_H
 #define WATCH_CMD_H
 
+/**
+ * @struct WatchOptions
+ * @brief Command-line switches for `coda watch`.
+ */
+typedef struct {
+    int run_after_build;   // --run: (re)start the built executable after every successful build
+    int hot_reload;        // --hot: build a shared object and swap it into a running host process
+    char **run_args;       // NULL-terminated arguments passed to the executable (after "--"), or NULL
+    const char *metrics_path; // --metrics: Prometheus text file to publish; NULL for WATCH_METRICS_FILE_NAME in the build directory
+} WatchOptions;
+
 /**
  * @brief Starts monitoring the project's source directory for changes and rebuilds automatically.
  * @param config_path The path to the coda.json file.
@@ -8,4 +19,12 @@
  */
 int watch_project(const char *config_path);
 
-#endif // WATCH_CMD_H
\ No newline at end of file
+/**
+ * @brief Like watch_project(), but can also run or hot-reload the result after each build.
+ * @param config_path The path to the coda.json file.
+ * @param options The watch options; NULL means the defaults.
+ * @return 0 on success, 1 on failure.
+ */
+int watch_project_with_options(const char *config_path, const WatchOptions *options);
+
+#endif // WATCH_CMD_H
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "watch_metrics.h"
+#include "core_utils.h"
+
+// Rebuild latencies range from a cache hit (milliseconds) to a cold unity build (minutes)
+static const double LATENCY_BOUNDS[] = { 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 120, 300 };
+static const double DEBOUNCE_BOUNDS[] = { 0.1, 0.15, 0.25, 0.5, 1, 2.5, 5, 10, 30 };
+static const double RSS_BOUNDS[] = { 64e6, 128e6, 256e6, 512e6, 1e9, 2e9, 4e9, 8e9, 16e9 };
+
+#define BOUND_COUNT(bounds) ((int)(sizeof(bounds) / sizeof((bounds)[0])))
+
+static const char *OUTCOME_LABELS[WATCH_BUILD_OUTCOME_COUNT] = { "succeeded", "failed", "cancelled" };
+static const char *STALL_LABELS[3] = { "cpu", "memory", "io" };
+
+static void init_histogram(MetricHistogram *histogram, const char *name, const char *help,
+                           const double *bounds, int bound_count) {
+    memset(histogram, 0, sizeof(*histogram));
+    histogram->name = name;
+    histogram->help = help;
+    histogram->bounds = bounds;
+    histogram->bound_count = bound_count;
+}
+
+void watch_metrics_init(WatchMetrics *metrics, const char *path) {
+    memset(metrics, 0, sizeof(*metrics));
+    snprintf(metrics->path, sizeof(metrics->path), "%s", path);
+    init_histogram(&metrics->edit_to_binary, "coda_watch_edit_to_binary_seconds",
+                   "Time from the first source change of a batch until the rebuilt binary was ready.",
+                   LATENCY_BOUNDS, BOUND_COUNT(LATENCY_BOUNDS));
+    init_histogram(&metrics->debounce_delay, "coda_watch_debounce_delay_seconds",
+                   "Time from the first source change of a batch until its build started.",
+                   DEBOUNCE_BOUNDS, BOUND_COUNT(DEBOUNCE_BOUNDS));
+    init_histogram(&metrics->compile_time, "coda_watch_compile_seconds",
+                   "Time spent running the compiler (including the link for single unity builds).",
+                   LATENCY_BOUNDS, BOUND_COUNT(LATENCY_BOUNDS));
+    init_histogram(&metrics->link_time, "coda_watch_link_seconds",
+                   "Time spent linking when the link runs on its own (profiled builds).",
+                   LATENCY_BOUNDS, BOUND_COUNT(LATENCY_BOUNDS));
+    init_histogram(&metrics->peak_rss, "coda_watch_build_peak_rss_bytes",
+                   "Largest resident set size of a build or any compiler it ran.",
+                   RSS_BOUNDS, BOUND_COUNT(RSS_BOUNDS));
+}
+
+void metric_histogram_observe(MetricHistogram *histogram, double value) {
+    int bucket = 0;
+    while (bucket < histogram->bound_count && value > histogram->bounds[bucket]) bucket++;
+    histogram->counts[bucket]++;
+    histogram->count++;
+    histogram->sum += value;
+}
+
+double metric_histogram_quantile(const MetricHistogram *histogram, double quantile) {
+    if (histogram->count == 0) return -1;
+    double rank = quantile * (double)histogram->count;
+    unsigned long long below = 0;
+    for (int i = 0; i < histogram->bound_count; i++) {
+        if ((double)(below + histogram->counts[i]) >= rank && histogram->counts[i] > 0) {
+            double lower = i > 0 ? histogram->bounds[i - 1] : 0.0;
+            double upper = histogram->bounds[i];
+            return lower + (upper - lower) * (rank - (double)below) / (double)histogram->counts[i];
+        }
+        below += histogram->counts[i];
+    }
+    // The quantile lies in the +Inf bucket; like Prometheus, report the highest finite bound
+    return histogram->bounds[histogram->bound_count - 1];
+}
+
+void watch_metrics_record_build(WatchMetrics *metrics, const WatchBuildSample *sample) {
+    metrics->builds[sample->outcome]++;
+    metrics->last_build_finished = time(NULL);
+    if (sample->edit_to_binary_seconds >= 0) metric_histogram_observe(&metrics->edit_to_binary, sample->edit_to_binary_seconds);
+    if (sample->debounce_seconds >= 0) metric_histogram_observe(&metrics->debounce_delay, sample->debounce_seconds);
+    if (sample->compile_seconds >= 0) metric_histogram_observe(&metrics->compile_time, sample->compile_seconds);
+    if (sample->link_seconds >= 0) metric_histogram_observe(&metrics->link_time, sample->link_seconds);
+    if (sample->peak_rss_bytes >= 0) metric_histogram_observe(&metrics->peak_rss, (double)sample->peak_rss_bytes);
+    if (sample->cpu_stall_seconds >= 0) {
+        metrics->stall_seconds[0] += sample->cpu_stall_seconds;
+        metrics->stall_seconds[1] += sample->memory_stall_seconds;
+        metrics->stall_seconds[2] += sample->io_stall_seconds;
+    }
+    if (sample->cache_result && strcmp(sample->cache_result, "hit") == 0) {
+        metrics->cache_hits++;
+    } else if (sample->cache_result && strcmp(sample->cache_result, "miss") == 0) {
+        metrics->cache_misses++;
+    }
+}
+
+static void write_histogram(FILE *out, const MetricHistogram *histogram) {
+    fprintf(out, "# HELP %s %s\n# TYPE %s histogram\n", histogram->name, histogram->help, histogram->name);
+    unsigned long long cumulative = 0;
+    for (int i = 0; i < histogram->bound_count; i++) {
+        cumulative += histogram->counts[i];
+        fprintf(out, "%s_bucket{le=\"%g\"} %llu\n", histogram->name, histogram->bounds[i], cumulative);
+    }
+    fprintf(out, "%s_bucket{le=\"+Inf\"} %llu\n", histogram->name, histogram->count);
+    fprintf(out, "%s_sum %.6f\n%s_count %llu\n", histogram->name, histogram->sum, histogram->name, histogram->count);
+}
+
+int watch_metrics_write(const WatchMetrics *metrics) {
+    // 1. Make sure the directory exists (build/ may not have been created yet)
+    char dir[4096];
+    snprintf(dir, sizeof(dir), "%s", metrics->path);
+    char *slash = strrchr(dir, '/');
+    if (slash && slash != dir) {
+        *slash = '\0';
+        if (ensure_directory(dir) != 0) return 1;
+    }
+
+    // 2. Write everything to a temporary file next to the target
+    char temp_path[4096 + 32];
+    snprintf(temp_path, sizeof(temp_path), "%s.%d.tmp", metrics->path, (int)getpid());
+    FILE *out = fopen(temp_path, "w");
+    if (!out) {
+        fprintf(stderr, "[WARN] Failed to write watch metrics to %s.\n", metrics->path);
+        return 1;
+    }
+
+    fprintf(out, "# HELP coda_watch_builds_total Builds run by coda watch, by outcome.\n"
+                 "# TYPE coda_watch_builds_total counter\n");
+    for (int i = 0; i < WATCH_BUILD_OUTCOME_COUNT; i++) {
+        fprintf(out, "coda_watch_builds_total{outcome=\"%s\"} %llu\n", OUTCOME_LABELS[i], metrics->builds[i]);
+    }
+    fprintf(out, "# HELP coda_watch_cache_lookups_total Artifact cache lookups by result.\n"
+                 "# TYPE coda_watch_cache_lookups_total counter\n"
+                 "coda_watch_cache_lookups_total{result=\"hit\"} %llu\n"
+                 "coda_watch_cache_lookups_total{result=\"miss\"} %llu\n",
+            metrics->cache_hits, metrics->cache_misses);
+    fprintf(out, "# HELP coda_watch_change_events_total Source change events seen.\n"
+                 "# TYPE coda_watch_change_events_total counter\n"
+                 "coda_watch_change_events_total %llu\n", metrics->change_events);
+    fprintf(out, "# HELP coda_watch_build_stall_seconds_total Time build isolation held compiles back, by resource.\n"
+                 "# TYPE coda_watch_build_stall_seconds_total counter\n");
+    for (int i = 0; i < 3; i++) {
+        fprintf(out, "coda_watch_build_stall_seconds_total{resource=\"%s\"} %.6f\n", STALL_LABELS[i],
+                metrics->stall_seconds[i]);
+    }
+    fprintf(out, "# HELP coda_watch_pending_changes Source changes waiting for a build.\n"
+                 "# TYPE coda_watch_pending_changes gauge\n"
+                 "coda_watch_pending_changes %d\n", metrics->pending_changes);
+    fprintf(out, "# HELP coda_watch_build_running Whether a build is running.\n"
+                 "# TYPE coda_watch_build_running gauge\n"
+                 "coda_watch_build_running %d\n", metrics->build_running);
+    fprintf(out, "# HELP coda_watch_last_build_timestamp_seconds When the last build finished.\n"
+                 "# TYPE coda_watch_last_build_timestamp_seconds gauge\n"
+                 "coda_watch_last_build_timestamp_seconds %lld\n", (long long)metrics->last_build_finished);
+    write_histogram(out, &metrics->edit_to_binary);
+    write_histogram(out, &metrics->debounce_delay);
+    write_histogram(out, &metrics->compile_time);
+    write_histogram(out, &metrics->link_time);
+    write_histogram(out, &metrics->peak_rss);
+
+    // 3. Publish it with a rename so scrapers only ever see a complete file
+    int failed = ferror(out);
+    if (fclose(out) != 0) failed = 1;
+    if (failed || rename(temp_path, metrics->path) != 0) {
+        unlink(temp_path);
+        fprintf(stderr, "[WARN] Failed to write watch metrics to %s.\n", metrics->path);
+        return 1;
+    }
+    return 0;
+}
+
+void watch_metrics_print_summary(const WatchMetrics *metrics) {
+    unsigned long long total = 0;
+    for (int i = 0; i < WATCH_BUILD_OUTCOME_COUNT; i++) total += metrics->builds[i];
+    printf("Watch metrics: %llu build(s) (%llu succeeded, %llu failed, %llu cancelled).\n", total,
+           metrics->builds[WATCH_BUILD_SUCCEEDED], metrics->builds[WATCH_BUILD_FAILED],
+           metrics->builds[WATCH_BUILD_CANCELLED]);
+    if (metrics->edit_to_binary.count > 0) {
+        printf("  Edit-to-binary latency: p50 %.2fs, p99 %.2fs over %llu rebuild(s).\n",
+               metric_histogram_quantile(&metrics->edit_to_binary, 0.5),
+               metric_histogram_quantile(&metrics->edit_to_binary, 0.99), metrics->edit_to_binary.count);
+    }
+    unsigned long long lookups = metrics->cache_hits + metrics->cache_misses;
+    if (lookups > 0) {
+        printf("  Cache hit rate: %.0f%% (%llu of %llu).\n", 100.0 * (double)metrics->cache_hits / (double)lookups,
+               metrics->cache_hits, lookups);
+    }
+    printf("  Prometheus metrics: %s\n", metrics->path);
+}
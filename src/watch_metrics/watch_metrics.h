@@ -0,0 +1,119 @@
+#ifndef WATCH_METRICS_H
+#define WATCH_METRICS_H
+
+#include <time.h>
+
+// Where `coda watch` publishes its metrics inside the project's build directory
+// (build/ at a workspace root) unless --metrics names another file
+#define WATCH_METRICS_FILE_NAME "watch-metrics.prom"
+#define METRIC_MAX_BUCKETS 16
+
+/**
+ * @struct MetricHistogram
+ * @brief A fixed-bucket histogram in the Prometheus sense: observations are
+ * counted per upper bound, so memory stays constant however long watch runs.
+ */
+typedef struct {
+    const char *name;                                // e.g. "coda_watch_compile_seconds"
+    const char *help;
+    const double *bounds;                            // ascending upper bounds, excluding +Inf
+    int bound_count;
+    unsigned long long counts[METRIC_MAX_BUCKETS + 1]; // per bucket (not cumulative); the last is +Inf
+    unsigned long long count;
+    double sum;
+} MetricHistogram;
+
+/**
+ * @brief How a build started by `coda watch` ended.
+ */
+typedef enum {
+    WATCH_BUILD_SUCCEEDED,
+    WATCH_BUILD_FAILED,
+    WATCH_BUILD_CANCELLED,
+    WATCH_BUILD_OUTCOME_COUNT
+} WatchBuildOutcome;
+
+/**
+ * @struct WatchBuildSample
+ * @brief What was measured for one build. Negative values mean "not measured".
+ */
+typedef struct {
+    WatchBuildOutcome outcome;
+    double edit_to_binary_seconds; // first change of the batch until the build succeeded
+    double debounce_seconds;       // first change of the batch until the build started
+    double compile_seconds;
+    double link_seconds;           // only when the link ran on its own (profiled builds)
+    const char *cache_result;      // "hit", "miss", or NULL when the cache was not consulted
+    long long peak_rss_bytes;      // largest resident set of the build or any compiler it ran
+    double cpu_stall_seconds;      // time build isolation held the compile back (see BuildTimings)
+    double memory_stall_seconds;
+    double io_stall_seconds;
+} WatchBuildSample;
+
+/**
+ * @struct WatchMetrics
+ * @brief Everything `coda watch` has measured since it started.
+ */
+typedef struct {
+    char path[4096];
+    MetricHistogram edit_to_binary;
+    MetricHistogram debounce_delay;
+    MetricHistogram compile_time;
+    MetricHistogram link_time;
+    MetricHistogram peak_rss;
+    unsigned long long builds[WATCH_BUILD_OUTCOME_COUNT];
+    unsigned long long cache_hits;
+    unsigned long long cache_misses;
+    unsigned long long change_events;
+    double stall_seconds[3];  // CPU, memory and I/O throttling of isolated builds
+    int pending_changes;     // changes waiting for a build (the build queue depth)
+    int build_running;
+    time_t last_build_finished;
+} WatchMetrics;
+
+/**
+ * @brief Prepares empty histograms and counters.
+ * @param metrics The metrics to initialize.
+ * @param path The Prometheus text file written by watch_metrics_write().
+ */
+void watch_metrics_init(WatchMetrics *metrics, const char *path);
+
+/**
+ * @brief Adds one observation to a histogram.
+ * @param histogram The histogram.
+ * @param value The observed value.
+ */
+void metric_histogram_observe(MetricHistogram *histogram, double value);
+
+/**
+ * @brief Estimates a quantile the way Prometheus' histogram_quantile() does,
+ * interpolating linearly inside the bucket that holds it.
+ * @param histogram The histogram.
+ * @param quantile The quantile, between 0 and 1 (e.g. 0.99 for p99).
+ * @return The estimate, or -1 if nothing was observed.
+ */
+double metric_histogram_quantile(const MetricHistogram *histogram, double quantile);
+
+/**
+ * @brief Adds a finished build to the metrics.
+ * @param metrics The metrics.
+ * @param sample The build's measurements.
+ */
+void watch_metrics_record_build(WatchMetrics *metrics, const WatchBuildSample *sample);
+
+/**
+ * @brief Writes the metrics in the Prometheus text exposition format, replacing
+ * the file atomically so a scraper (e.g. node_exporter's textfile collector)
+ * never reads a partial file.
+ * @param metrics The metrics.
+ * @return 0 on success, 1 on failure.
+ */
+int watch_metrics_write(const WatchMetrics *metrics);
+
+/**
+ * @brief Prints the build count, p50/p99 edit-to-binary latency and the cache hit rate.
+ * @param metrics The metrics.
+ */
+void watch_metrics_print_summary(const WatchMetrics *metrics);
+
+#endif // WATCH_METRICS_H
@@ -0,0 +1,406 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <jansson.h>
+
+#include "workspace.h"
+#include "core_utils.h"
+#include "process_runner.h"
+
+// Shared by all members, relative to the workspace root
+#define SHARED_CACHE_DIR "build/cache"
+#define SHARED_MODULES_DIR "modules"
+#define MEMBER_LOG_DIR "build/workspace"
+
+typedef enum {
+    MEMBER_WAITING,
+    MEMBER_RUNNING,
+    MEMBER_BUILT,
+    MEMBER_FAILED,
+    MEMBER_SKIPPED
+} MemberStatus;
+
+// Strips "./" prefixes and trailing slashes so "./libs/core/" and "libs/core" compare equal
+static char *normalize_member_path(const char *path) {
+    while (strncmp(path, "./", 2) == 0) path += 2;
+    char *normalized = strdup(path);
+    if (!normalized) return NULL;
+    size_t len = strlen(normalized);
+    while (len > 1 && normalized[len - 1] == '/') normalized[--len] = '\0';
+    return normalized;
+}
+
+static int find_member_by_reference(const Workspace *workspace, const char *reference) {
+    char *path = normalize_member_path(reference);
+    int found = -1;
+    for (int i = 0; path && i < workspace->member_count && found < 0; i++) {
+        if (strcmp(workspace->members[i].name, reference) == 0 || strcmp(workspace->members[i].path, path) == 0) {
+            found = i;
+        }
+    }
+    free(path);
+    return found;
+}
+
+// Kahn's algorithm: if some members never become ready, they sit on a cycle
+static int check_for_cycles(const Workspace *workspace) {
+    int count = workspace->member_count;
+    int *remaining = (int *)calloc((size_t)count, sizeof(int));
+    if (!remaining) return 1;
+    for (int i = 0; i < count; i++) remaining[i] = workspace->members[i].dependency_count;
+
+    int resolved = 0, progress = 1;
+    unsigned char *done = (unsigned char *)calloc((size_t)count, 1);
+    while (done && progress) {
+        progress = 0;
+        for (int i = 0; i < count; i++) {
+            if (done[i] || remaining[i] > 0) continue;
+            done[i] = 1;
+            resolved++;
+            progress = 1;
+            for (int j = 0; j < count; j++) {
+                for (int d = 0; d < workspace->members[j].dependency_count; d++) {
+                    if (workspace->members[j].dependencies[d] == i) remaining[j]--;
+                }
+            }
+        }
+    }
+    if (done && resolved < count) {
+        fprintf(stderr, "Error: Dependency cycle between workspace members:");
+        for (int i = 0; i < count; i++) {
+            if (!done[i]) fprintf(stderr, " %s", workspace->members[i].name);
+        }
+        fprintf(stderr, "\n");
+    }
+    int rc = (!done || resolved < count) ? 1 : 0;
+    free(done);
+    free(remaining);
+    return rc;
+}
+
+/**
+ * @brief Reads one member's coda.json for its name and its "depends_on" list.
+ * Dependencies are resolved once every member is known.
+ * @return The raw "depends_on" array (a new reference), or NULL on failure.
+ */
+static json_t *load_member(WorkspaceMember *member, const char *member_path) {
+    char config_path[4096];
+    snprintf(config_path, sizeof(config_path), "%s/coda.json", member_path);
+    json_error_t error;
+    json_t *root = json_load_file(config_path, 0, &error);
+    if (!root) {
+        fprintf(stderr, "Error: Workspace member '%s' has no readable coda.json (%s).\n", member_path, error.text);
+        return NULL;
+    }
+    member->path = normalize_member_path(member_path);
+    const char *name = json_string_value(json_object_get(root, "project_name"));
+    member->name = strdup(name ? name : member->path);
+
+    json_t *depends_on = json_object_get(root, "depends_on");
+    json_t *result = json_is_array(depends_on) ? json_incref(depends_on) : json_array();
+    json_decref(root);
+    return result;
+}
+
+int load_workspace(const char *path, Workspace *workspace) {
+    memset(workspace, 0, sizeof(*workspace));
+    json_error_t error;
+    json_t *root = json_load_file(path, 0, &error);
+    if (!root) {
+        fprintf(stderr, "Error parsing JSON file '%s': on line %d: %s\n", path, error.line, error.text);
+        return 1;
+    }
+    json_t *members_json = json_object_get(root, "members");
+    if (!json_is_array(members_json) || json_array_size(members_json) == 0) {
+        fprintf(stderr, "Error: '%s' must list its member directories in \"members\".\n", path);
+        json_decref(root);
+        return 1;
+    }
+
+    char root_dir[PATH_MAX];
+    if (!realpath(".", root_dir)) {
+        perror("Failed to resolve the workspace root");
+        json_decref(root);
+        return 1;
+    }
+    workspace->root = strdup(root_dir);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    json_t *jobs_json = json_object_get(root, "jobs");
+    workspace->jobs = json_is_integer(jobs_json) ? (int)json_integer_value(jobs_json) : (cpus > 0 ? (int)cpus : 1);
+    if (workspace->jobs < 1) workspace->jobs = 1;
+
+    size_t count = json_array_size(members_json);
+    workspace->members = (WorkspaceMember *)calloc(count, sizeof(WorkspaceMember));
+    json_t **depends_on = (json_t **)calloc(count, sizeof(json_t *));
+    int failed = !workspace->root || !workspace->members || !depends_on;
+    for (size_t i = 0; i < count && !failed; i++) {
+        const char *member_path = json_string_value(json_array_get(members_json, i));
+        if (!member_path) {
+            fprintf(stderr, "Error: Entry %zu of \"members\" must be a directory path.\n", i);
+            failed = 1;
+            break;
+        }
+        workspace->member_count++;
+        depends_on[i] = load_member(&workspace->members[i], member_path);
+        if (!depends_on[i] || !workspace->members[i].path || !workspace->members[i].name) failed = 1;
+    }
+
+    // Resolve "depends_on" now that every member's name is known
+    for (int i = 0; i < workspace->member_count && !failed; i++) {
+        WorkspaceMember *member = &workspace->members[i];
+        size_t dependency_count = json_array_size(depends_on[i]);
+        member->dependencies = (int *)calloc(dependency_count + 1, sizeof(int));
+        if (!member->dependencies) {
+            failed = 1;
+            break;
+        }
+        for (size_t d = 0; d < dependency_count; d++) {
+            const char *reference = json_string_value(json_array_get(depends_on[i], d));
+            int index = reference ? find_member_by_reference(workspace, reference) : -1;
+            if (index < 0) {
+                fprintf(stderr, "Error: '%s' depends on '%s', which is not a workspace member.\n",
+                        member->name, reference ? reference : "(not a string)");
+                failed = 1;
+                break;
+            }
+            member->dependencies[member->dependency_count++] = index;
+        }
+    }
+    if (!failed) failed = check_for_cycles(workspace);
+
+    for (size_t i = 0; depends_on && i < count; i++) json_decref(depends_on[i]);
+    free(depends_on);
+    json_decref(root);
+    if (failed) {
+        free_workspace(workspace);
+        return 1;
+    }
+    return 0;
+}
+
+void free_workspace(Workspace *workspace) {
+    for (int i = 0; workspace->members && i < workspace->member_count; i++) {
+        free(workspace->members[i].name);
+        free(workspace->members[i].path);
+        free(workspace->members[i].dependencies);
+    }
+    free(workspace->members);
+    free(workspace->root);
+    memset(workspace, 0, sizeof(*workspace));
+}
+
+/**
+ * @brief Points CODA_CACHE_DIR at the workspace cache (unless the caller chose
+ * one) and gives each member without its own modules/ directory a symlink to
+ * the shared module store, so include paths like "modules/x/include" keep working.
+ */
+static int prepare_shared_stores(const Workspace *workspace, const unsigned char *selected) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", workspace->root, SHARED_CACHE_DIR);
+    if (ensure_directory(path) != 0) return 1;
+    setenv("CODA_CACHE_DIR", path, 0);
+
+    char modules_dir[PATH_MAX];
+    snprintf(modules_dir, sizeof(modules_dir), "%s/%s", workspace->root, SHARED_MODULES_DIR);
+    snprintf(path, sizeof(path), "%s/%s", workspace->root, MEMBER_LOG_DIR);
+    if (ensure_directory(modules_dir) != 0 || ensure_directory(path) != 0) return 1;
+
+    for (int i = 0; i < workspace->member_count; i++) {
+        if (selected && !selected[i]) continue;
+        char link_path[PATH_MAX + 16];
+        snprintf(link_path, sizeof(link_path), "%s/%s/%s", workspace->root, workspace->members[i].path, SHARED_MODULES_DIR);
+        if (access(link_path, F_OK) == 0 || strcmp(workspace->members[i].path, ".") == 0) continue;
+        if (symlink(modules_dir, link_path) != 0 && errno != EEXIST) {
+            fprintf(stderr, "[WARN] Could not link %s to the shared module store: %s\n", link_path, strerror(errno));
+        }
+    }
+    return 0;
+}
+
+// Builds one member in a child process, inside the member's directory, logging to build/workspace/<name>.log
+static pid_t start_member_build(const Workspace *workspace, const WorkspaceMember *member, const BuildOptions *options,
+                                const char *log_path) {
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("Failed to fork member build");
+        return -1;
+    }
+    if (pid == 0) {
+        char member_dir[PATH_MAX];
+        snprintf(member_dir, sizeof(member_dir), "%s/%s", workspace->root, member->path);
+        int fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+            setvbuf(stdout, NULL, _IOLBF, 0); // keep stdout and stderr interleaved in the log
+        }
+        if (chdir(member_dir) != 0) {
+            perror("Failed to enter member directory");
+            _exit(1);
+        }
+        int rc = build_project_with_options("coda.json", options);
+        fflush(NULL);
+        _exit(rc == 0 ? 0 : 1);
+    }
+    return pid;
+}
+
+static double seconds_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Copies a failed member's log to stderr so the error is visible without opening the file
+static void print_member_log(const char *log_path) {
+    char *log = read_file_to_string(log_path);
+    if (!log) return;
+    fprintf(stderr, "%s", log);
+    free(log);
+}
+
+int build_workspace(const Workspace *workspace, const unsigned char *selected, const BuildOptions *options) {
+    int count = workspace->member_count;
+    MemberStatus *status = (MemberStatus *)calloc((size_t)count, sizeof(MemberStatus));
+    int *member_of_job = (int *)calloc((size_t)count, sizeof(int));
+    struct timespec *started = (struct timespec *)calloc((size_t)count, sizeof(struct timespec));
+    if (!status || !member_of_job || !started || prepare_shared_stores(workspace, selected) != 0) {
+        fprintf(stderr, "[ERROR] Failed to prepare the workspace build.\n");
+        free(status);
+        free(member_of_job);
+        free(started);
+        return 1;
+    }
+
+    int pending = 0;
+    for (int i = 0; i < count; i++) {
+        // Unselected members count as already built
+        status[i] = (selected && !selected[i]) ? MEMBER_BUILT : MEMBER_WAITING;
+        if (status[i] == MEMBER_WAITING) pending++;
+    }
+    printf("[LOG] Building %d workspace member(s) with up to %d parallel job(s).\n", pending, workspace->jobs);
+
+    struct timespec workspace_start;
+    clock_gettime(CLOCK_MONOTONIC, &workspace_start);
+    ProcessRunner runner;
+    process_runner_init(&runner);
+    int running = 0, built = 0, failed = 0, skipped = 0;
+    while (pending > 0 || running > 0) {
+        // 1. Start every member whose dependencies are done, up to the job limit
+        int settled = 0;
+        for (int i = 0; i < count && running < workspace->jobs; i++) {
+            if (status[i] != MEMBER_WAITING) continue;
+            const WorkspaceMember *member = &workspace->members[i];
+            int ready = 1, blocked = 0;
+            for (int d = 0; d < member->dependency_count; d++) {
+                MemberStatus dependency = status[member->dependencies[d]];
+                if (dependency == MEMBER_FAILED || dependency == MEMBER_SKIPPED) blocked = 1;
+                else if (dependency != MEMBER_BUILT) ready = 0;
+            }
+            if (blocked) {
+                fprintf(stderr, "[WARN] [%s] Skipped because a dependency failed.\n", member->name);
+                status[i] = MEMBER_SKIPPED;
+                pending--;
+                skipped++;
+                settled++;
+                i = -1; // a skip may cascade to members scanned earlier; rescan
+                continue;
+            }
+            if (!ready) continue;
+
+            char log_path[PATH_MAX];
+            snprintf(log_path, sizeof(log_path), "%s/%s/%s.log", workspace->root, MEMBER_LOG_DIR, member->name);
+            printf("[LOG] [%s] Building...\n", member->name);
+            clock_gettime(CLOCK_MONOTONIC, &started[i]);
+            pid_t pid = start_member_build(workspace, member, options, log_path);
+            int job = pid > 0 ? process_runner_adopt(&runner, pid, 0) : -1;
+            pending--;
+            settled++;
+            if (job < 0) {
+                status[i] = MEMBER_FAILED;
+                failed++;
+                continue;
+            }
+            member_of_job[job] = i;
+            status[i] = MEMBER_RUNNING;
+            running++;
+        }
+        if (running == 0) {
+            if (pending > 0 && settled > 0) continue;
+            break;
+        }
+
+        // 2. Wait for any member build to finish
+        int job = process_runner_wait_any(&runner);
+        if (job < 0) break;
+        running--;
+        int i = member_of_job[job];
+        if (process_job_succeeded(&runner.jobs[job])) {
+            status[i] = MEMBER_BUILT;
+            built++;
+            printf("[LOG] [%s] Built in %.2fs.\n", workspace->members[i].name, seconds_since(&started[i]));
+        } else {
+            char log_path[PATH_MAX];
+            snprintf(log_path, sizeof(log_path), "%s/%s/%s.log", workspace->root, MEMBER_LOG_DIR, workspace->members[i].name);
+            status[i] = MEMBER_FAILED;
+            failed++;
+            fprintf(stderr, "[ERROR] [%s] Build failed (log: %s):\n", workspace->members[i].name, log_path);
+            print_member_log(log_path);
+        }
+    }
+    process_runner_free(&runner);
+
+    printf("Workspace build finished in %.2fs: %d built, %d failed, %d skipped.\n",
+           seconds_since(&workspace_start), built, failed, skipped);
+    free(status);
+    free(member_of_job);
+    free(started);
+    return (failed > 0 || skipped > 0) ? 1 : 0;
+}
+
+void select_workspace_dependents(const Workspace *workspace, unsigned char *selected) {
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < workspace->member_count; i++) {
+            if (selected[i]) continue;
+            const WorkspaceMember *member = &workspace->members[i];
+            for (int d = 0; d < member->dependency_count; d++) {
+                if (selected[member->dependencies[d]]) {
+                    selected[i] = 1;
+                    changed = 1;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+int find_workspace_member(const Workspace *workspace, const char *path) {
+    while (strncmp(path, "./", 2) == 0) path += 2;
+    int best = -1;
+    size_t best_len = 0;
+    for (int i = 0; i < workspace->member_count; i++) {
+        const char *member_path = workspace->members[i].path;
+        size_t len = strlen(member_path);
+        if (strcmp(member_path, ".") == 0) {
+            if (best < 0) best = i; // a member at the root contains everything not claimed by another one
+            continue;
+        }
+        // The longest matching directory wins for nested members
+        if (strncmp(path, member_path, len) == 0 && (path[len] == '/' || path[len] == '\0') && len > best_len) {
+            best = i;
+            best_len = len;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,71 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include "build_engine.h"
+
+// Lives in the repository root next to the member directories
+#define WORKSPACE_FILE "coda-workspace.json"
+
+/**
+ * @struct WorkspaceMember
+ * @brief One Coda project inside a workspace.
+ */
+typedef struct {
+    char *name;               // "project_name" from the member's coda.json
+    char *path;               // the member directory, relative to the workspace root
+    int *dependencies;        // indices of the members this one depends on ("depends_on")
+    int dependency_count;
+} WorkspaceMember;
+
+/**
+ * @struct Workspace
+ * @brief The members of a workspace and the DAG between them.
+ */
+typedef struct {
+    char *root;               // absolute path of the workspace root
+    WorkspaceMember *members;
+    int member_count;
+    int jobs;                 // maximum number of member builds running at once
+} Workspace;
+
+/**
+ * @brief Loads coda-workspace.json and each member's coda.json, resolves
+ * "depends_on" entries (member names or paths) and rejects dependency cycles.
+ * @param path The path to coda-workspace.json.
+ * @param workspace Receives the workspace; release with free_workspace().
+ * @return 0 on success, 1 on failure.
+ */
+int load_workspace(const char *path, Workspace *workspace);
+
+/**
+ * @brief Frees all memory owned by a workspace.
+ */
+void free_workspace(Workspace *workspace);
+
+/**
+ * @brief Builds members as one DAG: a member starts once all of its selected
+ * dependencies have been built, with up to workspace->jobs builds at a time.
+ * Members share the workspace's compile cache and module store. Members whose
+ * dependencies failed are skipped; unrelated members still build.
+ * @param workspace The workspace.
+ * @param selected One flag per member, or NULL to build every member. Dependencies
+ * that are not selected are assumed to be up to date.
+ * @param options Build options applied to every member; NULL means the defaults.
+ * @return 0 if every selected member built, 1 otherwise.
+ */
+int build_workspace(const Workspace *workspace, const unsigned char *selected, const BuildOptions *options);
+
+/**
+ * @brief Adds every member that depends, directly or transitively, on a selected member.
+ * @param workspace The workspace.
+ * @param selected One flag per member; updated in place.
+ */
+void select_workspace_dependents(const Workspace *workspace, unsigned char *selected);
+
+/**
+ * @brief Finds the member that contains a path (relative to the workspace root).
+ * @return The member index, or -1 if the path is outside every member.
+ */
+int find_workspace_member(const Workspace *workspace, const char *path);
+
+#endif // WORKSPACE_H